@@ -0,0 +1,35 @@
+#!/bin/bash
+#usage: bench.sh EXECUTABLE CORPUS_DIR LARGE_SIZE
+#builds any missing corpora then prints the editor's JSON timings
+executable=$1
+corpus=$2
+large=$3
+
+mkdir -p $corpus
+line="2026-01-01 00:00:00 INFO worker=3 request handled in 12ms path=/api/v1/items/42"
+
+#many short lines
+if [[ ! -f $corpus/short.txt ]]
+then
+	echo -e "\t\tGenerating short line corpus..." >&2
+	yes "$line" | head -c 67108864 > $corpus/short.txt
+fi
+#a few lines of several megabytes
+if [[ ! -f $corpus/long.txt ]]
+then
+	echo -e "\t\tGenerating long line corpus..." >&2
+	for i in 1 2 3 4 5 6 7 8
+	do
+		yes "$line " | tr -d '\n' | head -c 8388608
+		echo
+	done > $corpus/long.txt
+fi
+#one file larger than memory is comfortable with
+if [[ ! -f $corpus/large.txt || `stat -c %s $corpus/large.txt` != $large ]]
+then
+	echo -e "\t\tGenerating large corpus..." >&2
+	yes "$line" | head -c $large > $corpus/large.txt
+fi
+
+echo -e "\t\tTiming..." >&2
+$executable --bench $corpus
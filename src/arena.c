@@ -0,0 +1,109 @@
+/*////////////////////////////
+    Includes
+*/////////////////////////////
+    #include <stdint.h>
+    #include "macros.h"
+    #include "arena.h"
+
+/*////////////////////////////
+    Defines
+*/////////////////////////////
+    #define ARENA_ALIGN         16
+    #define CHUNK_HEADER        ((sizeof(chunk_t) + ARENA_ALIGN - 1) & ~(u_int64_t)(ARENA_ALIGN - 1))
+
+/*////////////////////////////
+    Globals
+*/////////////////////////////
+    u_int64_t   MIN_CHUNK_SIZE =        65536;
+    u_int64_t   MAX_CHUNK_SIZE =        8388608;
+    u_int64_t   CHUNK_HINT_RATIO =      256;
+
+/*////////////////////////////
+    Functions
+*/////////////////////////////
+    /*////////////////////////////
+        Public Functions
+    */////////////////////////////
+        /*////////////////////////////
+            Lifetime Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Init arena
+                    sizes the first chunk from the expected data size
+            */////////////////////////////
+                void arenaInit(arena_t * arena, u_int64_t size_hint){
+                    arena->head = NULL;
+                    arena->chunk_size = size_hint / CHUNK_HINT_RATIO;
+                    if (arena->chunk_size < MIN_CHUNK_SIZE){
+                        arena->chunk_size = MIN_CHUNK_SIZE;
+                    }
+                    if (arena->chunk_size > MAX_CHUNK_SIZE){
+                        arena->chunk_size = MAX_CHUNK_SIZE;
+                    }
+                }
+            /*////////////////////////////
+                Release arena
+                    frees every allocation made from the arena at once
+            */////////////////////////////
+                void arenaRelease(arena_t * arena){
+                    while (NULL != arena->head){
+                        chunk_t * next = arena->head->next;
+                        free(arena->head);
+                        arena->head = next;
+                    }
+                }
+        /*////////////////////////////
+            Allocation Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Arena alloc
+                    bump allocates zeroed memory, chunks double as the arena fills
+                    returns NULL when out of memory
+            */////////////////////////////
+                void * arenaAlloc(arena_t * arena, u_int64_t size){
+                    size = (size + ARENA_ALIGN - 1) & ~(u_int64_t)(ARENA_ALIGN - 1);
+                    if ((NULL == arena->head) || (arena->head->size - arena->head->used < size)){
+                        u_int64_t chunk_size = arena->chunk_size;
+                        while (chunk_size < size){
+                            chunk_size *= 2;
+                        }
+                        chunk_t * chunk = calloc(1, CHUNK_HEADER + chunk_size);
+                        if (NULL == chunk){
+                            return NULL;
+                        }
+                        chunk->size = chunk_size;
+                        chunk->next = arena->head;
+                        arena->head = chunk;
+                        if (arena->chunk_size < MAX_CHUNK_SIZE){
+                            arena->chunk_size *= 2;
+                        }
+                    }
+                    void * memory = (char *)arena->head + CHUNK_HEADER + arena->head->used;
+                    arena->head->used += size;
+                    return memory;
+                }
+            /*////////////////////////////
+                Arena size
+                    returns the bytes held by every chunk
+            */////////////////////////////
+                u_int64_t arenaSize(arena_t * arena){
+                    u_int64_t size = 0;
+                    for (chunk_t * chunk = arena->head; NULL != chunk; chunk = chunk->next){
+                        size += CHUNK_HEADER + chunk->size;
+                    }
+                    return size;
+                }
+            /*////////////////////////////
+                Grow capacity
+                    returns a geometrically grown capacity that holds needed elements
+            */////////////////////////////
+                u_int64_t growCapacity(u_int64_t capacity, u_int64_t needed, u_int64_t minimum){
+                    if (capacity < minimum){
+                        capacity = minimum;
+                    }
+                    while (capacity < needed){
+                        capacity = (capacity > UINT64_MAX / 2) ? needed : capacity * 2;
+                    }
+                    return capacity;
+                }
+//End of file
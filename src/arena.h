@@ -0,0 +1,44 @@
+/*////////////////////////////
+    Guard
+*/////////////////////////////
+    #ifndef ARENA_H
+    #define ARENA_H
+
+/*////////////////////////////
+    Includes
+*/////////////////////////////
+    #include <sys/types.h>
+
+/*////////////////////////////
+    Structs
+*/////////////////////////////
+    struct chunk;
+    struct chunk{
+        struct chunk *          next;       //previously filled chunk
+        u_int64_t               size;       //usable bytes after the header
+        u_int64_t               used;       //bytes handed out
+    };
+    struct arena{
+        struct chunk *          head;       //chunk currently being filled
+        u_int64_t               chunk_size; //size of the next chunk
+    };
+
+/*////////////////////////////
+    Typedefs
+*/////////////////////////////
+    typedef struct chunk        chunk_t;
+    typedef struct arena        arena_t;
+
+/*////////////////////////////
+    Prototypes
+*/////////////////////////////
+    //Lifetime
+        void arenaInit(arena_t * arena, u_int64_t size_hint);
+        void arenaRelease(arena_t * arena);
+    //Allocation
+        void * arenaAlloc(arena_t * arena, u_int64_t size);
+        u_int64_t arenaSize(arena_t * arena);
+        u_int64_t growCapacity(u_int64_t capacity, u_int64_t needed, u_int64_t minimum);
+
+    #endif
+//End of file
@@ -0,0 +1,203 @@
+/*////////////////////////////
+    Includes
+*/////////////////////////////
+    #include <string.h>
+    #include <stdlib.h>
+    #include <time.h>
+    #include "macros.h"
+    #include "arena.h"
+    #include "bench.h"
+
+/*////////////////////////////
+    Prototypes
+*/////////////////////////////
+    //Reporting
+        static void writeString(FILE * output, const char * text);
+        static int compareSamples(const void * left, const void * right);
+
+/*////////////////////////////
+    Globals
+*/////////////////////////////
+    u_int64_t   MIN_MEASURE_CAPACITY =  16;
+    u_int64_t   MIN_SAMPLE_CAPACITY =   64;
+    u_int64_t   BENCH_FORMAT =          1;
+
+/*////////////////////////////
+    Functions
+*/////////////////////////////
+    /*////////////////////////////
+        Public Functions
+    */////////////////////////////
+        /*////////////////////////////
+            Lifetime Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Bench init
+            */////////////////////////////
+                void benchInit(bench_t * bench){
+                    memset(bench, 0, sizeof(bench_t));
+                }
+            /*////////////////////////////
+                Bench release
+            */////////////////////////////
+                void benchRelease(bench_t * bench){
+                    for (u_int64_t iter = 0; iter < bench->count; iter++){
+                        free(bench->measures[iter].samples);
+                        free(bench->measures[iter].corpus);
+                    }
+                    free(bench->measures);
+                    benchInit(bench);
+                }
+        /*////////////////////////////
+            Timing Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Bench now
+                    returns monotonic nanoseconds
+            */////////////////////////////
+                u_int64_t benchNow(){
+                    struct timespec now;
+                    clock_gettime(CLOCK_MONOTONIC, &now);
+                    return (u_int64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+                }
+            /*////////////////////////////
+                Bench begin
+                    starts a measure that following samples are added to
+                    returns 0 on success
+            */////////////////////////////
+                int benchBegin(bench_t * bench, const char * name, const char * corpus){
+                    if (bench->count == bench->capacity){
+                        u_int64_t capacity = growCapacity(bench->capacity, bench->count + 1, MIN_MEASURE_CAPACITY);
+                        measure_t * measures = realloc(bench->measures, capacity * sizeof(measure_t));
+                        if (NULL == measures){
+                            return -1;
+                        }
+                        bench->measures = measures;
+                        bench->capacity = capacity;
+                    }
+                    measure_t * measure = &bench->measures[bench->count];
+                    memset(measure, 0, sizeof(measure_t));
+                    measure->name = name;
+                    measure->corpus = strdup(corpus);
+                    if (NULL == measure->corpus){
+                        return -1;
+                    }
+                    bench->count++;
+                    return 0;
+                }
+            /*////////////////////////////
+                Bench start
+                    starts timing a sample
+            */////////////////////////////
+                void benchStart(bench_t * bench){
+                    bench->started = benchNow();
+                }
+            /*////////////////////////////
+                Bench stop
+                    adds the time since benchStart to the newest measure along
+                    with the bytes the run processed
+                    returns 0 on success
+            */////////////////////////////
+                int benchStop(bench_t * bench, u_int64_t bytes){
+                    return benchSample(bench, benchNow() - bench->started, bytes);
+                }
+            /*////////////////////////////
+                Bench sample
+                    adds a sample timed elsewhere to the newest measure along
+                    with the bytes the run processed
+                    returns 0 on success
+            */////////////////////////////
+                int benchSample(bench_t * bench, u_int64_t elapsed, u_int64_t bytes){
+                    if (0 == bench->count){
+                        return -1;
+                    }
+                    measure_t * measure = &bench->measures[bench->count - 1];
+                    if (measure->count == measure->capacity){
+                        u_int64_t capacity = growCapacity(measure->capacity, measure->count + 1, MIN_SAMPLE_CAPACITY);
+                        u_int64_t * samples = realloc(measure->samples, capacity * sizeof(u_int64_t));
+                        if (NULL == samples){
+                            return -1;
+                        }
+                        measure->samples = samples;
+                        measure->capacity = capacity;
+                    }
+                    measure->samples[measure->count++] = elapsed;
+                    measure->bytes += bytes;
+                    return 0;
+                }
+        /*////////////////////////////
+            Reporting Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Bench write
+                    writes every measure as JSON, times in nanoseconds
+                    returns 0 on success
+            */////////////////////////////
+                int benchWrite(bench_t * bench, FILE * output){
+                    fprintf(output, "{\n  \"format\": %llu,\n  \"timestamp\": %lld,\n  \"measures\": [", (unsigned long long)BENCH_FORMAT, (long long)time(NULL));
+                    u_int64_t written = 0;
+                    for (u_int64_t iter = 0; iter < bench->count; iter++){
+                        measure_t * measure = &bench->measures[iter];
+                        if (0 == measure->count){
+                            continue;
+                        }
+                        //samples are sorted in place for the percentiles
+                        qsort(measure->samples, measure->count, sizeof(u_int64_t), compareSamples);
+                        u_int64_t total = 0;
+                        for (u_int64_t sample = 0; sample < measure->count; sample++){
+                            total += measure->samples[sample];
+                        }
+                        fprintf(output, "%s\n    {\"name\": ", (0 == written++) ? "" : ",");
+                        writeString(output, measure->name);
+                        fprintf(output, ", \"corpus\": ");
+                        writeString(output, measure->corpus);
+                        fprintf(output, ", \"samples\": %llu, \"total_ns\": %llu, \"mean_ns\": %llu, \"min_ns\": %llu, \"median_ns\": %llu, \"p99_ns\": %llu, \"max_ns\": %llu",
+                            (unsigned long long)measure->count,
+                            (unsigned long long)total,
+                            (unsigned long long)(total / measure->count),
+                            (unsigned long long)measure->samples[0],
+                            (unsigned long long)measure->samples[measure->count / 2],
+                            (unsigned long long)measure->samples[(measure->count * 99) / 100],
+                            (unsigned long long)measure->samples[measure->count - 1]);
+                        if ((0 != measure->bytes) && (0 != total)){
+                            fprintf(output, ", \"bytes\": %llu, \"mb_per_s\": %.1f", (unsigned long long)measure->bytes, (double)measure->bytes * 1000.0 / (double)total);
+                        }
+                        fprintf(output, "}");
+                    }
+                    fprintf(output, "\n  ]\n}\n");
+                    return ferror(output) ? -1 : 0;
+                }
+
+    /*////////////////////////////
+        Private Functions
+    */////////////////////////////
+        /*////////////////////////////
+            Reporting Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Write string
+                    writes text as a quoted JSON string
+            */////////////////////////////
+                static void writeString(FILE * output, const char * text){
+                    fputc('"', output);
+                    for (; '\0' != *text; text++){
+                        u_int8_t byte = *text;
+                        if (('"' == byte) || ('\\' == byte)){
+                            fprintf(output, "\\%c", byte);
+                        }else if (0x20 > byte){
+                            fprintf(output, "\\u%04x", byte);
+                        }else{
+                            fputc(byte, output);
+                        }
+                    }
+                    fputc('"', output);
+                }
+            /*////////////////////////////
+                Compare samples
+            */////////////////////////////
+                static int compareSamples(const void * left, const void * right){
+                    u_int64_t first = *(const u_int64_t *)left;
+                    u_int64_t second = *(const u_int64_t *)right;
+                    return (first > second) - (first < second);
+                }
+//End of file
@@ -0,0 +1,53 @@
+/*////////////////////////////
+    Guard
+*/////////////////////////////
+    #ifndef BENCH_H
+    #define BENCH_H
+
+/*////////////////////////////
+    Includes
+*/////////////////////////////
+    #include <stdio.h>
+    #include <sys/types.h>
+
+/*////////////////////////////
+    Structs
+*/////////////////////////////
+    struct measure{
+        const char *            name;       //what was timed
+        char *                  corpus;     //file it was timed on
+        u_int64_t *             samples;    //nanoseconds of each run
+        u_int64_t               count;      //samples taken
+        u_int64_t               capacity;   //samples allocated
+        u_int64_t               bytes;      //bytes processed by every run together, 0 when not a throughput
+    };
+    struct bench{
+        struct measure *        measures;   //every measure in the order they were begun
+        u_int64_t               count;      //measures in use
+        u_int64_t               capacity;   //measures allocated
+        u_int64_t               started;    //when the running sample began
+    };
+
+/*////////////////////////////
+    Typedefs
+*/////////////////////////////
+    typedef struct measure      measure_t;
+    typedef struct bench        bench_t;
+
+/*////////////////////////////
+    Prototypes
+*/////////////////////////////
+    //Lifetime
+        void benchInit(bench_t * bench);
+        void benchRelease(bench_t * bench);
+    //Timing
+        u_int64_t benchNow();
+        int benchBegin(bench_t * bench, const char * name, const char * corpus);
+        void benchStart(bench_t * bench);
+        int benchStop(bench_t * bench, u_int64_t bytes);
+        int benchSample(bench_t * bench, u_int64_t elapsed, u_int64_t bytes);
+    //Reporting
+        int benchWrite(bench_t * bench, FILE * output);
+
+    #endif
+//End of file
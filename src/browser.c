@@ -0,0 +1,298 @@
+/*////////////////////////////
+    Includes
+*/////////////////////////////
+    #include <fcntl.h>
+    #include <dirent.h>
+    #include <limits.h>
+    #include <stdio.h>
+    #include <string.h>
+    #include <unistd.h>
+    #include <sys/stat.h>
+    #ifdef __linux__
+        #include <sys/syscall.h>
+    #endif
+    #include "macros.h"
+    #include "browser.h"
+
+/*////////////////////////////
+    Structs
+*/////////////////////////////
+#ifdef __linux__
+    struct record{
+        u_int64_t               inode;      //d_ino
+        int64_t                 next;       //d_off
+        unsigned short          length;     //d_reclen, bytes in this record
+        unsigned char           type;       //d_type
+        char                    name[];     //d_name, null terminated
+    };
+#endif
+
+/*////////////////////////////
+    Prototypes
+*/////////////////////////////
+    //Listings
+        static listing_t * listingRead(const char * path, struct timespec mtime);
+        static int listingAdd(listing_t * listing, const char * name, u_int8_t type);
+        static void listingFree(listing_t * listing);
+        static int entryCompare(const void * left, const void * right);
+
+/*////////////////////////////
+    Globals
+*/////////////////////////////
+    u_int64_t   MAX_CACHED_LISTINGS =   8;
+    u_int64_t   MIN_ENTRY_CAPACITY =    256;
+    u_int64_t   DIRENT_BUFFER_SIZE =    1048576;
+
+/*////////////////////////////
+    Functions
+*/////////////////////////////
+    /*////////////////////////////
+        Public Functions
+    */////////////////////////////
+        /*////////////////////////////
+            Lifetime Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Browser open
+                    shows a directory, reusing its cached listing while the
+                    directory mtime is unchanged
+                    returns 0 on success
+            */////////////////////////////
+                int browserOpen(browser_t * browser, const char * path){
+                    char canonical[PATH_MAX];
+                    struct stat dir_stat;
+                    if ((NULL == realpath(path, canonical)) || (0 != stat(canonical, &dir_stat)) || (!S_ISDIR(dir_stat.st_mode))){
+                        return -1;
+                    }
+                    //look for a fresh listing, dropping a stale one
+                    listing_t ** link = &browser->cache;
+                    listing_t * listing = NULL;
+                    while (NULL != *link){
+                        if (0 == strcmp((*link)->path, canonical)){
+                            listing = *link;
+                            *link = listing->next;
+                            browser->cached--;
+                            if ((listing->mtime.tv_sec != dir_stat.st_mtim.tv_sec) || (listing->mtime.tv_nsec != dir_stat.st_mtim.tv_nsec)){
+                                listingFree(listing);
+                                listing = NULL;
+                            }
+                            break;
+                        }
+                        link = &(*link)->next;
+                    }
+                    if (NULL == listing){
+                        listing = listingRead(canonical, dir_stat.st_mtim);
+                        if (NULL == listing){
+                            return -1;
+                        }
+                    }
+                    //most recently used first, evicting from the tail
+                    listing->next = browser->cache;
+                    browser->cache = listing;
+                    browser->cached++;
+                    if (browser->cached > MAX_CACHED_LISTINGS){
+                        listing_t * prev = browser->cache;
+                        while (NULL != prev->next->next){
+                            prev = prev->next;
+                        }
+                        listingFree(prev->next);
+                        prev->next = NULL;
+                        browser->cached--;
+                    }
+                    browser->current = listing;
+                    browser->selected = 0;
+                    browser->scroll = 0;
+                    return 0;
+                }
+            /*////////////////////////////
+                Browser release
+                    frees every cached listing
+            */////////////////////////////
+                void browserRelease(browser_t * browser){
+                    while (NULL != browser->cache){
+                        listing_t * next = browser->cache->next;
+                        listingFree(browser->cache);
+                        browser->cache = next;
+                    }
+                    memset(browser, 0, sizeof(browser_t));
+                }
+        /*////////////////////////////
+            Entry Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Browser count
+                    returns the entries in the shown directory
+            */////////////////////////////
+                u_int64_t browserCount(browser_t * browser){
+                    return (NULL == browser->current) ? 0 : browser->current->count;
+                }
+            /*////////////////////////////
+                Browser entry
+                    returns an entry, running stat on it the first time it is
+                    asked for so only entries that get shown pay for it
+            */////////////////////////////
+                entry_t * browserEntry(browser_t * browser, u_int64_t index){
+                    if (index >= browserCount(browser)){
+                        return NULL;
+                    }
+                    listing_t * listing = browser->current;
+                    entry_t * entry = &listing->entries[index];
+                    if (!entry->stated){
+                        struct stat entry_stat;
+                        entry->stated = 1;
+                        if (0 == fstatat(listing->fd, entry->name, &entry_stat, 0)){
+                            entry->type = S_ISDIR(entry_stat.st_mode) ? ENTRY_DIR : ENTRY_FILE;
+                            entry->size = entry_stat.st_size;
+                        }
+                    }
+                    return entry;
+                }
+            /*////////////////////////////
+                Browser path
+                    returns a heap copy of an entry's full path
+            */////////////////////////////
+                char * browserPath(browser_t * browser, u_int64_t index){
+                    if (index >= browserCount(browser)){
+                        return NULL;
+                    }
+                    listing_t * listing = browser->current;
+                    u_int64_t size = strlen(listing->path) + strlen(listing->entries[index].name) + 2;
+                    char * path = malloc(size);
+                    if (NULL != path){
+                        snprintf(path, size, "%s/%s", listing->path, listing->entries[index].name);
+                    }
+                    return path;
+                }
+
+    /*////////////////////////////
+        Private Functions
+    */////////////////////////////
+        /*////////////////////////////
+            Listing Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Listing read
+                    reads a directory in bulk, keeping the type the kernel
+                    reports so nothing is stated up front
+                    returns NULL on failure
+            */////////////////////////////
+                static listing_t * listingRead(const char * path, struct timespec mtime){
+                    listing_t * listing = calloc(1, sizeof(listing_t));
+                    if (NULL == listing){
+                        return NULL;
+                    }
+                    arenaInit(&listing->names, 0);
+                    listing->mtime = mtime;
+                    listing->path = strdup(path);
+                    listing->fd = open(path, O_RDONLY | O_DIRECTORY);
+                    if ((NULL == listing->path) || (-1 == listing->fd)){
+                        listingFree(listing);
+                        return NULL;
+                    }
+                    int status = 0;
+#ifdef __linux__
+                    //whole batches of records per system call
+                    char * records = malloc(DIRENT_BUFFER_SIZE);
+                    if (NULL == records){
+                        listingFree(listing);
+                        return NULL;
+                    }
+                    for(;;){
+                        long size = syscall(SYS_getdents64, listing->fd, records, DIRENT_BUFFER_SIZE);
+                        if (0 >= size){
+                            status = (0 > size) ? -1 : 0;
+                            break;
+                        }
+                        for (long position = 0; (0 == status) && (position < size);){
+                            struct record * record = (struct record *)(records + position);
+                            u_int8_t type = (DT_DIR == record->type) ? ENTRY_DIR : (DT_REG == record->type) ? ENTRY_FILE : ENTRY_UNKNOWN;
+                            status = listingAdd(listing, record->name, type);
+                            position += record->length;
+                        }
+                        if (0 != status){
+                            break;
+                        }
+                    }
+                    free(records);
+#else
+                    DIR * dir = fdopendir(dup(listing->fd));
+                    if (NULL == dir){
+                        listingFree(listing);
+                        return NULL;
+                    }
+                    struct dirent * record;
+                    while ((0 == status) && (NULL != (record = readdir(dir)))){
+                        u_int8_t type = (DT_DIR == record->d_type) ? ENTRY_DIR : (DT_REG == record->d_type) ? ENTRY_FILE : ENTRY_UNKNOWN;
+                        status = listingAdd(listing, record->d_name, type);
+                    }
+                    closedir(dir);
+#endif
+                    if (0 != status){
+                        listingFree(listing);
+                        return NULL;
+                    }
+                    qsort(listing->entries, listing->count, sizeof(entry_t), entryCompare);
+                    return listing;
+                }
+            /*////////////////////////////
+                Listing add
+                    appends an entry, skipping the directory itself
+                    returns 0 on success
+            */////////////////////////////
+                static int listingAdd(listing_t * listing, const char * name, u_int8_t type){
+                    if (0 == strcmp(name, ".")){
+                        return 0;
+                    }
+                    if (listing->count == listing->capacity){
+                        u_int64_t capacity = growCapacity(listing->capacity, listing->count + 1, MIN_ENTRY_CAPACITY);
+                        entry_t * entries = realloc(listing->entries, capacity * sizeof(entry_t));
+                        if (NULL == entries){
+                            return -1;
+                        }
+                        listing->entries = entries;
+                        listing->capacity = capacity;
+                    }
+                    u_int64_t length = strlen(name);
+                    char * copy = arenaAlloc(&listing->names, length + 1);
+                    if (NULL == copy){
+                        return -1;
+                    }
+                    memcpy(copy, name, length + 1);
+                    entry_t * entry = &listing->entries[listing->count++];
+                    entry->name = copy;
+                    entry->type = (0 == strcmp(name, "..")) ? ENTRY_DIR : type;
+                    entry->stated = 0;
+                    entry->size = 0;
+                    return 0;
+                }
+            /*////////////////////////////
+                Listing free
+            */////////////////////////////
+                static void listingFree(listing_t * listing){
+                    if (-1 != listing->fd){
+                        close(listing->fd);
+                    }
+                    arenaRelease(&listing->names);
+                    free(listing->entries);
+                    free(listing->path);
+                    free(listing);
+                }
+            /*////////////////////////////
+                Entry compare
+                    parent first, then directories, then files, each by name
+                    entries of unknown type sort with files until stated
+            */////////////////////////////
+                static int entryCompare(const void * left, const void * right){
+                    const entry_t * first = left;
+                    const entry_t * second = right;
+                    u_int8_t first_parent = (0 == strcmp(first->name, ".."));
+                    u_int8_t second_parent = (0 == strcmp(second->name, ".."));
+                    if (first_parent != second_parent){
+                        return second_parent - first_parent;
+                    }
+                    if ((ENTRY_DIR == first->type) != (ENTRY_DIR == second->type)){
+                        return (ENTRY_DIR == first->type) ? -1 : 1;
+                    }
+                    return strcmp(first->name, second->name);
+                }
+//End of file
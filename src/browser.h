@@ -0,0 +1,68 @@
+/*////////////////////////////
+    Guard
+*/////////////////////////////
+    #ifndef BROWSER_H
+    #define BROWSER_H
+
+/*////////////////////////////
+    Includes
+*/////////////////////////////
+    #include <time.h>
+    #include <sys/types.h>
+    #include "arena.h"
+
+/*////////////////////////////
+    Defines
+*/////////////////////////////
+    #define ENTRY_UNKNOWN       0
+    #define ENTRY_FILE          1
+    #define ENTRY_DIR           2
+
+/*////////////////////////////
+    Structs
+*/////////////////////////////
+    struct entry{
+        char *                  name;       //null terminated name inside the listing arena
+        u_int8_t                type;       //ENTRY_FILE, ENTRY_DIR or ENTRY_UNKNOWN until stated
+        u_int8_t                stated;     //size and type come from stat
+        u_int64_t               size;       //bytes in the file once stated
+    };
+    struct listing;
+    struct listing{
+        struct listing *        next;       //less recently used listing
+        char *                  path;       //canonical directory path
+        struct timespec         mtime;      //directory mtime the entries were read at
+        int                     fd;         //open directory for lazy stats
+        struct entry *          entries;    //sorted, parent first then directories then files
+        u_int64_t               count;      //entries in use
+        u_int64_t               capacity;   //entries allocated
+        struct arena            names;      //storage for every entry name
+    };
+    struct browser{
+        struct listing *        cache;      //listings, most recently used first
+        u_int64_t               cached;     //listings in the cache
+        struct listing *        current;    //listing shown in the pane
+        u_int64_t               selected;   //highlighted entry
+        u_int64_t               scroll;     //first entry shown
+    };
+
+/*////////////////////////////
+    Typedefs
+*/////////////////////////////
+    typedef struct entry        entry_t;
+    typedef struct listing      listing_t;
+    typedef struct browser      browser_t;
+
+/*////////////////////////////
+    Prototypes
+*/////////////////////////////
+    //Lifetime
+        int browserOpen(browser_t * browser, const char * path);
+        void browserRelease(browser_t * browser);
+    //Entries
+        u_int64_t browserCount(browser_t * browser);
+        entry_t * browserEntry(browser_t * browser, u_int64_t index);
+        char * browserPath(browser_t * browser, u_int64_t index);
+
+    #endif
+//End of file
@@ -0,0 +1,828 @@
+/*////////////////////////////
+    Includes
+*/////////////////////////////
+    #include <stdint.h>
+    #include <string.h>
+    #include <unistd.h>
+    #include "macros.h"
+    #include "buffer.h"
+
+/*////////////////////////////
+    Prototypes
+*/////////////////////////////
+    //Indexing
+        static int bufferStart(buffer_t * buffer, char * data, u_int64_t size, u_int64_t jobs, u_int64_t stride);
+        static int indexStart(buffer_t * buffer, u_int64_t jobs);
+        static void * indexWorker(void * argument);
+        static void indexStop(buffer_t * buffer);
+        static int indexSettle(buffer_t * buffer);
+        static void indexWaitNewlines(buffer_t * buffer, u_int64_t newlines);
+        static void indexWaitBytes(buffer_t * buffer, u_int64_t offset);
+    //Pieces
+        static piece_t * pieceNew(buffer_t * buffer, u_int8_t source, u_int64_t start, u_int64_t length);
+        static void pieceFree(buffer_t * buffer, piece_t * node);
+        static void pieceUpdate(piece_t * node);
+        static piece_t * pieceMerge(piece_t * left, piece_t * right);
+        static void pieceSplit(buffer_t * buffer, piece_t * node, u_int64_t offset, piece_t ** spare, piece_t ** left, piece_t ** right);
+        static int pieceExtend(buffer_t * buffer, piece_t * node, u_int8_t source, u_int64_t start, u_int64_t length, u_int64_t newlines);
+        static u_int64_t pieceNewlineOffset(buffer_t * buffer, u_int64_t newline);
+        static int pieceWalk(buffer_t * buffer, piece_t * node, int (*visit)(void * context, u_int8_t source, const char * data, u_int64_t start, u_int64_t length), void * context);
+    //Random
+        static u_int32_t randomPriority();
+
+/*////////////////////////////
+    Globals
+*/////////////////////////////
+    u_int32_t   PRIORITY_SEED =         2463534242u;
+    u_int64_t   PROGRESSIVE_THRESHOLD = 16777216;
+    u_int64_t   MIN_VIEW_STRIDE =       64;
+
+/*////////////////////////////
+    Functions
+*/////////////////////////////
+    /*////////////////////////////
+        Public Functions
+    */////////////////////////////
+        /*////////////////////////////
+            Lifetime Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Open buffer
+                    wraps existing data as the immutable original
+                    large files are indexed by jobs background threads, 0 for
+                    one per core, and can be read while they run
+                    the caller keeps ownership of data
+                    returns 0 on success
+            */////////////////////////////
+                int bufferOpen(buffer_t * buffer, char * data, u_int64_t size, u_int64_t jobs){
+                    return bufferStart(buffer, data, size, jobs, 1);
+                }
+            /*////////////////////////////
+                Open view
+                    opens data as bufferOpen does but keeps a sparse line index
+                    of the original, every stride-th newline with the rest
+                    found by scanning, the stride picked so that even a file of
+                    empty lines stays within budget bytes of index
+                    returns 0 on success
+            */////////////////////////////
+                int bufferOpenView(buffer_t * buffer, char * data, u_int64_t size, u_int64_t jobs, u_int64_t budget){
+                    //the segment table and a stored newline per chunk are fixed costs
+                    u_int64_t chunks = (size >> INDEX_CHUNK_SHIFT) + 1;
+                    u_int64_t fixed = chunks * (2 * sizeof(segment_t) + sizeof(u_int64_t));
+                    u_int64_t stride = size + 1;
+                    if (budget >= fixed + sizeof(u_int64_t)){
+                        stride = (size / ((budget - fixed) / sizeof(u_int64_t))) + 1;
+                    }
+                    if (stride < MIN_VIEW_STRIDE){
+                        stride = MIN_VIEW_STRIDE;
+                    }
+                    return bufferStart(buffer, data, size, jobs, stride);
+                }
+            /*////////////////////////////
+                Close buffer
+                    stops indexing and releases the pieces, additions and newline indexes
+                    pieces are released together with their arena
+            */////////////////////////////
+                void bufferClose(buffer_t * buffer){
+                    if (buffer->indexer.running){
+                        __atomic_store_n(&buffer->indexer.cancel, 1, __ATOMIC_RELEASE);
+                        indexStop(buffer);
+                    }
+                    arenaRelease(&buffer->arena);
+                    for (u_int64_t iter = 0; iter < SOURCE_COUNT; iter++){
+                        sourceRelease(&buffer->sources[iter]);
+                    }
+                    memset(buffer, 0, sizeof(buffer_t));
+                }
+        /*////////////////////////////
+            Indexing Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Buffer indexing
+                    polls the background indexer, settling it once it is done
+                    returns 1 while indexing, 0 when done and -1 when it failed
+            */////////////////////////////
+                int bufferIndexing(buffer_t * buffer){
+                    if (!buffer->indexer.running){
+                        return 0;
+                    }
+                    if (!__atomic_load_n(&buffer->indexer.done, __ATOMIC_ACQUIRE)){
+                        return 1;
+                    }
+                    return indexSettle(buffer);
+                }
+            /*////////////////////////////
+                Indexed bytes
+                    returns how much of the original has been indexed
+            */////////////////////////////
+                u_int64_t bufferIndexedBytes(buffer_t * buffer){
+                    return sourceIndexedBytes(&buffer->sources[SOURCE_ORIGINAL]);
+                }
+            /*////////////////////////////
+                Finish index
+                    blocks until the whole original is indexed, needed before editing
+                    returns 0 on success
+            */////////////////////////////
+                int bufferFinishIndex(buffer_t * buffer){
+                    if (!buffer->indexer.running){
+                        return 0;
+                    }
+                    return indexSettle(buffer);
+                }
+        /*////////////////////////////
+            Query Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Buffer length
+                    returns the number of bytes in the document
+            */////////////////////////////
+                u_int64_t bufferLength(buffer_t * buffer){
+                    if (buffer->indexer.running){
+                        return buffer->sources[SOURCE_ORIGINAL].size;
+                    }
+                    return (NULL == buffer->root) ? 0 : buffer->root->total_length;
+                }
+            /*////////////////////////////
+                Line count
+                    a document always has one more line than newlines
+                    while indexing only the lines found so far are counted
+            */////////////////////////////
+                u_int64_t bufferLineCount(buffer_t * buffer){
+                    if (buffer->indexer.running){
+                        return sourceNewlineCount(&buffer->sources[SOURCE_ORIGINAL]) + 1;
+                    }
+                    return ((NULL == buffer->root) ? 0 : buffer->root->total_newlines) + 1;
+                }
+            /*////////////////////////////
+                Line start
+                    returns the document offset of the first byte of a line
+                    while indexing this waits only for the chunk holding the line
+            */////////////////////////////
+                u_int64_t bufferLineStart(buffer_t * buffer, u_int64_t line){
+                    if (0 == line){
+                        return 0;
+                    }
+                    if (buffer->indexer.running){
+                        source_t * original = &buffer->sources[SOURCE_ORIGINAL];
+                        indexWaitNewlines(buffer, line);
+                        if (line > sourceNewlineCount(original)){
+                            return original->size;
+                        }
+                        return sourceNewlineAt(original, line - 1) + 1;
+                    }
+                    if (line >= bufferLineCount(buffer)){
+                        return bufferLength(buffer);
+                    }
+                    return pieceNewlineOffset(buffer, line - 1) + 1;
+                }
+            /*////////////////////////////
+                Line length
+                    returns the length of a line without its newline
+            */////////////////////////////
+                u_int64_t bufferLineLength(buffer_t * buffer, u_int64_t line){
+                    if (buffer->indexer.running){
+                        source_t * original = &buffer->sources[SOURCE_ORIGINAL];
+                        u_int64_t start = bufferLineStart(buffer, line);
+                        indexWaitNewlines(buffer, line + 1);
+                        if (line < sourceNewlineCount(original)){
+                            return sourceNewlineAt(original, line) - start;
+                        }
+                        return original->size - start;
+                    }
+                    if (line >= bufferLineCount(buffer)){
+                        return 0;
+                    }
+                    u_int64_t start = bufferLineStart(buffer, line);
+                    if (line + 1 == bufferLineCount(buffer)){
+                        return bufferLength(buffer) - start;
+                    }
+                    return pieceNewlineOffset(buffer, line) - start;
+                }
+            /*////////////////////////////
+                Line of offset
+                    returns the line containing a document offset
+            */////////////////////////////
+                u_int64_t bufferLineOfOffset(buffer_t * buffer, u_int64_t offset){
+                    if (buffer->indexer.running){
+                        indexWaitBytes(buffer, offset);
+                        return sourceNewlinesBefore(&buffer->sources[SOURCE_ORIGINAL], offset);
+                    }
+                    u_int64_t line = 0;
+                    piece_t * node = buffer->root;
+                    while (NULL != node){
+                        u_int64_t left_length = (NULL == node->left) ? 0 : node->left->total_length;
+                        if (offset < left_length){
+                            node = node->left;
+                            continue;
+                        }
+                        line += (NULL == node->left) ? 0 : node->left->total_newlines;
+                        offset -= left_length;
+                        if (offset < node->length){
+                            source_t * source = &buffer->sources[node->source];
+                            return line + sourceNewlinesBefore(source, node->start + offset) - sourceNewlinesBefore(source, node->start);
+                        }
+                        line += node->newlines;
+                        offset -= node->length;
+                        node = node->right;
+                    }
+                    return line;
+                }
+            /*////////////////////////////
+                Read
+                    copies up to length bytes starting at offset into dest
+                    returns the number of bytes copied
+            */////////////////////////////
+                u_int64_t bufferRead(buffer_t * buffer, u_int64_t offset, char * dest, u_int64_t length){
+                    if (buffer->indexer.running){
+                        source_t * original = &buffer->sources[SOURCE_ORIGINAL];
+                        if (offset >= original->size){
+                            return 0;
+                        }
+                        if (length > original->size - offset){
+                            length = original->size - offset;
+                        }
+                        memcpy(dest, original->data + offset, length);
+                        return length;
+                    }
+                    u_int64_t copied = 0;
+                    while (copied < length){
+                        //find the piece holding offset
+                        u_int64_t relative = offset + copied;
+                        piece_t * node = buffer->root;
+                        while (NULL != node){
+                            u_int64_t left_length = (NULL == node->left) ? 0 : node->left->total_length;
+                            if (relative < left_length){
+                                node = node->left;
+                            }else if (relative - left_length < node->length){
+                                relative -= left_length;
+                                break;
+                            }else{
+                                relative -= left_length + node->length;
+                                node = node->right;
+                            }
+                        }
+                        if (NULL == node){
+                            break;
+                        }
+                        //copy as much of this piece as fits
+                        u_int64_t count = node->length - relative;
+                        if (count > length - copied){
+                            count = length - copied;
+                        }
+                        memcpy(dest + copied, buffer->sources[node->source].data + node->start + relative, count);
+                        copied += count;
+                    }
+                    return copied;
+                }
+            /*////////////////////////////
+                Span
+                    returns the contiguous bytes of the piece holding offset
+                    without copying, start and length receive the document
+                    range they cover, NULL past the end
+            */////////////////////////////
+                const char * bufferSpan(buffer_t * buffer, u_int64_t offset, u_int64_t * start, u_int64_t * length){
+                    if (buffer->indexer.running){
+                        source_t * original = &buffer->sources[SOURCE_ORIGINAL];
+                        if (offset >= original->size){
+                            return NULL;
+                        }
+                        *start = 0;
+                        *length = original->size;
+                        return original->data;
+                    }
+                    u_int64_t base = 0;
+                    piece_t * node = buffer->root;
+                    while (NULL != node){
+                        u_int64_t left_length = (NULL == node->left) ? 0 : node->left->total_length;
+                        if (offset < base + left_length){
+                            node = node->left;
+                        }else if (offset - base - left_length < node->length){
+                            *start = base + left_length;
+                            *length = node->length;
+                            return buffer->sources[node->source].data + node->start;
+                        }else{
+                            base += left_length + node->length;
+                            node = node->right;
+                        }
+                    }
+                    return NULL;
+                }
+            /*////////////////////////////
+                Walk
+                    visits every piece in document order with its source, bytes
+                    and where it starts in that source
+                    returns the first nonzero result of visit, 0 otherwise
+            */////////////////////////////
+                int bufferWalk(buffer_t * buffer, int (*visit)(void * context, u_int8_t source, const char * data, u_int64_t start, u_int64_t length), void * context){
+                    if (buffer->indexer.running){
+                        source_t * original = &buffer->sources[SOURCE_ORIGINAL];
+                        return (0 == original->size) ? 0 : visit(context, SOURCE_ORIGINAL, original->data, 0, original->size);
+                    }
+                    return pieceWalk(buffer, buffer->root, visit, context);
+                }
+            /*////////////////////////////
+                Memory
+                    returns the heap bytes behind the pieces, the additions and
+                    both line indexes, the mapped original is not counted
+            */////////////////////////////
+                u_int64_t bufferMemory(buffer_t * buffer){
+                    u_int64_t memory = arenaSize(&buffer->arena);
+                    for (u_int8_t source = 0; source < SOURCE_COUNT; source++){
+                        memory += sourceMemory(&buffer->sources[source]);
+                    }
+                    return memory;
+                }
+        /*////////////////////////////
+            Editing Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Insert
+                    inserts text before offset
+                    returns 0 on success
+            */////////////////////////////
+                int bufferInsert(buffer_t * buffer, u_int64_t offset, const char * text, u_int64_t length){
+                    if (0 == length){
+                        return 0;
+                    }
+                    if (0 != bufferFinishIndex(buffer)){
+                        return -1;
+                    }
+                    if (offset > bufferLength(buffer)){
+                        offset = bufferLength(buffer);
+                    }
+                    source_t * added = &buffer->sources[SOURCE_ADDED];
+                    u_int64_t start = added->size;
+                    u_int64_t newlines = sourceNewlineCount(added);
+                    if (0 != sourceAppend(added, text, length)){
+                        return -1;
+                    }
+                    newlines = sourceNewlineCount(added) - newlines;
+                    //nodes are allocated up front so the tree is never left half split
+                    piece_t * spare = pieceNew(buffer, SOURCE_ADDED, 0, 0);
+                    piece_t * node = pieceNew(buffer, SOURCE_ADDED, start, length);
+                    if ((NULL == spare) || (NULL == node)){
+                        pieceFree(buffer, spare);
+                        pieceFree(buffer, node);
+                        return -1;
+                    }
+                    piece_t * left;
+                    piece_t * right;
+                    pieceSplit(buffer, buffer->root, offset, &spare, &left, &right);
+                    //typing extends the previous addition instead of adding a piece
+                    if (0 == pieceExtend(buffer, left, SOURCE_ADDED, start, length, newlines)){
+                        pieceFree(buffer, node);
+                    }else{
+                        left = pieceMerge(left, node);
+                    }
+                    buffer->root = pieceMerge(left, right);
+                    pieceFree(buffer, spare);
+                    return 0;
+                }
+            /*////////////////////////////
+                Grow
+                    the original grew in place to size bytes, as a followed
+                    file does, so only the new bytes are indexed and appended
+                    to the end of the document
+                    returns 0 on success, 1 while the original is still being
+                    indexed and -1 on failure
+            */////////////////////////////
+                int bufferGrow(buffer_t * buffer, u_int64_t size){
+                    if (buffer->indexer.running){
+                        return 1;
+                    }
+                    source_t * original = &buffer->sources[SOURCE_ORIGINAL];
+                    if (size <= original->size){
+                        return 0;
+                    }
+                    u_int64_t start = original->size;
+                    u_int64_t newlines = sourceNewlineCount(original);
+                    //the source only takes the new size once its newlines are indexed
+                    if ((0 != sourceReserve(original, size)) || (0 != sourceIndex(original, start, size))){
+                        return -1;
+                    }
+                    original->size = size;
+                    newlines = sourceNewlineCount(original) - newlines;
+                    if (0 == pieceExtend(buffer, buffer->root, SOURCE_ORIGINAL, start, size - start, newlines)){
+                        return 0;
+                    }
+                    piece_t * node = pieceNew(buffer, SOURCE_ORIGINAL, start, size - start);
+                    if (NULL == node){
+                        return -1;
+                    }
+                    buffer->root = pieceMerge(buffer->root, node);
+                    return 0;
+                }
+            /*////////////////////////////
+                Delete
+                    removes length bytes starting at offset
+                    returns 0 on success
+            */////////////////////////////
+                int bufferDelete(buffer_t * buffer, u_int64_t offset, u_int64_t length){
+                    if (0 != bufferFinishIndex(buffer)){
+                        return -1;
+                    }
+                    u_int64_t total = bufferLength(buffer);
+                    if (offset >= total){
+                        return 0;
+                    }
+                    if (length > total - offset){
+                        length = total - offset;
+                    }
+                    if (0 == length){
+                        return 0;
+                    }
+                    piece_t * spares[2] = {pieceNew(buffer, SOURCE_ADDED, 0, 0), pieceNew(buffer, SOURCE_ADDED, 0, 0)};
+                    if ((NULL == spares[0]) || (NULL == spares[1])){
+                        pieceFree(buffer, spares[0]);
+                        pieceFree(buffer, spares[1]);
+                        return -1;
+                    }
+                    piece_t * left;
+                    piece_t * middle;
+                    piece_t * right;
+                    pieceSplit(buffer, buffer->root, offset, &spares[0], &left, &right);
+                    pieceSplit(buffer, right, length, &spares[1], &middle, &right);
+                    pieceFree(buffer, middle);
+                    buffer->root = pieceMerge(left, right);
+                    pieceFree(buffer, spares[0]);
+                    pieceFree(buffer, spares[1]);
+                    return 0;
+                }
+
+    /*////////////////////////////
+        Private Functions
+    */////////////////////////////
+        /*////////////////////////////
+            Indexing Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Buffer start
+                    wraps data as the original, storing every stride-th newline
+                    returns 0 on success
+            */////////////////////////////
+                static int bufferStart(buffer_t * buffer, char * data, u_int64_t size, u_int64_t jobs, u_int64_t stride){
+                    memset(buffer, 0, sizeof(buffer_t));
+                    arenaInit(&buffer->arena, size);
+                    source_t * original = &buffer->sources[SOURCE_ORIGINAL];
+                    original->data = data;
+                    original->size = size;
+                    original->stride = stride;
+                    if (0 != sourceReserve(original, size)){
+                        return -1;
+                    }
+                    //hand large files to the indexing threads
+                    if ((size > PROGRESSIVE_THRESHOLD) && (0 == indexStart(buffer, jobs))){
+                        return 0;
+                    }
+                    if (0 != sourceIndex(original, 0, size)){
+                        return -1;
+                    }
+                    if (0 < size){
+                        buffer->root = pieceNew(buffer, SOURCE_ORIGINAL, 0, size);
+                        if (NULL == buffer->root){
+                            return -1;
+                        }
+                    }
+                    return 0;
+                }
+            /*////////////////////////////
+                Index start
+                    splits the original into page aligned chunks and starts a pool
+                    of workers over them, at most one per chunk
+                    returns 0 when at least one worker is running
+            */////////////////////////////
+                static int indexStart(buffer_t * buffer, u_int64_t jobs){
+                    indexer_t * indexer = &buffer->indexer;
+                    u_int64_t chunks = ((buffer->sources[SOURCE_ORIGINAL].size - 1) >> INDEX_CHUNK_SHIFT) + 1;
+                    if (0 == jobs){
+                        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+                        jobs = (0 < cores) ? cores : 1;
+                    }
+                    if (jobs > chunks){
+                        jobs = chunks;
+                    }
+                    indexer->threads = calloc(jobs, sizeof(pthread_t));
+                    indexer->scanned = calloc(chunks, sizeof(u_int8_t));
+                    if ((NULL == indexer->threads) || (NULL == indexer->scanned)){
+                        free(indexer->threads);
+                        free(indexer->scanned);
+                        return -1;
+                    }
+                    indexer->chunk_count = chunks;
+                    pthread_mutex_init(&indexer->lock, NULL);
+                    pthread_cond_init(&indexer->progress, NULL);
+                    //held while starting so no worker can retire the pool early
+                    pthread_mutex_lock(&indexer->lock);
+                    for (; indexer->thread_count < jobs; indexer->thread_count++){
+                        if (0 != pthread_create(&indexer->threads[indexer->thread_count], NULL, indexWorker, buffer)){
+                            break;
+                        }
+                    }
+                    indexer->active = indexer->thread_count;
+                    pthread_mutex_unlock(&indexer->lock);
+                    indexer->running = 1;
+                    if (0 == indexer->thread_count){
+                        indexStop(buffer);
+                        return -1;
+                    }
+                    return 0;
+                }
+            /*////////////////////////////
+                Index worker
+                    claims chunks in order and scans them, then commits every
+                    chunk that now follows the published prefix so readers only
+                    ever see a gapless index, the last worker out marks it done
+            */////////////////////////////
+                static void * indexWorker(void * argument){
+                    buffer_t * buffer = argument;
+                    indexer_t * indexer = &buffer->indexer;
+                    source_t * original = &buffer->sources[SOURCE_ORIGINAL];
+                    for(;;){
+                        if (__atomic_load_n(&indexer->cancel, __ATOMIC_ACQUIRE)){
+                            break;
+                        }
+                        u_int64_t chunk = __atomic_fetch_add(&indexer->next_chunk, 1, __ATOMIC_RELAXED);
+                        if (chunk >= indexer->chunk_count){
+                            break;
+                        }
+                        int status = sourceScanChunk(original, chunk);
+                        pthread_mutex_lock(&indexer->lock);
+                        if (0 != status){
+                            indexer->status = -1;
+                            __atomic_store_n(&indexer->cancel, 1, __ATOMIC_RELEASE);
+                        }else{
+                            indexer->scanned[chunk] = 1;
+                            while ((indexer->committed < indexer->chunk_count) && (indexer->scanned[indexer->committed])){
+                                sourceCommit(original, indexer->committed++);
+                            }
+                            pthread_cond_broadcast(&indexer->progress);
+                        }
+                        pthread_mutex_unlock(&indexer->lock);
+                    }
+                    pthread_mutex_lock(&indexer->lock);
+                    if (0 == --indexer->active){
+                        if (indexer->committed < indexer->chunk_count){
+                            indexer->status = -1;
+                        }
+                        __atomic_store_n(&indexer->done, 1, __ATOMIC_RELEASE);
+                        pthread_cond_broadcast(&indexer->progress);
+                    }
+                    pthread_mutex_unlock(&indexer->lock);
+                    return NULL;
+                }
+            /*////////////////////////////
+                Index stop
+                    joins every worker and releases the pool
+            */////////////////////////////
+                static void indexStop(buffer_t * buffer){
+                    indexer_t * indexer = &buffer->indexer;
+                    for (u_int64_t iter = 0; iter < indexer->thread_count; iter++){
+                        pthread_join(indexer->threads[iter], NULL);
+                    }
+                    pthread_mutex_destroy(&indexer->lock);
+                    pthread_cond_destroy(&indexer->progress);
+                    free(indexer->threads);
+                    free(indexer->scanned);
+                    indexer->thread_count = 0;
+                    indexer->running = 0;
+                }
+            /*////////////////////////////
+                Index settle
+                    joins the workers and builds the piece tree
+                    returns 0 on success
+            */////////////////////////////
+                static int indexSettle(buffer_t * buffer){
+                    indexStop(buffer);
+                    if (0 != buffer->indexer.status){
+                        return -1;
+                    }
+                    buffer->root = pieceNew(buffer, SOURCE_ORIGINAL, 0, buffer->sources[SOURCE_ORIGINAL].size);
+                    return (NULL == buffer->root) ? -1 : 0;
+                }
+            /*////////////////////////////
+                Index wait newlines
+                    blocks until newlines newlines are published or indexing ends
+            */////////////////////////////
+                static void indexWaitNewlines(buffer_t * buffer, u_int64_t newlines){
+                    source_t * original = &buffer->sources[SOURCE_ORIGINAL];
+                    if (sourceNewlineCount(original) >= newlines){
+                        return;
+                    }
+                    pthread_mutex_lock(&buffer->indexer.lock);
+                    while ((sourceNewlineCount(original) < newlines) && (!__atomic_load_n(&buffer->indexer.done, __ATOMIC_ACQUIRE))){
+                        pthread_cond_wait(&buffer->indexer.progress, &buffer->indexer.lock);
+                    }
+                    pthread_mutex_unlock(&buffer->indexer.lock);
+                }
+            /*////////////////////////////
+                Index wait bytes
+                    blocks until the chunk holding offset is published or indexing ends
+            */////////////////////////////
+                static void indexWaitBytes(buffer_t * buffer, u_int64_t offset){
+                    source_t * original = &buffer->sources[SOURCE_ORIGINAL];
+                    if (sourceIndexedBytes(original) > offset){
+                        return;
+                    }
+                    pthread_mutex_lock(&buffer->indexer.lock);
+                    while ((sourceIndexedBytes(original) <= offset) && (!__atomic_load_n(&buffer->indexer.done, __ATOMIC_ACQUIRE))){
+                        pthread_cond_wait(&buffer->indexer.progress, &buffer->indexer.lock);
+                    }
+                    pthread_mutex_unlock(&buffer->indexer.lock);
+                }
+        /*////////////////////////////
+            Piece Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Piece new
+                    takes a released piece or carves one from the arena and counts its newlines
+            */////////////////////////////
+                static piece_t * pieceNew(buffer_t * buffer, u_int8_t source, u_int64_t start, u_int64_t length){
+                    piece_t * node = buffer->spare;
+                    if (NULL != node){
+                        buffer->spare = node->right;
+                        node->left = NULL;
+                        node->right = NULL;
+                    }else{
+                        node = arenaAlloc(&buffer->arena, sizeof(piece_t));
+                        if (NULL == node){
+                            return NULL;
+                        }
+                    }
+                    node->priority = randomPriority();
+                    node->source = source;
+                    node->start = start;
+                    node->length = length;
+                    source_t * from = &buffer->sources[source];
+                    node->newlines = sourceNewlinesBefore(from, start + length) - sourceNewlinesBefore(from, start);
+                    pieceUpdate(node);
+                    return node;
+                }
+            /*////////////////////////////
+                Piece walk
+                    in order traversal behind bufferWalk
+            */////////////////////////////
+                static int pieceWalk(buffer_t * buffer, piece_t * node, int (*visit)(void * context, u_int8_t source, const char * data, u_int64_t start, u_int64_t length), void * context){
+                    if (NULL == node){
+                        return 0;
+                    }
+                    int status = pieceWalk(buffer, node->left, visit, context);
+                    if (0 == status){
+                        status = visit(context, node->source, buffer->sources[node->source].data + node->start, node->start, node->length);
+                    }
+                    if (0 == status){
+                        status = pieceWalk(buffer, node->right, visit, context);
+                    }
+                    return status;
+                }
+            /*////////////////////////////
+                Piece free
+                    returns a subtree to the spare list for reuse
+            */////////////////////////////
+                static void pieceFree(buffer_t * buffer, piece_t * node){
+                    if (NULL == node){
+                        return;
+                    }
+                    pieceFree(buffer, node->left);
+                    pieceFree(buffer, node->right);
+                    node->left = NULL;
+                    node->right = buffer->spare;
+                    buffer->spare = node;
+                }
+            /*////////////////////////////
+                Piece update
+                    recomputes subtree totals from the children
+            */////////////////////////////
+                static void pieceUpdate(piece_t * node){
+                    node->total_length = node->length;
+                    node->total_newlines = node->newlines;
+                    if (NULL != node->left){
+                        node->total_length += node->left->total_length;
+                        node->total_newlines += node->left->total_newlines;
+                    }
+                    if (NULL != node->right){
+                        node->total_length += node->right->total_length;
+                        node->total_newlines += node->right->total_newlines;
+                    }
+                }
+            /*////////////////////////////
+                Piece merge
+                    joins two trees where every piece of left precedes right
+            */////////////////////////////
+                static piece_t * pieceMerge(piece_t * left, piece_t * right){
+                    if (NULL == left){
+                        return right;
+                    }
+                    if (NULL == right){
+                        return left;
+                    }
+                    if (left->priority > right->priority){
+                        left->right = pieceMerge(left->right, right);
+                        pieceUpdate(left);
+                        return left;
+                    }
+                    right->left = pieceMerge(left, right->left);
+                    pieceUpdate(right);
+                    return right;
+                }
+            /*////////////////////////////
+                Piece split
+                    splits a tree so left holds the first offset bytes
+                    a piece straddling offset is cut in two using spare
+            */////////////////////////////
+                static void pieceSplit(buffer_t * buffer, piece_t * node, u_int64_t offset, piece_t ** spare, piece_t ** left, piece_t ** right){
+                    if (NULL == node){
+                        *left = NULL;
+                        *right = NULL;
+                        return;
+                    }
+                    u_int64_t left_length = (NULL == node->left) ? 0 : node->left->total_length;
+                    if (offset <= left_length){
+                        pieceSplit(buffer, node->left, offset, spare, left, &node->left);
+                        pieceUpdate(node);
+                        *right = node;
+                    }else if (offset >= left_length + node->length){
+                        pieceSplit(buffer, node->right, offset - left_length - node->length, spare, &node->right, right);
+                        pieceUpdate(node);
+                        *left = node;
+                    }else{
+                        //cut this piece, the tail becomes the first piece of right
+                        u_int64_t cut = offset - left_length;
+                        piece_t * tail = *spare;
+                        *spare = NULL;
+                        source_t * from = &buffer->sources[node->source];
+                        tail->source = node->source;
+                        tail->start = node->start + cut;
+                        tail->length = node->length - cut;
+                        tail->newlines = sourceNewlinesBefore(from, tail->start + tail->length) - sourceNewlinesBefore(from, tail->start);
+                        tail->left = NULL;
+                        tail->right = NULL;
+                        pieceUpdate(tail);
+                        node->length = cut;
+                        node->newlines -= tail->newlines;
+                        *right = pieceMerge(tail, node->right);
+                        node->right = NULL;
+                        pieceUpdate(node);
+                        *left = node;
+                    }
+                }
+            /*////////////////////////////
+                Piece extend
+                    grows the last piece when it ends where the new text starts
+                    returns 0 when the piece was extended
+            */////////////////////////////
+                static int pieceExtend(buffer_t * buffer, piece_t * node, u_int8_t source, u_int64_t start, u_int64_t length, u_int64_t newlines){
+                    if (NULL == node){
+                        return -1;
+                    }
+                    if (NULL != node->right){
+                        if (0 != pieceExtend(buffer, node->right, source, start, length, newlines)){
+                            return -1;
+                        }
+                    }else if ((source != node->source) || (node->start + node->length != start)){
+                        return -1;
+                    }else{
+                        node->length += length;
+                        node->newlines += newlines;
+                    }
+                    pieceUpdate(node);
+                    return 0;
+                }
+            /*////////////////////////////
+                Piece newline offset
+                    returns the document offset of the nth newline
+            */////////////////////////////
+                static u_int64_t pieceNewlineOffset(buffer_t * buffer, u_int64_t newline){
+                    u_int64_t base = 0;
+                    piece_t * node = buffer->root;
+                    while (NULL != node){
+                        u_int64_t left_newlines = (NULL == node->left) ? 0 : node->left->total_newlines;
+                        if (newline < left_newlines){
+                            node = node->left;
+                            continue;
+                        }
+                        newline -= left_newlines;
+                        base += (NULL == node->left) ? 0 : node->left->total_length;
+                        if (newline < node->newlines){
+                            source_t * source = &buffer->sources[node->source];
+                            return base + sourceNewlineAt(source, sourceNewlinesBefore(source, node->start) + newline) - node->start;
+                        }
+                        newline -= node->newlines;
+                        base += node->length;
+                        node = node->right;
+                    }
+                    return base;
+                }
+        /*////////////////////////////
+            Random Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Random priority
+                    xorshift generator for treap priorities
+            */////////////////////////////
+                static u_int32_t randomPriority(){
+                    PRIORITY_SEED ^= PRIORITY_SEED << 13;
+                    PRIORITY_SEED ^= PRIORITY_SEED >> 17;
+                    PRIORITY_SEED ^= PRIORITY_SEED << 5;
+                    return PRIORITY_SEED;
+                }
+//End of file
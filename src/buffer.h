@@ -0,0 +1,94 @@
+/*////////////////////////////
+    Guard
+*/////////////////////////////
+    #ifndef BUFFER_H
+    #define BUFFER_H
+
+/*////////////////////////////
+    Includes
+*/////////////////////////////
+    #include <pthread.h>
+    #include <sys/types.h>
+    #include "arena.h"
+    #include "index.h"
+
+/*////////////////////////////
+    Defines
+*/////////////////////////////
+    #define SOURCE_ORIGINAL     0
+    #define SOURCE_ADDED        1
+    #define SOURCE_COUNT        2
+
+/*////////////////////////////
+    Structs
+*/////////////////////////////
+    struct piece;
+    struct piece{
+        struct piece *          left;       //pieces before this one
+        struct piece *          right;      //pieces after this one
+        u_int32_t               priority;   //treap heap priority
+        u_int8_t                source;     //SOURCE_ORIGINAL or SOURCE_ADDED
+        u_int64_t               start;      //offset into source
+        u_int64_t               length;     //bytes in this piece
+        u_int64_t               newlines;   //newlines in this piece
+        u_int64_t               total_length;//bytes in this subtree
+        u_int64_t               total_newlines;//newlines in this subtree
+    };
+    struct indexer{
+        pthread_t *             threads;    //background indexing workers
+        u_int64_t               thread_count;//workers started
+        pthread_mutex_t         lock;       //guards scanned, committed, active and progress waits
+        pthread_cond_t          progress;   //signalled as chunks are published
+        u_int8_t *              scanned;    //chunks scanned but maybe not yet committed
+        u_int64_t               chunk_count;//chunks in the original
+        u_int64_t               next_chunk; //next chunk to claim, taken atomically
+        u_int64_t               committed;  //chunks stitched into the index
+        u_int64_t               active;     //workers still running
+        u_int8_t                running;    //workers started and not yet joined
+        u_int8_t                done;       //every worker finished, set atomically
+        u_int8_t                cancel;     //ask the workers to stop, set atomically
+        int                     status;     //0 when every chunk was indexed
+    };
+    struct buffer{
+        struct source           sources[SOURCE_COUNT];//immutable original and append only additions
+        struct piece *          root;       //balanced tree of pieces in document order
+        struct piece *          spare;      //released pieces kept for reuse
+        struct arena            arena;      //backing storage for every piece
+        struct indexer          indexer;    //progressive indexing of the original
+    };
+
+/*////////////////////////////
+    Typedefs
+*/////////////////////////////
+    typedef struct piece        piece_t;
+    typedef struct indexer      indexer_t;
+    typedef struct buffer       buffer_t;
+
+/*////////////////////////////
+    Prototypes
+*/////////////////////////////
+    //Lifetime
+        int bufferOpen(buffer_t * buffer, char * data, u_int64_t size, u_int64_t jobs);
+        int bufferOpenView(buffer_t * buffer, char * data, u_int64_t size, u_int64_t jobs, u_int64_t budget);
+        void bufferClose(buffer_t * buffer);
+    //Indexing
+        int bufferIndexing(buffer_t * buffer);
+        u_int64_t bufferIndexedBytes(buffer_t * buffer);
+        int bufferFinishIndex(buffer_t * buffer);
+    //Queries
+        u_int64_t bufferLength(buffer_t * buffer);
+        u_int64_t bufferLineCount(buffer_t * buffer);
+        u_int64_t bufferLineStart(buffer_t * buffer, u_int64_t line);
+        u_int64_t bufferLineLength(buffer_t * buffer, u_int64_t line);
+        u_int64_t bufferLineOfOffset(buffer_t * buffer, u_int64_t offset);
+        u_int64_t bufferRead(buffer_t * buffer, u_int64_t offset, char * dest, u_int64_t length);
+        const char * bufferSpan(buffer_t * buffer, u_int64_t offset, u_int64_t * start, u_int64_t * length);
+        int bufferWalk(buffer_t * buffer, int (*visit)(void * context, u_int8_t source, const char * data, u_int64_t start, u_int64_t length), void * context);
+        u_int64_t bufferMemory(buffer_t * buffer);
+    //Editing
+        int bufferInsert(buffer_t * buffer, u_int64_t offset, const char * text, u_int64_t length);
+        int bufferDelete(buffer_t * buffer, u_int64_t offset, u_int64_t length);
+        int bufferGrow(buffer_t * buffer, u_int64_t size);
+
+    #endif
+//End of file
@@ -0,0 +1,467 @@
+/*////////////////////////////
+    Includes
+*/////////////////////////////
+    #include <string.h>
+    #include <stdlib.h>
+    #include "macros.h"
+    #include "arena.h"
+    #include "columns.h"
+
+/*////////////////////////////
+    Defines
+*/////////////////////////////
+    #define COLUMN_END          ((u_int64_t)-1)
+    #define STEP_WINDOW         64
+
+/*////////////////////////////
+    Prototypes
+*/////////////////////////////
+    //Measuring
+        static column_line_t * columnsLine(columns_t * columns, buffer_t * buffer, u_int64_t line, u_int64_t start, u_int64_t length);
+        static column_map_t * columnsMap(columns_t * columns, u_int64_t line, u_int64_t length);
+        static int columnsExtend(columns_t * columns, buffer_t * buffer, column_map_t * map, u_int64_t start, u_int64_t length, u_int64_t offset, u_int64_t column);
+        static int columnsBack(columns_t * columns, buffer_t * buffer, u_int64_t start, u_int64_t offset, column_hint_t * hint, u_int64_t * column);
+        static u_int64_t columnsWalk(columns_t * columns, buffer_t * buffer, u_int64_t start, u_int64_t length, u_int64_t * column, u_int64_t target, u_int8_t * plain);
+
+/*////////////////////////////
+    Globals
+*/////////////////////////////
+    u_int64_t   MIN_CHECKPOINT_CAPACITY =   64;
+
+/*////////////////////////////
+    Functions
+*/////////////////////////////
+    /*////////////////////////////
+        Public Functions
+    */////////////////////////////
+        /*////////////////////////////
+            Lifetime Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Columns init
+            */////////////////////////////
+                void columnsInit(columns_t * columns){
+                    memset(columns, 0, sizeof(columns_t));
+                    metricsInit(&columns->metrics);
+                }
+            /*////////////////////////////
+                Columns release
+            */////////////////////////////
+                void columnsRelease(columns_t * columns){
+                    for (u_int64_t iter = 0; iter < COLUMN_LINES; iter++){
+                        free(columns->maps[iter].checkpoints);
+                    }
+                    metricsRelease(&columns->metrics);
+                    columnsInit(columns);
+                }
+        /*////////////////////////////
+            Edit Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Columns edit
+                    line, changed from byte from on, and the removed lines
+                    after it became line and added lines
+            */////////////////////////////
+                void columnsEdit(columns_t * columns, u_int64_t line, u_int64_t from, u_int64_t removed, u_int64_t added){
+                    for (u_int64_t iter = 0; iter < COLUMN_LINES; iter++){
+                        column_map_t * map = &columns->maps[iter];
+                        if ((!map->valid) || (map->line < line)){
+                            continue;
+                        }
+                        if (map->line == line){
+                            //checkpoints a character clear of the edit still
+                            //hold, the last has no measured chunk after it
+                            while ((0 < map->count) && (map->checkpoints[map->count - 1].offset + MAX_CHAR_SIZE > from)){
+                                map->count--;
+                            }
+                            if (0 < map->count){
+                                map->checkpoints[map->count - 1].plain = 0;
+                            }
+                            if (map->hint.offset + MAX_CHAR_SIZE > from){
+                                memset(&map->hint, 0, sizeof(column_hint_t));
+                            }
+                        }else if (map->line <= line + removed){
+                            map->valid = 0;
+                        }else{
+                            map->line = map->line - removed + added;
+                        }
+                    }
+                    //short lines are found by number so those that moved go too
+                    for (u_int64_t iter = 0; iter < COLUMN_CACHE; iter++){
+                        column_line_t * entry = &columns->lines[iter];
+                        if ((entry->line == line) || ((entry->line > line) && ((0 != removed) || (0 != added)))){
+                            entry->valid = 0;
+                        }
+                    }
+                }
+            /*////////////////////////////
+                Columns truncate
+                    forgets what was measured from line on, for edits whose
+                    extent is not known
+            */////////////////////////////
+                void columnsTruncate(columns_t * columns, u_int64_t line){
+                    for (u_int64_t iter = 0; iter < COLUMN_LINES; iter++){
+                        if (columns->maps[iter].line >= line){
+                            columns->maps[iter].valid = 0;
+                        }
+                    }
+                    for (u_int64_t iter = 0; iter < COLUMN_CACHE; iter++){
+                        if (columns->lines[iter].line >= line){
+                            columns->lines[iter].valid = 0;
+                        }
+                    }
+                }
+        /*////////////////////////////
+            Measuring Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Columns of offset
+                    returns the column a byte of a line starts at, offsets
+                    past the end giving the line's width and those inside a
+                    character the column after it
+            */////////////////////////////
+                u_int64_t columnsOfOffset(columns_t * columns, buffer_t * buffer, u_int64_t line, u_int64_t offset){
+                    u_int64_t start = bufferLineStart(buffer, line);
+                    u_int64_t length = bufferLineLength(buffer, line);
+                    if (offset > length){
+                        offset = length;
+                    }
+                    u_int64_t column = 0;
+                    u_int64_t from = 0;
+                    column_line_t * entry = columnsLine(columns, buffer, line, start, length);
+                    column_map_t * map = (NULL != entry) ? NULL : columnsMap(columns, line, length);
+                    if ((NULL != entry) && ((entry->plain) || (offset == length))){
+                        return (offset == length) ? entry->width : offset;
+                    }
+                    column_hint_t * hint = (NULL != entry) ? &entry->hint : NULL;
+                    if ((NULL != map) && (0 == columnsExtend(columns, buffer, map, start, length, offset, COLUMN_END))){
+                        hint = &map->hint;
+                        u_int64_t index = offset / COLUMN_STRIDE;
+                        if (index >= map->count){
+                            index = map->count - 1;
+                        }
+                        if ((0 < index) && (map->checkpoints[index].offset > offset)){
+                            index--;
+                        }
+                        checkpoint_t * checkpoint = &map->checkpoints[index];
+                        if ((checkpoint->plain) && (index + 1 < map->count) && (offset < map->checkpoints[index + 1].offset)){
+                            return checkpoint->column + offset - checkpoint->offset;
+                        }
+                        from = checkpoint->offset;
+                        column = checkpoint->column;
+                    }
+                    //the cursor moves a character at a time, so the last
+                    //lookup on the line is usually just behind or ahead
+                    if (NULL != hint){
+                        if ((hint->offset <= offset) && (hint->offset >= from)){
+                            from = hint->offset;
+                            column = hint->column;
+                        }else if ((hint->offset > offset) && (0 == columnsBack(columns, buffer, start, offset, hint, &column))){
+                            hint->offset = offset;
+                            hint->column = column;
+                            return column;
+                        }
+                    }
+                    if (offset > from){
+                        from += columnsWalk(columns, buffer, start + from, offset - from, &column, COLUMN_END, NULL);
+                    }
+                    if (NULL != hint){
+                        hint->offset = from;
+                        hint->column = column;
+                    }
+                    return column;
+                }
+            /*////////////////////////////
+                Columns offset of
+                    returns the byte of a line starting the character drawn
+                    over column, with begin set to the column it starts at,
+                    or the line's length and width when it is narrower
+            */////////////////////////////
+                u_int64_t columnsOffsetOf(columns_t * columns, buffer_t * buffer, u_int64_t line, u_int64_t column, u_int64_t * begin){
+                    u_int64_t start = bufferLineStart(buffer, line);
+                    u_int64_t length = bufferLineLength(buffer, line);
+                    u_int64_t from = 0;
+                    *begin = 0;
+                    column_line_t * entry = columnsLine(columns, buffer, line, start, length);
+                    column_map_t * map = (NULL != entry) ? NULL : columnsMap(columns, line, length);
+                    if ((NULL != entry) && (entry->plain)){
+                        *begin = (column > length) ? length : column;
+                        return *begin;
+                    }
+                    column_hint_t * hint = (NULL != entry) ? &entry->hint : NULL;
+                    if ((NULL != map) && (0 == columnsExtend(columns, buffer, map, start, length, length, column))){
+                        hint = &map->hint;
+                        //last checkpoint at or before the column
+                        u_int64_t low = 0;
+                        u_int64_t high = map->count;
+                        while (low + 1 < high){
+                            u_int64_t mid = low + (high - low) / 2;
+                            if (map->checkpoints[mid].column <= column){
+                                low = mid;
+                            }else{
+                                high = mid;
+                            }
+                        }
+                        checkpoint_t * checkpoint = &map->checkpoints[low];
+                        if ((checkpoint->plain) && (low + 1 < map->count) && (column < map->checkpoints[low + 1].column)){
+                            *begin = column;
+                            return checkpoint->offset + column - checkpoint->column;
+                        }
+                        from = checkpoint->offset;
+                        *begin = checkpoint->column;
+                    }
+                    if ((NULL != hint) && (hint->column <= column) && (hint->offset >= from)){
+                        from = hint->offset;
+                        *begin = hint->column;
+                    }
+                    from += columnsWalk(columns, buffer, start + from, length - from, begin, column, NULL);
+                    if (NULL != hint){
+                        hint->offset = from;
+                        hint->column = *begin;
+                    }
+                    return from;
+                }
+        /*////////////////////////////
+            Stepping Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Columns next
+                    returns the offset after the character at offset and the
+                    marks drawn over it, a newline being a character
+            */////////////////////////////
+                u_int64_t columnsNext(columns_t * columns, buffer_t * buffer, u_int64_t offset){
+                    char text[STEP_WINDOW];
+                    u_int64_t count = bufferRead(buffer, offset, text, STEP_WINDOW);
+                    if (0 == count){
+                        return offset;
+                    }
+                    u_int64_t cells = 0;
+                    u_int64_t glyph_length = 0;
+                    const char * glyph = NULL;
+                    u_int64_t position = metricsChar(&columns->metrics, text, count, 0, &cells, &glyph, &glyph_length);
+                    while (('\n' != text[0]) && (position < count) && ('\n' != text[position])){
+                        u_int64_t size = metricsChar(&columns->metrics, text + position, count - position, 0, &cells, &glyph, &glyph_length);
+                        if (0 != cells){
+                            break;
+                        }
+                        position += size;
+                    }
+                    return offset + ((position > count) ? count : position);
+                }
+            /*////////////////////////////
+                Columns previous
+                    returns the offset of the character before offset, along
+                    with the marks drawn over it
+            */////////////////////////////
+                u_int64_t columnsPrevious(columns_t * columns, buffer_t * buffer, u_int64_t offset){
+                    char text[STEP_WINDOW];
+                    u_int64_t window = (offset > STEP_WINDOW) ? STEP_WINDOW : offset;
+                    window = bufferRead(buffer, offset - window, text, window);
+                    u_int64_t position = window;
+                    u_int64_t cells = 0;
+                    u_int64_t glyph_length = 0;
+                    const char * glyph = NULL;
+                    while (0 < position){
+                        //back over continuation bytes to a lead the sequence decodes from
+                        u_int64_t back = position - 1;
+                        if (columns->metrics.utf8){
+                            while ((0 < back) && (MAX_CHAR_SIZE > position - back) && (0x80 == (text[back] & 0xc0))){
+                                back--;
+                            }
+                        }
+                        if (position - back != metricsChar(&columns->metrics, text + back, position - back, 0, &cells, &glyph, &glyph_length)){
+                            back = position - 1;
+                            metricsChar(&columns->metrics, text + back, 1, 0, &cells, &glyph, &glyph_length);
+                        }
+                        position = back;
+                        if ((0 != cells) || (0 == position) || ('\n' == text[position - 1])){
+                            break;
+                        }
+                    }
+                    return offset - window + position;
+                }
+
+    /*////////////////////////////
+        Private Functions
+    */////////////////////////////
+        /*////////////////////////////
+            Measuring Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Columns line
+                    measures a short line once, noting when it is plain ascii
+                    so its columns are its offsets
+                    returns NULL for lines too long to measure whole
+            */////////////////////////////
+                static column_line_t * columnsLine(columns_t * columns, buffer_t * buffer, u_int64_t line, u_int64_t start, u_int64_t length){
+                    if (length >= COLUMN_STRIDE){
+                        return NULL;
+                    }
+                    column_line_t * entry = &columns->lines[line % COLUMN_CACHE];
+                    if ((entry->valid) && (entry->line == line) && (entry->length == length)){
+                        return entry;
+                    }
+                    u_int64_t count = bufferRead(buffer, start, columns->chunk, length);
+                    entry->line = line;
+                    entry->length = length;
+                    memset(&entry->hint, 0, sizeof(column_hint_t));
+                    entry->plain = (count == length) && (metricsPlain(columns->chunk, count) == count);
+                    entry->width = 0;
+                    if (entry->plain){
+                        entry->width = length;
+                    }else{
+                        columnsWalk(columns, buffer, start, length, &entry->width, COLUMN_END, NULL);
+                    }
+                    entry->valid = 1;
+                    return entry;
+                }
+            /*////////////////////////////
+                Columns map
+                    finds the checkpoints of a line, taking over the least
+                    recently used map when it has none
+                    returns NULL for lines short enough to walk whole
+            */////////////////////////////
+                static column_map_t * columnsMap(columns_t * columns, u_int64_t line, u_int64_t length){
+                    if (length < COLUMN_STRIDE){
+                        return NULL;
+                    }
+                    column_map_t * oldest = &columns->maps[0];
+                    columns->tick++;
+                    for (u_int64_t iter = 0; iter < COLUMN_LINES; iter++){
+                        column_map_t * map = &columns->maps[iter];
+                        if ((map->valid) && (map->line == line)){
+                            map->used = columns->tick;
+                            return map;
+                        }
+                        if ((oldest->valid) && ((!map->valid) || (map->used < oldest->used))){
+                            oldest = map;
+                        }
+                    }
+                    oldest->line = line;
+                    oldest->count = 0;
+                    memset(&oldest->hint, 0, sizeof(column_hint_t));
+                    oldest->used = columns->tick;
+                    oldest->valid = 1;
+                    return oldest;
+                }
+            /*////////////////////////////
+                Columns extend
+                    measures checkpoints until one lies around offset or
+                    past column, or the line ends
+                    returns 0 once the checkpoints reach that far
+            */////////////////////////////
+                static int columnsExtend(columns_t * columns, buffer_t * buffer, column_map_t * map, u_int64_t start, u_int64_t length, u_int64_t offset, u_int64_t column){
+                    while (1){
+                        if (map->count == map->capacity){
+                            u_int64_t capacity = growCapacity(map->capacity, map->count + 1, MIN_CHECKPOINT_CAPACITY);
+                            checkpoint_t * checkpoints = realloc(map->checkpoints, capacity * sizeof(checkpoint_t));
+                            if (NULL == checkpoints){
+                                map->valid = 0;
+                                return -1;
+                            }
+                            map->checkpoints = checkpoints;
+                            map->capacity = capacity;
+                        }
+                        //the line starts at column 0
+                        if (0 == map->count){
+                            memset(&map->checkpoints[map->count++], 0, sizeof(checkpoint_t));
+                        }
+                        checkpoint_t * last = &map->checkpoints[map->count - 1];
+                        if ((map->count - 1 >= offset / COLUMN_STRIDE) || (last->column > column) || (map->count * COLUMN_STRIDE > length)){
+                            return 0;
+                        }
+                        checkpoint_t next;
+                        next.column = last->column;
+                        next.plain = 0;
+                        last->plain = 1;
+                        next.offset = last->offset + columnsWalk(columns, buffer, start + last->offset, map->count * COLUMN_STRIDE - last->offset, &next.column, COLUMN_END, &last->plain);
+                        map->checkpoints[map->count++] = next;
+                    }
+                }
+            /*////////////////////////////
+                Columns back
+                    measures a character boundary a little before the hint
+                    from the widths between them, which only works without
+                    tabs there since their width depends on where they start
+                    returns 0 with column set, -1 when it has to be walked
+            */////////////////////////////
+                static int columnsBack(columns_t * columns, buffer_t * buffer, u_int64_t start, u_int64_t offset, column_hint_t * hint, u_int64_t * column){
+                    char text[STEP_WINDOW];
+                    u_int64_t distance = hint->offset - offset;
+                    if ((STEP_WINDOW < distance) || (distance != bufferRead(buffer, start + offset, text, distance))){
+                        return -1;
+                    }
+                    if ((NULL != memchr(text, '\t', distance)) || ((columns->metrics.utf8) && (0x80 == (text[0] & 0xc0)))){
+                        return -1;
+                    }
+                    u_int64_t width = 0;
+                    u_int64_t position = 0;
+                    while (position < distance){
+                        u_int64_t cells = 0;
+                        u_int64_t glyph_length = 0;
+                        const char * glyph = NULL;
+                        position += metricsChar(&columns->metrics, text + position, distance - position, 0, &cells, &glyph, &glyph_length);
+                        width += cells;
+                    }
+                    if ((position != distance) || (width > hint->column)){
+                        return -1;
+                    }
+                    *column = hint->column - width;
+                    return 0;
+                }
+            /*////////////////////////////
+                Columns walk
+                    advances column over the characters starting in the
+                    length bytes at start, stopping before the first whose
+                    cells would reach past target, runs of plain ascii are
+                    skipped whole, plain is cleared when any byte was not
+                    returns the bytes walked over, a character running past
+                    length included
+            */////////////////////////////
+                static u_int64_t columnsWalk(columns_t * columns, buffer_t * buffer, u_int64_t start, u_int64_t length, u_int64_t * column, u_int64_t target, u_int8_t * plain){
+                    u_int64_t walked = 0;
+                    while (walked < length){
+                        u_int64_t limit = length - walked;
+                        if (limit > COLUMN_STRIDE){
+                            limit = COLUMN_STRIDE;
+                        }
+                        //a character starting before limit may end after it
+                        u_int64_t count = bufferRead(buffer, start + walked, columns->chunk, limit + MAX_CHAR_SIZE - 1);
+                        if (0 == count){
+                            break;
+                        }
+                        if (limit > count){
+                            limit = count;
+                        }
+                        u_int64_t iter = 0;
+                        while (iter < limit){
+                            u_int8_t byte = columns->chunk[iter];
+                            u_int64_t run = ((' ' <= byte) && (0x7f > byte)) ? metricsPlain(columns->chunk + iter, limit - iter) : 0;
+                            if (0 != run){
+                                if (*column + run > target){
+                                    run = target - *column;
+                                    *column += run;
+                                    return walked + iter + run;
+                                }
+                                *column += run;
+                                iter += run;
+                                continue;
+                            }
+                            if (NULL != plain){
+                                *plain = 0;
+                            }
+                            u_int64_t cells = 0;
+                            u_int64_t glyph_length = 0;
+                            const char * glyph = NULL;
+                            u_int64_t size = metricsChar(&columns->metrics, columns->chunk + iter, count - iter, *column, &cells, &glyph, &glyph_length);
+                            if (*column + cells > target){
+                                return walked + iter;
+                            }
+                            *column += cells;
+                            iter += size;
+                        }
+                        walked += iter;
+                    }
+                    return walked;
+                }
+//End of file
@@ -0,0 +1,84 @@
+/*////////////////////////////
+    Guard
+*/////////////////////////////
+    #ifndef COLUMNS_H
+    #define COLUMNS_H
+
+/*////////////////////////////
+    Includes
+*/////////////////////////////
+    #include <sys/types.h>
+    #include "buffer.h"
+    #include "metrics.h"
+
+/*////////////////////////////
+    Defines
+*/////////////////////////////
+    #define COLUMN_STRIDE       4096
+    #define COLUMN_LINES        16
+    #define COLUMN_CACHE        1024
+
+/*////////////////////////////
+    Structs
+*/////////////////////////////
+    struct checkpoint{
+        u_int64_t               offset;     //first character boundary from a multiple of COLUMN_STRIDE on
+        u_int64_t               column;     //column the character there starts at
+        u_int8_t                plain;      //bytes up to the next checkpoint are printable ascii
+    };
+    struct column_hint{
+        u_int64_t               offset;     //character boundary measured last, so nearby lookups start there
+        u_int64_t               column;     //column it starts at
+    };
+    struct column_map{
+        u_int64_t               line;       //line the checkpoints were measured on
+        struct checkpoint *     checkpoints;//every COLUMN_STRIDE bytes or so of the line
+        struct column_hint      hint;       //where the line was measured last
+        u_int64_t               count;      //checkpoints measured
+        u_int64_t               capacity;   //checkpoints allocated
+        u_int64_t               used;       //lookup tick, the oldest map is reused first
+        u_int8_t                valid;      //map belongs to a line
+    };
+    struct column_line{
+        u_int64_t               line;       //line measured
+        u_int64_t               length;     //bytes it had
+        u_int64_t               width;      //cells it takes
+        struct column_hint      hint;       //where the line was measured last
+        u_int8_t                plain;      //every byte is printable ascii, so offsets are columns
+        u_int8_t                valid;      //entry belongs to a line
+    };
+    struct columns{
+        metrics_t               metrics;    //how characters are decoded and measured
+        struct column_map       maps[COLUMN_LINES];//checkpoints of the long lines looked at last
+        struct column_line      lines[COLUMN_CACHE];//short lines measured, by line modulo COLUMN_CACHE
+        u_int64_t               tick;       //lookups so far
+        char                    chunk[COLUMN_STRIDE + MAX_CHAR_SIZE];//bytes being measured
+    };
+
+/*////////////////////////////
+    Typedefs
+*/////////////////////////////
+    typedef struct checkpoint   checkpoint_t;
+    typedef struct column_hint  column_hint_t;
+    typedef struct column_map   column_map_t;
+    typedef struct column_line  column_line_t;
+    typedef struct columns      columns_t;
+
+/*////////////////////////////
+    Prototypes
+*/////////////////////////////
+    //Lifetime
+        void columnsInit(columns_t * columns);
+        void columnsRelease(columns_t * columns);
+    //Edits
+        void columnsEdit(columns_t * columns, u_int64_t line, u_int64_t from, u_int64_t removed, u_int64_t added);
+        void columnsTruncate(columns_t * columns, u_int64_t line);
+    //Measuring
+        u_int64_t columnsOfOffset(columns_t * columns, buffer_t * buffer, u_int64_t line, u_int64_t offset);
+        u_int64_t columnsOffsetOf(columns_t * columns, buffer_t * buffer, u_int64_t line, u_int64_t column, u_int64_t * begin);
+    //Stepping
+        u_int64_t columnsNext(columns_t * columns, buffer_t * buffer, u_int64_t offset);
+        u_int64_t columnsPrevious(columns_t * columns, buffer_t * buffer, u_int64_t offset);
+
+    #endif
+//End of file
@@ -0,0 +1,314 @@
+/*////////////////////////////
+    Includes
+*/////////////////////////////
+    #include <string.h>
+    #include <stdlib.h>
+    #include "macros.h"
+    #include "arena.h"
+    #include "delta.h"
+
+/*////////////////////////////
+    Prototypes
+*/////////////////////////////
+    //Comparing
+        static u_int64_t commonPrefix(buffer_t * buffer, const char * data, u_int64_t size);
+        static u_int64_t commonSuffix(buffer_t * buffer, const char * data, u_int64_t size, u_int64_t prefix);
+        static u_int64_t firstDifference(const char * left, const char * right, u_int64_t length);
+        static u_int64_t equalTail(const char * left, const char * right, u_int64_t length);
+    //Matching
+        static int matchBlocks(delta_t * delta, const char * old, u_int64_t old_size, const char * new, u_int64_t new_size, u_int64_t base);
+        static u_int64_t blockHash(const char * data);
+        static int pushHunk(delta_t * delta, u_int64_t old_offset, u_int64_t old_length, u_int64_t new_offset, u_int64_t new_length);
+
+/*////////////////////////////
+    Globals
+*/////////////////////////////
+    u_int64_t   MIN_HUNK_CAPACITY =     16;
+    u_int64_t   COMPARE_STEP =          4096;
+    u_int64_t   HASH_MULTIPLIER =       0x100000001b3;
+    u_int64_t   HASH_SPREAD =           0x9e3779b97f4a7c15;
+    u_int64_t   MAX_PROBES =            32;
+
+/*////////////////////////////
+    Functions
+*/////////////////////////////
+    /*////////////////////////////
+        Public Functions
+    */////////////////////////////
+        /*////////////////////////////
+            Lifetime Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Delta init
+            */////////////////////////////
+                void deltaInit(delta_t * delta){
+                    memset(delta, 0, sizeof(delta_t));
+                }
+            /*////////////////////////////
+                Delta release
+            */////////////////////////////
+                void deltaRelease(delta_t * delta){
+                    free(delta->hunks);
+                    deltaInit(delta);
+                }
+        /*////////////////////////////
+            Comparing Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Delta compute
+                    finds the hunks that turn the buffer into data, the common
+                    prefix and suffix are skipped at memcmp speed and what lies
+                    between is matched block by block with a rolling hash
+                    returns 0 on success, 1 when the differing middle is larger
+                    than limit bytes, -1 when out of memory
+            */////////////////////////////
+                int deltaCompute(delta_t * delta, buffer_t * buffer, const char * data, u_int64_t size, u_int64_t limit){
+                    delta->count = 0;
+                    u_int64_t old_size = bufferLength(buffer);
+                    u_int64_t prefix = commonPrefix(buffer, data, size);
+                    u_int64_t suffix = commonSuffix(buffer, data, size, prefix);
+                    u_int64_t old_middle = old_size - prefix - suffix;
+                    u_int64_t new_middle = size - prefix - suffix;
+                    if ((0 == old_middle) && (0 == new_middle)){
+                        return 0;
+                    }
+                    //a lone insertion or deletion has nothing to match
+                    if ((old_middle < DELTA_BLOCK) || (new_middle < DELTA_BLOCK)){
+                        return pushHunk(delta, prefix, old_middle, prefix, new_middle);
+                    }
+                    if ((old_middle > limit) || (new_middle > limit)){
+                        return 1;
+                    }
+                    //the old middle may span many pieces, so it is copied out
+                    char * old = malloc(old_middle);
+                    if (NULL == old){
+                        return -1;
+                    }
+                    bufferRead(buffer, prefix, old, old_middle);
+                    int status = matchBlocks(delta, old, old_middle, data + prefix, new_middle, prefix);
+                    free(old);
+                    return status;
+                }
+
+    /*////////////////////////////
+        Private Functions
+    */////////////////////////////
+        /*////////////////////////////
+            Comparing Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Common prefix
+                    returns the leading bytes the buffer and data share
+            */////////////////////////////
+                static u_int64_t commonPrefix(buffer_t * buffer, const char * data, u_int64_t size){
+                    u_int64_t offset = 0;
+                    u_int64_t start = 0;
+                    u_int64_t length = 0;
+                    const char * span = NULL;
+                    while ((offset < size) && (NULL != (span = bufferSpan(buffer, offset, &start, &length)))){
+                        u_int64_t count = start + length - offset;
+                        if (count > size - offset){
+                            count = size - offset;
+                        }
+                        u_int64_t equal = firstDifference(span + offset - start, data + offset, count);
+                        offset += equal;
+                        if (equal < count){
+                            break;
+                        }
+                    }
+                    return offset;
+                }
+            /*////////////////////////////
+                Common suffix
+                    returns the trailing bytes the buffer and data share
+                    without reaching back into prefix
+            */////////////////////////////
+                static u_int64_t commonSuffix(buffer_t * buffer, const char * data, u_int64_t size, u_int64_t prefix){
+                    u_int64_t old_end = bufferLength(buffer);
+                    u_int64_t most = ((old_end < size) ? old_end : size) - prefix;
+                    u_int64_t suffix = 0;
+                    u_int64_t start = 0;
+                    u_int64_t length = 0;
+                    const char * span = NULL;
+                    while ((suffix < most) && (NULL != (span = bufferSpan(buffer, old_end - suffix - 1, &start, &length)))){
+                        u_int64_t count = old_end - suffix - start;
+                        if (count > most - suffix){
+                            count = most - suffix;
+                        }
+                        u_int64_t equal = equalTail(span + old_end - suffix - start, data + size - suffix, count);
+                        suffix += equal;
+                        if (equal < count){
+                            break;
+                        }
+                    }
+                    return suffix;
+                }
+            /*////////////////////////////
+                First difference
+                    returns the bytes left and right share from their start
+            */////////////////////////////
+                static u_int64_t firstDifference(const char * left, const char * right, u_int64_t length){
+                    u_int64_t offset = 0;
+                    while (offset < length){
+                        u_int64_t step = (length - offset < COMPARE_STEP) ? length - offset : COMPARE_STEP;
+                        if (0 != memcmp(left + offset, right + offset, step)){
+                            while (left[offset] == right[offset]){
+                                offset++;
+                            }
+                            return offset;
+                        }
+                        offset += step;
+                    }
+                    return length;
+                }
+            /*////////////////////////////
+                Equal tail
+                    returns the bytes shared going back from the ends left and
+                    right point just past, looking at no more than length
+            */////////////////////////////
+                static u_int64_t equalTail(const char * left, const char * right, u_int64_t length){
+                    u_int64_t offset = 0;
+                    while (offset < length){
+                        u_int64_t step = (length - offset < COMPARE_STEP) ? length - offset : COMPARE_STEP;
+                        if (0 != memcmp(left - offset - step, right - offset - step, step)){
+                            while (left[-(int64_t)offset - 1] == right[-(int64_t)offset - 1]){
+                                offset++;
+                            }
+                            return offset;
+                        }
+                        offset += step;
+                    }
+                    return length;
+                }
+        /*////////////////////////////
+            Matching Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Match blocks
+                    hashes old in aligned blocks and rolls a window over new,
+                    every verified block match is grown both ways and what
+                    lies between matches becomes a hunk, base being where both
+                    ranges start in the document
+                    returns 0 on success
+            */////////////////////////////
+                static int matchBlocks(delta_t * delta, const char * old, u_int64_t old_size, const char * new, u_int64_t new_size, u_int64_t base){
+                    u_int64_t blocks = old_size / DELTA_BLOCK;
+                    u_int64_t bits = 1;
+                    while (((u_int64_t)1 << bits) < 2 * blocks){
+                        bits++;
+                    }
+                    u_int64_t mask = ((u_int64_t)1 << bits) - 1;
+                    //slots hold a block number plus one, 0 being empty, a block
+                    //is dropped past MAX_PROBES so repeated text stays linear
+                    u_int64_t * slots = calloc(mask + 1, sizeof(u_int64_t));
+                    u_int64_t * hashes = malloc(blocks * sizeof(u_int64_t));
+                    if ((NULL == slots) || (NULL == hashes)){
+                        free(slots);
+                        free(hashes);
+                        return -1;
+                    }
+                    for (u_int64_t block = 0; block < blocks; block++){
+                        hashes[block] = blockHash(old + block * DELTA_BLOCK);
+                        u_int64_t slot = (hashes[block] * HASH_SPREAD) >> (64 - bits);
+                        u_int64_t probes = 0;
+                        while ((0 != slots[slot]) && (++probes < MAX_PROBES)){
+                            slot = (slot + 1) & mask;
+                        }
+                        if (0 == slots[slot]){
+                            slots[slot] = block + 1;
+                        }
+                    }
+                    //weight of the byte leaving the window
+                    u_int64_t leaving = 1;
+                    for (u_int64_t iter = 1; iter < DELTA_BLOCK; iter++){
+                        leaving *= HASH_MULTIPLIER;
+                    }
+                    int status = 0;
+                    u_int64_t old_done = 0;
+                    u_int64_t new_done = 0;
+                    u_int64_t window = 0;
+                    u_int64_t hash = blockHash(new);
+                    while (window + DELTA_BLOCK <= new_size){
+                        //the first block at or past old_done holding the window
+                        u_int64_t found = blocks;
+                        u_int64_t slot = (hash * HASH_SPREAD) >> (64 - bits);
+                        for (u_int64_t probes = 0; (probes < MAX_PROBES) && (0 != slots[slot]); probes++, slot = (slot + 1) & mask){
+                            u_int64_t block = slots[slot] - 1;
+                            if ((hashes[block] == hash) && (block * DELTA_BLOCK >= old_done) && (block < found)
+                                && (0 == memcmp(old + block * DELTA_BLOCK, new + window, DELTA_BLOCK))){
+                                found = block;
+                            }
+                        }
+                        if (found == blocks){
+                            if (window + DELTA_BLOCK == new_size){
+                                break;
+                            }
+                            hash = (hash - (u_int8_t)new[window] * leaving) * HASH_MULTIPLIER + (u_int8_t)new[window + DELTA_BLOCK];
+                            window++;
+                            continue;
+                        }
+                        u_int64_t old_start = found * DELTA_BLOCK;
+                        u_int64_t new_start = window;
+                        while ((old_start > old_done) && (new_start > new_done) && (old[old_start - 1] == new[new_start - 1])){
+                            old_start--;
+                            new_start--;
+                        }
+                        u_int64_t old_end = found * DELTA_BLOCK + DELTA_BLOCK;
+                        u_int64_t new_end = window + DELTA_BLOCK;
+                        while ((old_end < old_size) && (new_end < new_size) && (old[old_end] == new[new_end])){
+                            old_end++;
+                            new_end++;
+                        }
+                        if ((old_start > old_done) || (new_start > new_done)){
+                            if (0 != (status = pushHunk(delta, base + old_done, old_start - old_done, base + new_done, new_start - new_done))){
+                                break;
+                            }
+                        }
+                        old_done = old_end;
+                        new_done = new_end;
+                        window = new_end;
+                        if (window + DELTA_BLOCK <= new_size){
+                            hash = blockHash(new + window);
+                        }
+                    }
+                    if ((0 == status) && ((old_done < old_size) || (new_done < new_size))){
+                        status = pushHunk(delta, base + old_done, old_size - old_done, base + new_done, new_size - new_done);
+                    }
+                    free(slots);
+                    free(hashes);
+                    return status;
+                }
+            /*////////////////////////////
+                Block hash
+                    polynomial hash of a block, which rolls by one byte with a
+                    multiply and two adds
+            */////////////////////////////
+                static u_int64_t blockHash(const char * data){
+                    u_int64_t hash = 0;
+                    for (u_int64_t iter = 0; iter < DELTA_BLOCK; iter++){
+                        hash = hash * HASH_MULTIPLIER + (u_int8_t)data[iter];
+                    }
+                    return hash;
+                }
+            /*////////////////////////////
+                Push hunk
+                    returns 0 on success
+            */////////////////////////////
+                static int pushHunk(delta_t * delta, u_int64_t old_offset, u_int64_t old_length, u_int64_t new_offset, u_int64_t new_length){
+                    if (delta->count == delta->capacity){
+                        u_int64_t capacity = growCapacity(delta->capacity, delta->count + 1, MIN_HUNK_CAPACITY);
+                        hunk_t * hunks = realloc(delta->hunks, capacity * sizeof(hunk_t));
+                        if (NULL == hunks){
+                            return -1;
+                        }
+                        delta->hunks = hunks;
+                        delta->capacity = capacity;
+                    }
+                    hunk_t * hunk = &delta->hunks[delta->count++];
+                    hunk->old_offset = old_offset;
+                    hunk->old_length = old_length;
+                    hunk->new_offset = new_offset;
+                    hunk->new_length = new_length;
+                    return 0;
+                }
+//End of file
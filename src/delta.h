@@ -0,0 +1,49 @@
+/*////////////////////////////
+    Guard
+*/////////////////////////////
+    #ifndef DELTA_H
+    #define DELTA_H
+
+/*////////////////////////////
+    Includes
+*/////////////////////////////
+    #include <sys/types.h>
+    #include "buffer.h"
+
+/*////////////////////////////
+    Defines
+*/////////////////////////////
+    #define DELTA_BLOCK         64
+
+/*////////////////////////////
+    Structs
+*/////////////////////////////
+    struct hunk{
+        u_int64_t               old_offset; //where the replaced bytes start in the buffer
+        u_int64_t               old_length; //bytes replaced
+        u_int64_t               new_offset; //where the replacement starts in the new contents
+        u_int64_t               new_length; //bytes of replacement
+    };
+    struct delta{
+        struct hunk *           hunks;      //differences in document order, never overlapping
+        u_int64_t               count;      //hunks in use
+        u_int64_t               capacity;   //hunks allocated
+    };
+
+/*////////////////////////////
+    Typedefs
+*/////////////////////////////
+    typedef struct hunk         hunk_t;
+    typedef struct delta        delta_t;
+
+/*////////////////////////////
+    Prototypes
+*/////////////////////////////
+    //Lifetime
+        void deltaInit(delta_t * delta);
+        void deltaRelease(delta_t * delta);
+    //Comparing
+        int deltaCompute(delta_t * delta, buffer_t * buffer, const char * data, u_int64_t size, u_int64_t limit);
+
+    #endif
+//End of file
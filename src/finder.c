@@ -0,0 +1,311 @@
+/*////////////////////////////
+    Includes
+*/////////////////////////////
+    #include <string.h>
+    #include <unistd.h>
+    #include "macros.h"
+    #include "arena.h"
+    #include "finder.h"
+
+/*////////////////////////////
+    Prototypes
+*/////////////////////////////
+    //Workers
+        static void * finderWorker(void * argument);
+        static int shardSearch(finder_t * finder, shard_t * shard, char ** scratch, u_int64_t * scratch_size);
+        static int shardPush(shard_t * shard, u_int64_t offset, u_int64_t length);
+    //Shards
+        static u_int64_t shardOf(finder_t * finder, u_int64_t offset);
+
+/*////////////////////////////
+    Globals
+*/////////////////////////////
+    u_int64_t   SHARD_SIZE =            4194304;
+    u_int64_t   MIN_MATCH_CAPACITY =    64;
+
+/*////////////////////////////
+    Functions
+*/////////////////////////////
+    /*////////////////////////////
+        Public Functions
+    */////////////////////////////
+        /*////////////////////////////
+            Lifetime Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Finder start
+                    compiles an extended regex and searches buffer with jobs
+                    workers, 0 for one per core, cancelling any earlier search
+                    the buffer must be fully indexed and left unedited until
+                    the finder is stopped, returns 0 on success
+            */////////////////////////////
+                int finderStart(finder_t * finder, buffer_t * buffer, const char * pattern, u_int64_t jobs){
+                    finderStop(finder);
+                    if (0 != regcomp(&finder->regex, pattern, REG_EXTENDED | REG_NEWLINE)){
+                        return -1;
+                    }
+                    finder->compiled = 1;
+                    finder->buffer = buffer;
+                    //split by bytes then snap each cut to a line start
+                    u_int64_t length = bufferLength(buffer);
+                    u_int64_t count = length / SHARD_SIZE + 1;
+                    finder->shards = calloc(count, sizeof(shard_t));
+                    if (NULL == finder->shards){
+                        finderStop(finder);
+                        return -1;
+                    }
+                    u_int64_t start = 0;
+                    for (u_int64_t iter = 1; iter <= count; iter++){
+                        u_int64_t end = length;
+                        if (iter < count){
+                            u_int64_t line = bufferLineOfOffset(buffer, iter * SHARD_SIZE);
+                            end = bufferLineStart(buffer, line);
+                        }
+                        if (end > start){
+                            finder->shards[finder->shard_count].start = start;
+                            finder->shards[finder->shard_count].end = end;
+                            finder->shard_count++;
+                            start = end;
+                        }
+                    }
+                    if (0 == jobs){
+                        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+                        jobs = (0 < cores) ? cores : 1;
+                    }
+                    if (jobs > finder->shard_count){
+                        jobs = finder->shard_count;
+                    }
+                    finder->threads = calloc((0 == jobs) ? 1 : jobs, sizeof(pthread_t));
+                    if (NULL == finder->threads){
+                        finderStop(finder);
+                        return -1;
+                    }
+                    finder->running = 1;
+                    for (; finder->thread_count < jobs; finder->thread_count++){
+                        if (0 != pthread_create(&finder->threads[finder->thread_count], NULL, finderWorker, finder)){
+                            break;
+                        }
+                    }
+                    if ((0 == finder->thread_count) && (0 < jobs)){
+                        finderStop(finder);
+                        return -1;
+                    }
+                    return 0;
+                }
+            /*////////////////////////////
+                Finder stop
+                    cancels and joins the workers and drops every result
+            */////////////////////////////
+                void finderStop(finder_t * finder){
+                    if (finder->running){
+                        __atomic_store_n(&finder->cancel, 1, __ATOMIC_RELEASE);
+                        for (u_int64_t iter = 0; iter < finder->thread_count; iter++){
+                            pthread_join(finder->threads[iter], NULL);
+                        }
+                    }
+                    if (finder->compiled){
+                        regfree(&finder->regex);
+                    }
+                    for (u_int64_t iter = 0; iter < finder->shard_count; iter++){
+                        free(finder->shards[iter].matches);
+                    }
+                    free(finder->shards);
+                    free(finder->threads);
+                    memset(finder, 0, sizeof(finder_t));
+                }
+            /*////////////////////////////
+                Finder running
+                    returns 1 while shards are still being searched
+            */////////////////////////////
+                int finderRunning(finder_t * finder){
+                    return finder->running && (__atomic_load_n(&finder->done_count, __ATOMIC_ACQUIRE) < finder->shard_count);
+                }
+        /*////////////////////////////
+            Result Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Match count
+                    returns the matches found so far
+            */////////////////////////////
+                u_int64_t finderMatchCount(finder_t * finder){
+                    return __atomic_load_n(&finder->match_count, __ATOMIC_ACQUIRE);
+                }
+            /*////////////////////////////
+                Match after
+                    returns the first match at or after offset in a finished
+                    shard, NULL when there is none yet
+            */////////////////////////////
+                const match_t * finderMatchAfter(finder_t * finder, u_int64_t offset){
+                    for (u_int64_t iter = shardOf(finder, offset); iter < finder->shard_count; iter++){
+                        shard_t * shard = &finder->shards[iter];
+                        if (!__atomic_load_n(&shard->done, __ATOMIC_ACQUIRE)){
+                            continue;
+                        }
+                        u_int64_t low = 0;
+                        u_int64_t high = shard->count;
+                        while (low < high){
+                            u_int64_t mid = low + (high - low) / 2;
+                            if (shard->matches[mid].offset < offset){
+                                low = mid + 1;
+                            }else{
+                                high = mid;
+                            }
+                        }
+                        if (low < shard->count){
+                            return &shard->matches[low];
+                        }
+                    }
+                    return NULL;
+                }
+            /*////////////////////////////
+                Match before
+                    returns the last match before offset in a finished shard
+                    NULL when there is none yet
+            */////////////////////////////
+                const match_t * finderMatchBefore(finder_t * finder, u_int64_t offset){
+                    if (0 == finder->shard_count){
+                        return NULL;
+                    }
+                    for (u_int64_t iter = shardOf(finder, offset) + 1; 0 < iter; iter--){
+                        shard_t * shard = &finder->shards[iter - 1];
+                        if (!__atomic_load_n(&shard->done, __ATOMIC_ACQUIRE)){
+                            continue;
+                        }
+                        u_int64_t low = 0;
+                        u_int64_t high = shard->count;
+                        while (low < high){
+                            u_int64_t mid = low + (high - low) / 2;
+                            if (shard->matches[mid].offset < offset){
+                                low = mid + 1;
+                            }else{
+                                high = mid;
+                            }
+                        }
+                        if (0 < low){
+                            return &shard->matches[low - 1];
+                        }
+                    }
+                    return NULL;
+                }
+
+    /*////////////////////////////
+        Private Functions
+    */////////////////////////////
+        /*////////////////////////////
+            Worker Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Finder worker
+                    claims shards until none are left or the search is cancelled
+            */////////////////////////////
+                static void * finderWorker(void * argument){
+                    finder_t * finder = argument;
+                    char * scratch = NULL;
+                    u_int64_t scratch_size = 0;
+                    for(;;){
+                        u_int64_t iter = __atomic_fetch_add(&finder->next_shard, 1, __ATOMIC_RELAXED);
+                        if (iter >= finder->shard_count){
+                            break;
+                        }
+                        //a shard that ran out of memory keeps what it found
+                        shard_t * shard = &finder->shards[iter];
+                        shardSearch(finder, shard, &scratch, &scratch_size);
+                        __atomic_fetch_add(&finder->match_count, shard->count, __ATOMIC_RELEASE);
+                        __atomic_store_n(&shard->done, 1, __ATOMIC_RELEASE);
+                        __atomic_fetch_add(&finder->done_count, 1, __ATOMIC_RELEASE);
+                        if (__atomic_load_n(&finder->cancel, __ATOMIC_ACQUIRE)){
+                            break;
+                        }
+                    }
+                    free(scratch);
+                    return NULL;
+                }
+            /*////////////////////////////
+                Shard search
+                    copies a shard out of the buffer and matches it line by line
+                    returns 0 when the whole shard was searched
+            */////////////////////////////
+                static int shardSearch(finder_t * finder, shard_t * shard, char ** scratch, u_int64_t * scratch_size){
+                    u_int64_t size = shard->end - shard->start;
+                    if (size > *scratch_size){
+                        *scratch_size = growCapacity(*scratch_size, size, SHARD_SIZE);
+                        free(*scratch);
+                        *scratch = malloc(*scratch_size);
+                        if (NULL == *scratch){
+                            *scratch_size = 0;
+                            return -1;
+                        }
+                    }
+                    char * data = *scratch;
+                    size = bufferRead(finder->buffer, shard->start, data, size);
+                    u_int64_t line = 0;
+                    while (line < size){
+                        if (__atomic_load_n(&finder->cancel, __ATOMIC_ACQUIRE)){
+                            return -1;
+                        }
+                        char * newline = memchr(data + line, '\n', size - line);
+                        u_int64_t end = (NULL == newline) ? size : (u_int64_t)(newline - data);
+                        //every match on the line, the bounds are passed explicitly
+                        u_int64_t from = line;
+                        while (from <= end){
+                            regmatch_t found;
+                            found.rm_so = from;
+                            found.rm_eo = end;
+                            int flags = REG_STARTEND | ((from > line) ? REG_NOTBOL : 0);
+                            if (0 != regexec(&finder->regex, data, 1, &found, flags)){
+                                break;
+                            }
+                            if (found.rm_eo > found.rm_so){
+                                if (0 != shardPush(shard, shard->start + found.rm_so, found.rm_eo - found.rm_so)){
+                                    return -1;
+                                }
+                                from = found.rm_eo;
+                            }else{
+                                from = found.rm_so + 1;
+                            }
+                        }
+                        line = end + 1;
+                    }
+                    return 0;
+                }
+            /*////////////////////////////
+                Shard push
+                    records a match, growing the list geometrically
+                    returns 0 on success
+            */////////////////////////////
+                static int shardPush(shard_t * shard, u_int64_t offset, u_int64_t length){
+                    if (shard->count == shard->capacity){
+                        u_int64_t capacity = growCapacity(shard->capacity, shard->count + 1, MIN_MATCH_CAPACITY);
+                        match_t * matches = realloc(shard->matches, capacity * sizeof(match_t));
+                        if (NULL == matches){
+                            return -1;
+                        }
+                        shard->matches = matches;
+                        shard->capacity = capacity;
+                    }
+                    shard->matches[shard->count].offset = offset;
+                    shard->matches[shard->count].length = length;
+                    shard->count++;
+                    return 0;
+                }
+        /*////////////////////////////
+            Shard Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Shard of
+                    returns the shard holding offset, the last one past the end
+            */////////////////////////////
+                static u_int64_t shardOf(finder_t * finder, u_int64_t offset){
+                    u_int64_t low = 0;
+                    u_int64_t high = finder->shard_count;
+                    while (high - low > 1){
+                        u_int64_t mid = low + (high - low) / 2;
+                        if (finder->shards[mid].start <= offset){
+                            low = mid;
+                        }else{
+                            high = mid;
+                        }
+                    }
+                    return low;
+                }
+//End of file
@@ -0,0 +1,65 @@
+/*////////////////////////////
+    Guard
+*/////////////////////////////
+    #ifndef FINDER_H
+    #define FINDER_H
+
+/*////////////////////////////
+    Includes
+*/////////////////////////////
+    #include <regex.h>
+    #include <pthread.h>
+    #include <sys/types.h>
+    #include "buffer.h"
+
+/*////////////////////////////
+    Structs
+*/////////////////////////////
+    struct match{
+        u_int64_t               offset;     //document offset of the match
+        u_int64_t               length;     //bytes matched
+    };
+    struct shard{
+        u_int64_t               start;      //document offset of the first line
+        u_int64_t               end;        //document offset past the last line
+        struct match *          matches;    //matches in document order
+        u_int64_t               count;      //matches found
+        u_int64_t               capacity;   //matches allocated
+        u_int8_t                done;       //matches are final, set atomically
+    };
+    struct finder{
+        regex_t                 regex;      //compiled pattern
+        u_int8_t                compiled;   //regex holds a pattern
+        u_int8_t                running;    //workers started and not yet joined
+        buffer_t *              buffer;     //text being searched, read only while running
+        struct shard *          shards;     //line ranges searched independently
+        u_int64_t               shard_count;//shards in the search
+        u_int64_t               next_shard; //next shard to claim, taken atomically
+        u_int64_t               done_count; //shards finished, updated atomically
+        u_int64_t               match_count;//matches in finished shards, updated atomically
+        pthread_t *             threads;    //search workers
+        u_int64_t               thread_count;//workers started
+        u_int8_t                cancel;     //ask the workers to stop, set atomically
+    };
+
+/*////////////////////////////
+    Typedefs
+*/////////////////////////////
+    typedef struct match        match_t;
+    typedef struct shard        shard_t;
+    typedef struct finder       finder_t;
+
+/*////////////////////////////
+    Prototypes
+*/////////////////////////////
+    //Lifetime
+        int finderStart(finder_t * finder, buffer_t * buffer, const char * pattern, u_int64_t jobs);
+        void finderStop(finder_t * finder);
+        int finderRunning(finder_t * finder);
+    //Results
+        u_int64_t finderMatchCount(finder_t * finder);
+        const match_t * finderMatchAfter(finder_t * finder, u_int64_t offset);
+        const match_t * finderMatchBefore(finder_t * finder, u_int64_t offset);
+
+    #endif
+//End of file
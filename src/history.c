@@ -0,0 +1,418 @@
+/*////////////////////////////
+    Includes
+*/////////////////////////////
+    #include <errno.h>
+    #include <stdio.h>
+    #include <stdint.h>
+    #include <string.h>
+    #include <unistd.h>
+    #include "macros.h"
+    #include "arena.h"
+    #include "save.h"
+    #include "history.h"
+
+/*////////////////////////////
+    Structs
+*/////////////////////////////
+    struct block{
+        u_int64_t               count;      //changes in the block
+        u_int64_t               text_size;  //text bytes after the changes
+    };
+
+/*////////////////////////////
+    Typedefs
+*/////////////////////////////
+    typedef struct block        block_t;
+
+/*////////////////////////////
+    Prototypes
+*/////////////////////////////
+    //Recording
+        static int historyRecord(history_t * history, u_int8_t kind, u_int64_t offset, u_int64_t text, u_int64_t length);
+        static void historyTruncate(history_t * history);
+        static int historyReserve(history_t * history, u_int64_t changes, u_int64_t text);
+    //Replay
+        static int changeApply(buffer_t * buffer, history_t * history, change_t * change, u_int8_t undo, u_int64_t * offset);
+    //Spilling
+        static void historySpill(history_t * history);
+        static int historyLoad(history_t * history);
+        static int spillWrite(int fd, const void * data, u_int64_t size, u_int64_t offset);
+        static int spillRead(int fd, void * data, u_int64_t size, u_int64_t offset);
+
+/*////////////////////////////
+    Globals
+*/////////////////////////////
+    u_int64_t   MIN_CHANGE_CAPACITY =   256;
+    u_int64_t   MIN_TEXT_CAPACITY =     4096;
+
+/*////////////////////////////
+    Functions
+*/////////////////////////////
+    /*////////////////////////////
+        Public Functions
+    */////////////////////////////
+        /*////////////////////////////
+            Lifetime Functions
+        */////////////////////////////
+            /*////////////////////////////
+                History init
+                    starts an empty history keeping about limit bytes in memory
+            */////////////////////////////
+                void historyInit(history_t * history, u_int64_t limit){
+                    memset(history, 0, sizeof(history_t));
+                    history->limit = limit;
+                    history->spill_fd = -1;
+                }
+            /*////////////////////////////
+                History release
+                    frees every change and closes the spill file, which was
+                    unlinked when it was created
+            */////////////////////////////
+                void historyRelease(history_t * history){
+                    free(history->changes);
+                    free(history->text);
+                    free(history->blocks);
+                    if (-1 != history->spill_fd){
+                        close(history->spill_fd);
+                    }
+                    historyInit(history, history->limit);
+                }
+            /*////////////////////////////
+                History memory
+                    returns the bytes held in memory, spilled changes excluded
+            */////////////////////////////
+                u_int64_t historyMemory(history_t * history){
+                    return history->capacity * sizeof(change_t) + history->text_capacity + history->block_capacity * sizeof(u_int64_t);
+                }
+        /*////////////////////////////
+            Editing Functions
+        */////////////////////////////
+            /*////////////////////////////
+                History insert
+                    inserts text into the buffer and records it, typing right
+                    after the previous insert extends that change
+                    returns 0 on success
+            */////////////////////////////
+                int historyInsert(history_t * history, buffer_t * buffer, u_int64_t offset, const char * text, u_int64_t length){
+                    if (0 == length){
+                        return 0;
+                    }
+                    historyTruncate(history);
+                    if ((0 != historyReserve(history, 1, length)) || (0 != bufferInsert(buffer, offset, text, length))){
+                        return -1;
+                    }
+                    u_int64_t start = history->text_size;
+                    memcpy(history->text + start, text, length);
+                    history->text_size += length;
+                    return historyRecord(history, CHANGE_INSERT, offset, start, length);
+                }
+            /*////////////////////////////
+                History delete
+                    saves the bytes about to go and deletes them from the buffer,
+                    deleting forward from the same offset extends that change
+                    returns 0 on success
+            */////////////////////////////
+                int historyDelete(history_t * history, buffer_t * buffer, u_int64_t offset, u_int64_t length){
+                    if (0 == length){
+                        return 0;
+                    }
+                    historyTruncate(history);
+                    if (0 != historyReserve(history, 1, length)){
+                        return -1;
+                    }
+                    u_int64_t start = history->text_size;
+                    length = bufferRead(buffer, offset, history->text + start, length);
+                    if ((0 == length) || (0 != bufferDelete(buffer, offset, length))){
+                        return (0 == length) ? 0 : -1;
+                    }
+                    history->text_size += length;
+                    return historyRecord(history, CHANGE_DELETE, offset, start, length);
+                }
+            /*////////////////////////////
+                History break
+                    the next change starts a new undo step
+            */////////////////////////////
+                void historyBreak(history_t * history){
+                    history->open = 0;
+                }
+        /*////////////////////////////
+            Undo Functions
+        */////////////////////////////
+            /*////////////////////////////
+                History undo
+                    reverts the newest group of changes, reading spilled changes
+                    back as they are reached
+                    offset receives where the cursor belongs afterwards and first
+                    the lowest offset any change touched
+                    returns 1 when something was undone, 0 when history is empty
+                    and -1 on failure
+            */////////////////////////////
+                int historyUndo(history_t * history, buffer_t * buffer, u_int64_t * offset, u_int64_t * first){
+                    history->open = 0;
+                    if ((0 == history->current) && (0 < history->block_count) && (0 != historyLoad(history))){
+                        return -1;
+                    }
+                    if (0 == history->current){
+                        return 0;
+                    }
+                    u_int64_t group = history->changes[history->current - 1].group;
+                    *first = UINT64_MAX;
+                    while ((0 < history->current) && (group == history->changes[history->current - 1].group)){
+                        if (0 != changeApply(buffer, history, &history->changes[history->current - 1], 1, offset)){
+                            return -1;
+                        }
+                        if (history->changes[history->current - 1].offset < *first){
+                            *first = history->changes[history->current - 1].offset;
+                        }
+                        history->current--;
+                        //a group can straddle the spill boundary
+                        if ((0 == history->current) && (0 < history->block_count) && (0 != historyLoad(history))){
+                            return -1;
+                        }
+                    }
+                    return 1;
+                }
+            /*////////////////////////////
+                History redo
+                    reapplies the oldest undone group
+                    offset and first are as for undo
+                    returns 1 when something was redone, 0 when nothing was undone
+                    and -1 on failure
+            */////////////////////////////
+                int historyRedo(history_t * history, buffer_t * buffer, u_int64_t * offset, u_int64_t * first){
+                    history->open = 0;
+                    if (history->current == history->count){
+                        return 0;
+                    }
+                    u_int64_t group = history->changes[history->current].group;
+                    *first = UINT64_MAX;
+                    while ((history->current < history->count) && (group == history->changes[history->current].group)){
+                        if (0 != changeApply(buffer, history, &history->changes[history->current], 0, offset)){
+                            return -1;
+                        }
+                        if (history->changes[history->current].offset < *first){
+                            *first = history->changes[history->current].offset;
+                        }
+                        history->current++;
+                    }
+                    return 1;
+                }
+
+    /*////////////////////////////
+        Private Functions
+    */////////////////////////////
+        /*////////////////////////////
+            Recording Functions
+        */////////////////////////////
+            /*////////////////////////////
+                History record
+                    appends a change whose bytes are already in the text store,
+                    merging it into the newest change when it continues it
+                    returns 0 on success
+            */////////////////////////////
+                static int historyRecord(history_t * history, u_int8_t kind, u_int64_t offset, u_int64_t text, u_int64_t length){
+                    change_t * last = (0 < history->count) ? &history->changes[history->count - 1] : NULL;
+                    u_int8_t join = (history->open) && (NULL != last) && (kind == last->kind);
+                    //typing continues an insert, forward deletes stay at one offset
+                    u_int8_t extends = (join) && (text == last->text + last->length) && (offset == ((CHANGE_INSERT == kind) ? last->offset + last->length : last->offset));
+                    if (extends){
+                        last->length += length;
+                    }else{
+                        change_t * change = &history->changes[history->count++];
+                        change->offset = offset;
+                        change->length = length;
+                        change->text = text;
+                        change->kind = kind;
+                        change->group = join ? history->group : ++history->group;
+                    }
+                    history->current = history->count;
+                    history->open = 1;
+                    if (history->count * sizeof(change_t) + history->text_size > history->limit){
+                        historySpill(history);
+                    }
+                    return 0;
+                }
+            /*////////////////////////////
+                History truncate
+                    forgets undone changes once a new change is made
+            */////////////////////////////
+                static void historyTruncate(history_t * history){
+                    if (history->current < history->count){
+                        history->text_size = history->changes[history->current].text;
+                        history->count = history->current;
+                        history->open = 0;
+                    }
+                }
+            /*////////////////////////////
+                History reserve
+                    makes room for more changes and text bytes
+                    returns 0 on success
+            */////////////////////////////
+                static int historyReserve(history_t * history, u_int64_t changes, u_int64_t text){
+                    if (history->count + changes > history->capacity){
+                        u_int64_t capacity = growCapacity(history->capacity, history->count + changes, MIN_CHANGE_CAPACITY);
+                        change_t * grown = realloc(history->changes, capacity * sizeof(change_t));
+                        if (NULL == grown){
+                            return -1;
+                        }
+                        history->changes = grown;
+                        history->capacity = capacity;
+                    }
+                    if (history->text_size + text > history->text_capacity){
+                        u_int64_t capacity = growCapacity(history->text_capacity, history->text_size + text, MIN_TEXT_CAPACITY);
+                        char * grown = realloc(history->text, capacity);
+                        if (NULL == grown){
+                            return -1;
+                        }
+                        history->text = grown;
+                        history->text_capacity = capacity;
+                    }
+                    return 0;
+                }
+        /*////////////////////////////
+            Replay Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Change apply
+                    performs a change, or its inverse when undoing
+                    returns 0 on success
+            */////////////////////////////
+                static int changeApply(buffer_t * buffer, history_t * history, change_t * change, u_int8_t undo, u_int64_t * offset){
+                    u_int8_t insert = (CHANGE_INSERT == change->kind) != undo;
+                    *offset = insert ? change->offset + change->length : change->offset;
+                    if (insert){
+                        return bufferInsert(buffer, change->offset, history->text + change->text, change->length);
+                    }
+                    return bufferDelete(buffer, change->offset, change->length);
+                }
+        /*////////////////////////////
+            Spilling Functions
+        */////////////////////////////
+            /*////////////////////////////
+                History spill
+                    writes the older half of the applied changes and their text
+                    to the spill file as one block and drops them from memory
+                    when the file cannot be written that history is forgotten
+            */////////////////////////////
+                static void historySpill(history_t * history){
+                    u_int64_t count = history->current / 2;
+                    if (0 == count){
+                        return;
+                    }
+                    block_t block;
+                    block.count = count;
+                    block.text_size = history->changes[count].text;
+                    u_int8_t spilled = 0;
+                    if (-1 == history->spill_fd){
+                        history->spill_fd = saveScratch("cliundo");
+                    }
+                    if ((-1 != history->spill_fd) && (history->block_count == history->block_capacity)){
+                        u_int64_t capacity = growCapacity(history->block_capacity, history->block_count + 1, MIN_CHANGE_CAPACITY);
+                        u_int64_t * grown = realloc(history->blocks, capacity * sizeof(u_int64_t));
+                        if (NULL != grown){
+                            history->blocks = grown;
+                            history->block_capacity = capacity;
+                        }
+                    }
+                    if ((-1 != history->spill_fd) && (history->block_count < history->block_capacity)){
+                        u_int64_t at = history->spill_size;
+                        u_int64_t changes_size = count * sizeof(change_t);
+                        if ((0 == spillWrite(history->spill_fd, &block, sizeof(block_t), at)) &&
+                            (0 == spillWrite(history->spill_fd, history->changes, changes_size, at + sizeof(block_t))) &&
+                            (0 == spillWrite(history->spill_fd, history->text, block.text_size, at + sizeof(block_t) + changes_size))){
+                            history->blocks[history->block_count++] = at;
+                            history->spill_size = at + sizeof(block_t) + changes_size + block.text_size;
+                            spilled = 1;
+                        }
+                    }
+                    //older blocks cannot be reached past a gap, so they go too
+                    if ((!spilled) && (-1 != history->spill_fd)){
+                        history->block_count = 0;
+                        history->spill_size = 0;
+                        ftruncate(history->spill_fd, 0);
+                    }
+                    memmove(history->changes, history->changes + count, (history->count - count) * sizeof(change_t));
+                    memmove(history->text, history->text + block.text_size, history->text_size - block.text_size);
+                    history->count -= count;
+                    history->current -= count;
+                    history->text_size -= block.text_size;
+                    for (u_int64_t iter = 0; iter < history->count; iter++){
+                        history->changes[iter].text -= block.text_size;
+                    }
+                    //give the freed text back rather than just reusing it
+                    if (history->text_capacity > 2 * history->text_size + MIN_TEXT_CAPACITY){
+                        u_int64_t capacity = history->text_size + MIN_TEXT_CAPACITY;
+                        char * shrunk = realloc(history->text, capacity);
+                        if (NULL != shrunk){
+                            history->text = shrunk;
+                            history->text_capacity = capacity;
+                        }
+                    }
+                }
+            /*////////////////////////////
+                History load
+                    reads the newest spilled block back in front of the changes
+                    in memory and trims it from the spill file
+                    returns 0 on success
+            */////////////////////////////
+                static int historyLoad(history_t * history){
+                    u_int64_t at = history->blocks[history->block_count - 1];
+                    block_t block;
+                    if ((0 != spillRead(history->spill_fd, &block, sizeof(block_t), at)) || (0 != historyReserve(history, block.count, block.text_size))){
+                        return -1;
+                    }
+                    memmove(history->changes + block.count, history->changes, history->count * sizeof(change_t));
+                    memmove(history->text + block.text_size, history->text, history->text_size);
+                    for (u_int64_t iter = block.count; iter < history->count + block.count; iter++){
+                        history->changes[iter].text += block.text_size;
+                    }
+                    u_int64_t changes_size = block.count * sizeof(change_t);
+                    if ((0 != spillRead(history->spill_fd, history->changes, changes_size, at + sizeof(block_t))) ||
+                        (0 != spillRead(history->spill_fd, history->text, block.text_size, at + sizeof(block_t) + changes_size))){
+                        return -1;
+                    }
+                    history->count += block.count;
+                    history->current += block.count;
+                    history->text_size += block.text_size;
+                    history->block_count--;
+                    history->spill_size = at;
+                    ftruncate(history->spill_fd, at);
+                    return 0;
+                }
+            /*////////////////////////////
+                Spill write
+                    returns 0 once every byte is written
+            */////////////////////////////
+                static int spillWrite(int fd, const void * data, u_int64_t size, u_int64_t offset){
+                    u_int64_t done = 0;
+                    while (done < size){
+                        ssize_t count = pwrite(fd, (const char *)data + done, size - done, offset + done);
+                        if ((0 > count) && (EINTR == errno)){
+                            continue;
+                        }
+                        if (0 >= count){
+                            return -1;
+                        }
+                        done += count;
+                    }
+                    return 0;
+                }
+            /*////////////////////////////
+                Spill read
+                    returns 0 once every byte is read
+            */////////////////////////////
+                static int spillRead(int fd, void * data, u_int64_t size, u_int64_t offset){
+                    u_int64_t done = 0;
+                    while (done < size){
+                        ssize_t count = pread(fd, (char *)data + done, size - done, offset + done);
+                        if ((0 > count) && (EINTR == errno)){
+                            continue;
+                        }
+                        if (0 >= count){
+                            return -1;
+                        }
+                        done += count;
+                    }
+                    return 0;
+                }
+//End of file
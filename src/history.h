@@ -0,0 +1,69 @@
+/*////////////////////////////
+    Guard
+*/////////////////////////////
+    #ifndef HISTORY_H
+    #define HISTORY_H
+
+/*////////////////////////////
+    Includes
+*/////////////////////////////
+    #include <sys/types.h>
+    #include "buffer.h"
+
+/*////////////////////////////
+    Defines
+*/////////////////////////////
+    #define CHANGE_INSERT       0
+    #define CHANGE_DELETE       1
+
+/*////////////////////////////
+    Structs
+*/////////////////////////////
+    struct change{
+        u_int64_t               offset;     //document offset of the edit
+        u_int64_t               length;     //bytes inserted or deleted
+        u_int64_t               text;       //where those bytes start in the text store
+        u_int64_t               group;      //changes sharing a group undo together
+        u_int8_t                kind;       //CHANGE_INSERT or CHANGE_DELETE
+    };
+    struct history{
+        struct change *         changes;    //oldest first, applied ones before current
+        u_int64_t               count;      //changes in memory, undone ones included
+        u_int64_t               capacity;   //changes allocated
+        u_int64_t               current;    //changes applied, the next redo when below count
+        char *                  text;       //append only store of inserted and deleted bytes
+        u_int64_t               text_size;  //bytes in use
+        u_int64_t               text_capacity;//bytes allocated
+        u_int64_t               group;      //group of the newest change
+        u_int8_t                open;       //the next change may join the newest group
+        u_int64_t               limit;      //bytes kept in memory before spilling
+        int                     spill_fd;   //unlinked temporary file of older changes, -1 until needed
+        u_int64_t *             blocks;     //where each spilled block starts, oldest first
+        u_int64_t               block_count;//blocks spilled
+        u_int64_t               block_capacity;//blocks allocated
+        u_int64_t               spill_size; //bytes in the spill file
+    };
+
+/*////////////////////////////
+    Typedefs
+*/////////////////////////////
+    typedef struct change       change_t;
+    typedef struct history      history_t;
+
+/*////////////////////////////
+    Prototypes
+*/////////////////////////////
+    //Lifetime
+        void historyInit(history_t * history, u_int64_t limit);
+        void historyRelease(history_t * history);
+        u_int64_t historyMemory(history_t * history);
+    //Editing
+        int historyInsert(history_t * history, buffer_t * buffer, u_int64_t offset, const char * text, u_int64_t length);
+        int historyDelete(history_t * history, buffer_t * buffer, u_int64_t offset, u_int64_t length);
+        void historyBreak(history_t * history);
+    //Undo
+        int historyUndo(history_t * history, buffer_t * buffer, u_int64_t * offset, u_int64_t * first);
+        int historyRedo(history_t * history, buffer_t * buffer, u_int64_t * offset, u_int64_t * first);
+
+    #endif
+//End of file
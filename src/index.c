@@ -0,0 +1,548 @@
+/*////////////////////////////
+    Includes
+*/////////////////////////////
+    #include <stdint.h>
+    #include <string.h>
+    #include "macros.h"
+    #include "arena.h"
+    #include "index.h"
+    #if defined(__x86_64__) || defined(__i386__)
+        #include <immintrin.h>
+    #endif
+
+/*////////////////////////////
+    Prototypes
+*/////////////////////////////
+    //Segments
+        static segment_t * sourceSegment(source_t * source, u_int64_t chunk);
+        static u_int64_t sourcePublished(source_t * source);
+        static void sourcePublish(source_t * source, u_int64_t segments);
+        static int segmentPush(segment_t * segment, u_int64_t offset);
+        static int segmentReserve(segment_t * segment, u_int64_t newlines, u_int64_t minimum);
+        static int segmentStart(source_t * source, segment_t * segment, u_int64_t bytes);
+    //Scanning
+        static int scanRange(source_t * source, segment_t * segment, u_int64_t begin, u_int64_t end);
+        static int scanScalar(char * data, segment_t * segment, u_int64_t begin, u_int64_t end);
+        static int scanSparse(source_t * source, segment_t * segment, u_int64_t begin, u_int64_t end);
+        static u_int64_t scanSkip(const char * data, u_int64_t begin, u_int64_t end, u_int64_t * skip);
+
+/*////////////////////////////
+    Globals
+*/////////////////////////////
+    u_int64_t   MIN_SOURCE_CAPACITY =   4096;
+    u_int64_t   MIN_NEWLINE_CAPACITY =  1024;
+    u_int64_t   MIN_SPARSE_CAPACITY =   16;
+    u_int64_t   MIN_SEGMENT_CAPACITY =  16;
+    u_int64_t   EXPECTED_LINE_LENGTH =  64;
+
+/*////////////////////////////
+    Functions
+*/////////////////////////////
+    /*////////////////////////////
+        Public Functions
+    */////////////////////////////
+        /*////////////////////////////
+            Lifetime Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Source reserve
+                    allocates a segment for every chunk of size bytes up front
+                    so the table never moves while another thread indexes it
+                    returns 0 on success
+            */////////////////////////////
+                int sourceReserve(source_t * source, u_int64_t size){
+                    u_int64_t chunks = (size >> INDEX_CHUNK_SHIFT) + 1;
+                    if (chunks <= source->segment_capacity){
+                        return 0;
+                    }
+                    return (NULL == sourceSegment(source, chunks - 1)) ? -1 : 0;
+                }
+            /*////////////////////////////
+                Source release
+                    frees the newline index and any owned data
+            */////////////////////////////
+                void sourceRelease(source_t * source){
+                    for (u_int64_t iter = 0; iter < source->segment_capacity; iter++){
+                        free(source->segments[iter].newlines);
+                    }
+                    free(source->segments);
+                    if (0 != source->capacity){
+                        free(source->data);
+                    }
+                    memset(source, 0, sizeof(source_t));
+                }
+        /*////////////////////////////
+            Building Functions
+        */////////////////////////////
+#if defined(__x86_64__) || defined(__i386__)
+            /*////////////////////////////
+                Scan AVX2
+                    compares 64 bytes per step and walks the newline bitmask
+                    returns the offset scanning stopped at, UINT64_MAX when out of memory
+            */////////////////////////////
+                __attribute__((target("avx2")))
+                static u_int64_t scanAVX2(char * data, segment_t * segment, u_int64_t begin, u_int64_t end){
+                    const __m256i newline = _mm256_set1_epi8('\n');
+                    u_int64_t offset = begin;
+                    for (; offset + 64 <= end; offset += 64){
+                        __m256i low = _mm256_loadu_si256((const __m256i *)(data + offset));
+                        __m256i high = _mm256_loadu_si256((const __m256i *)(data + offset + 32));
+                        u_int64_t mask = (u_int32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(low, newline));
+                        mask |= (u_int64_t)(u_int32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(high, newline)) << 32;
+                        while (mask){
+                            if (0 != segmentPush(segment, offset + __builtin_ctzll(mask))){
+                                return UINT64_MAX;
+                            }
+                            mask &= mask - 1;
+                        }
+                    }
+                    return offset;
+                }
+            /*////////////////////////////
+                Scan SSE2
+                    compares 16 bytes per step and walks the newline bitmask
+                    returns the offset scanning stopped at, UINT64_MAX when out of memory
+            */////////////////////////////
+                __attribute__((target("sse2")))
+                static u_int64_t scanSSE2(char * data, segment_t * segment, u_int64_t begin, u_int64_t end){
+                    const __m128i newline = _mm_set1_epi8('\n');
+                    u_int64_t offset = begin;
+                    for (; offset + 16 <= end; offset += 16){
+                        __m128i chunk = _mm_loadu_si128((const __m128i *)(data + offset));
+                        u_int32_t mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline));
+                        while (mask){
+                            if (0 != segmentPush(segment, offset + __builtin_ctz(mask))){
+                                return UINT64_MAX;
+                            }
+                            mask &= mask - 1;
+                        }
+                    }
+                    return offset;
+                }
+            /*////////////////////////////
+                Skip AVX2
+                    counts 64 bytes per step until the newline skip newlines
+                    ahead falls in the step, passed newlines come off skip
+                    returns 1 with offset on that newline, 0 with offset where
+                    the vector steps stopped
+            */////////////////////////////
+                __attribute__((target("avx2,popcnt")))
+                static int skipAVX2(const char * data, u_int64_t * offset, u_int64_t end, u_int64_t * skip){
+                    const __m256i newline = _mm256_set1_epi8('\n');
+                    for (; *offset + 64 <= end; *offset += 64){
+                        __m256i low = _mm256_loadu_si256((const __m256i *)(data + *offset));
+                        __m256i high = _mm256_loadu_si256((const __m256i *)(data + *offset + 32));
+                        u_int64_t mask = (u_int32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(low, newline));
+                        mask |= (u_int64_t)(u_int32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(high, newline)) << 32;
+                        u_int64_t count = __builtin_popcountll(mask);
+                        if (count > *skip){
+                            for (; 0 < *skip; (*skip)--){
+                                mask &= mask - 1;
+                            }
+                            *offset += __builtin_ctzll(mask);
+                            return 1;
+                        }
+                        *skip -= count;
+                    }
+                    return 0;
+                }
+            /*////////////////////////////
+                Skip SSE2
+                    counts 16 bytes per step, as skipAVX2
+            */////////////////////////////
+                __attribute__((target("sse2")))
+                static int skipSSE2(const char * data, u_int64_t * offset, u_int64_t end, u_int64_t * skip){
+                    const __m128i newline = _mm_set1_epi8('\n');
+                    for (; *offset + 16 <= end; *offset += 16){
+                        __m128i chunk = _mm_loadu_si128((const __m128i *)(data + *offset));
+                        u_int32_t mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline));
+                        u_int64_t count = __builtin_popcount(mask);
+                        if (count > *skip){
+                            for (; 0 < *skip; (*skip)--){
+                                mask &= mask - 1;
+                            }
+                            *offset += __builtin_ctz(mask);
+                            return 1;
+                        }
+                        *skip -= count;
+                    }
+                    return 0;
+                }
+#endif
+            /*////////////////////////////
+                Source index
+                    indexes the newlines in [begin, end), which must follow
+                    everything indexed so far, publishing each chunk it touches
+                    returns 0 on success
+            */////////////////////////////
+                int sourceIndex(source_t * source, u_int64_t begin, u_int64_t end){
+                    while (begin < end){
+                        u_int64_t chunk = begin >> INDEX_CHUNK_SHIFT;
+                        u_int64_t stop = (chunk + 1) << INDEX_CHUNK_SHIFT;
+                        if (stop > end){
+                            stop = end;
+                        }
+                        segment_t * segment = sourceSegment(source, chunk);
+                        if (NULL == segment){
+                            return -1;
+                        }
+                        //a new chunk starts empty
+                        if ((chunk >= sourcePublished(source)) && (0 != segmentStart(source, segment, stop - begin))){
+                            return -1;
+                        }
+                        if (0 != scanRange(source, segment, begin, stop)){
+                            return -1;
+                        }
+                        sourceCommit(source, chunk);
+                        begin = stop;
+                    }
+                    return 0;
+                }
+            /*////////////////////////////
+                Source scan chunk
+                    records the newlines of one whole chunk without publishing it
+                    distinct chunks may be scanned concurrently once the source
+                    is reserved, returns 0 on success
+            */////////////////////////////
+                int sourceScanChunk(source_t * source, u_int64_t chunk){
+                    u_int64_t begin = chunk << INDEX_CHUNK_SHIFT;
+                    u_int64_t end = (source->size - begin > INDEX_CHUNK_SIZE) ? begin + INDEX_CHUNK_SIZE : source->size;
+                    segment_t * segment = &source->segments[chunk];
+                    if (0 != segmentStart(source, segment, end - begin)){
+                        return -1;
+                    }
+                    return scanRange(source, segment, begin, end);
+                }
+            /*////////////////////////////
+                Source commit
+                    stitches a scanned chunk onto the prefix sum of the chunks
+                    before it and publishes it, chunks are committed in order
+            */////////////////////////////
+                void sourceCommit(source_t * source, u_int64_t chunk){
+                    segment_t * segment = &source->segments[chunk];
+                    segment->first = (0 == chunk) ? 0 : source->segments[chunk - 1].first + source->segments[chunk - 1].count;
+                    sourcePublish(source, chunk + 1);
+                }
+            /*////////////////////////////
+                Source append
+                    appends text to an owned source and indexes its newlines
+                    returns 0 on success
+            */////////////////////////////
+                int sourceAppend(source_t * source, const char * text, u_int64_t length){
+                    if (source->size + length > source->capacity){
+                        u_int64_t capacity = growCapacity(source->capacity, source->size + length, MIN_SOURCE_CAPACITY);
+                        char * data = realloc(source->data, capacity);
+                        if (NULL == data){
+                            return -1;
+                        }
+                        source->data = data;
+                        source->capacity = capacity;
+                    }
+                    memcpy(source->data + source->size, text, length);
+                    source->size += length;
+                    return sourceIndex(source, source->size - length, source->size);
+                }
+        /*////////////////////////////
+            Query Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Newline count
+                    returns the newlines published so far
+            */////////////////////////////
+                u_int64_t sourceNewlineCount(source_t * source){
+                    u_int64_t published = sourcePublished(source);
+                    if (0 == published){
+                        return 0;
+                    }
+                    return source->segments[published - 1].first + source->segments[published - 1].count;
+                }
+            /*////////////////////////////
+                Indexed bytes
+                    returns how much of the source the published index covers
+            */////////////////////////////
+                u_int64_t sourceIndexedBytes(source_t * source){
+                    u_int64_t indexed = sourcePublished(source) << INDEX_CHUNK_SHIFT;
+                    return (indexed > source->size) ? source->size : indexed;
+                }
+            /*////////////////////////////
+                Source memory
+                    returns the bytes held by owned data and the published index
+            */////////////////////////////
+                u_int64_t sourceMemory(source_t * source){
+                    u_int64_t published = sourcePublished(source);
+                    u_int64_t memory = source->capacity + source->segment_capacity * sizeof(segment_t);
+                    for (u_int64_t iter = 0; iter < published; iter++){
+                        memory += source->segments[iter].capacity * sizeof(u_int64_t);
+                    }
+                    return memory;
+                }
+            /*////////////////////////////
+                Newlines before
+                    counts the newlines at offsets lower than offset, a sparse
+                    index counts on from the closest stored newline before it
+                    the chunk holding offset must be published
+            */////////////////////////////
+                u_int64_t sourceNewlinesBefore(source_t * source, u_int64_t offset){
+                    u_int64_t chunk = offset >> INDEX_CHUNK_SHIFT;
+                    if (chunk >= sourcePublished(source)){
+                        return sourceNewlineCount(source);
+                    }
+                    segment_t * segment = &source->segments[chunk];
+                    u_int64_t low = 0;
+                    u_int64_t high = segment->stored;
+                    while (low < high){
+                        u_int64_t mid = low + (high - low) / 2;
+                        if (segment->newlines[mid] < offset){
+                            low = mid + 1;
+                        }else{
+                            high = mid;
+                        }
+                    }
+                    if (1 >= source->stride){
+                        return segment->first + low;
+                    }
+                    u_int64_t begin = chunk << INDEX_CHUNK_SHIFT;
+                    u_int64_t before = 0;
+                    if (0 < low){
+                        begin = segment->newlines[low - 1] + 1;
+                        before = (low - 1) * source->stride + 1;
+                    }
+                    u_int64_t skip = UINT64_MAX;
+                    scanSkip(source->data, begin, offset, &skip);
+                    return segment->first + before + (UINT64_MAX - skip);
+                }
+            /*////////////////////////////
+                Newline at
+                    returns the offset of the nth newline, a sparse index
+                    scans on from the stored newline before it
+                    the newline must be published
+            */////////////////////////////
+                u_int64_t sourceNewlineAt(source_t * source, u_int64_t newline){
+                    //last segment whose first newline is at or before newline
+                    u_int64_t low = 0;
+                    u_int64_t high = sourcePublished(source);
+                    while (high - low > 1){
+                        u_int64_t mid = low + (high - low) / 2;
+                        if (source->segments[mid].first <= newline){
+                            low = mid;
+                        }else{
+                            high = mid;
+                        }
+                    }
+                    segment_t * segment = &source->segments[low];
+                    u_int64_t local = newline - segment->first;
+                    if (1 >= source->stride){
+                        return segment->newlines[local];
+                    }
+                    u_int64_t stored = segment->newlines[local / source->stride];
+                    u_int64_t skip = local % source->stride;
+                    if (0 == skip){
+                        return stored;
+                    }
+                    u_int64_t end = (low + 1) << INDEX_CHUNK_SHIFT;
+                    skip--;
+                    return scanSkip(source->data, stored + 1, (end < source->size) ? end : source->size, &skip);
+                }
+
+    /*////////////////////////////
+        Private Functions
+    */////////////////////////////
+        /*////////////////////////////
+            Segment Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Source segment
+                    returns the segment for a chunk, growing the table when needed
+                    the table only grows from the thread that owns the source
+            */////////////////////////////
+                static segment_t * sourceSegment(source_t * source, u_int64_t chunk){
+                    if (chunk >= source->segment_capacity){
+                        u_int64_t capacity = growCapacity(source->segment_capacity, chunk + 1, MIN_SEGMENT_CAPACITY);
+                        segment_t * segments = realloc(source->segments, capacity * sizeof(segment_t));
+                        if (NULL == segments){
+                            return NULL;
+                        }
+                        memset(segments + source->segment_capacity, 0, (capacity - source->segment_capacity) * sizeof(segment_t));
+                        source->segments = segments;
+                        source->segment_capacity = capacity;
+                    }
+                    return &source->segments[chunk];
+                }
+            /*////////////////////////////
+                Source published
+                    segments visible to readers, pairs with sourcePublish
+            */////////////////////////////
+                static u_int64_t sourcePublished(source_t * source){
+                    return __atomic_load_n(&source->segment_count, __ATOMIC_ACQUIRE);
+                }
+            /*////////////////////////////
+                Source publish
+                    makes completed segments visible to other threads
+            */////////////////////////////
+                static void sourcePublish(source_t * source, u_int64_t segments){
+                    if (segments > source->segment_count){
+                        __atomic_store_n(&source->segment_count, segments, __ATOMIC_RELEASE);
+                    }
+                }
+            /*////////////////////////////
+                Segment push
+                    records a newline offset, growing the segment geometrically
+                    returns 0 on success
+            */////////////////////////////
+                static int segmentPush(segment_t * segment, u_int64_t offset){
+                    if (segment->stored == segment->capacity){
+                        if (0 != segmentReserve(segment, segment->stored + 1, MIN_SPARSE_CAPACITY)){
+                            return -1;
+                        }
+                    }
+                    segment->newlines[segment->stored++] = offset;
+                    segment->count++;
+                    return 0;
+                }
+            /*////////////////////////////
+                Segment reserve
+                    grows a segment to hold at least newlines entries
+                    returns 0 on success
+            */////////////////////////////
+                static int segmentReserve(segment_t * segment, u_int64_t newlines, u_int64_t minimum){
+                    if (newlines <= segment->capacity){
+                        return 0;
+                    }
+                    u_int64_t capacity = growCapacity(segment->capacity, newlines, minimum);
+                    u_int64_t * resized = realloc(segment->newlines, capacity * sizeof(u_int64_t));
+                    if (NULL == resized){
+                        return -1;
+                    }
+                    segment->newlines = resized;
+                    segment->capacity = capacity;
+                    return 0;
+                }
+            /*////////////////////////////
+                Segment start
+                    empties a segment and reserves for a chunk of bytes, a
+                    sparse index only for the newlines it will store
+                    returns 0 on success
+            */////////////////////////////
+                static int segmentStart(source_t * source, segment_t * segment, u_int64_t bytes){
+                    segment->stored = 0;
+                    segment->count = 0;
+                    if (1 >= source->stride){
+                        return segmentReserve(segment, bytes / EXPECTED_LINE_LENGTH, MIN_NEWLINE_CAPACITY);
+                    }
+                    return segmentReserve(segment, bytes / EXPECTED_LINE_LENGTH / source->stride + 1, MIN_SPARSE_CAPACITY);
+                }
+        /*////////////////////////////
+            Scanning Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Scan range
+                    records the newlines in [begin, end) with the widest
+                    vector unit the cpu supports, returns 0 on success
+            */////////////////////////////
+                static int scanRange(source_t * source, segment_t * segment, u_int64_t begin, u_int64_t end){
+                    if (1 < source->stride){
+                        return scanSparse(source, segment, begin, end);
+                    }
+                    char * data = source->data;
+                    u_int64_t offset = begin;
+#if defined(__x86_64__) || defined(__i386__)
+                    __builtin_cpu_init();
+                    if (__builtin_cpu_supports("avx2")){
+                        offset = scanAVX2(data, segment, begin, end);
+                    }else if (__builtin_cpu_supports("sse2")){
+                        offset = scanSSE2(data, segment, begin, end);
+                    }
+#endif
+                    if (UINT64_MAX == offset){
+                        return -1;
+                    }
+                    return scanScalar(data, segment, offset, end);
+                }
+            /*////////////////////////////
+                Scan scalar
+                    memchr based newline scan over [begin, end)
+                    returns 0 on success
+            */////////////////////////////
+                static int scanScalar(char * data, segment_t * segment, u_int64_t begin, u_int64_t end){
+                    char * curr = data + begin;
+                    char * last = data + end;
+                    while (curr < last){
+                        char * newline = memchr(curr, '\n', last - curr);
+                        if (NULL == newline){
+                            break;
+                        }
+                        if (0 != segmentPush(segment, newline - data)){
+                            return -1;
+                        }
+                        curr = newline + 1;
+                    }
+                    return 0;
+                }
+            /*////////////////////////////
+                Scan sparse
+                    counts the newlines in [begin, end) but stores only every
+                    stride-th one, so a chunk costs a few offsets however many
+                    lines it holds
+                    returns 0 on success
+            */////////////////////////////
+                static int scanSparse(source_t * source, segment_t * segment, u_int64_t begin, u_int64_t end){
+                    u_int64_t offset = begin;
+                    while (offset < end){
+                        u_int64_t wanted = (source->stride - segment->count % source->stride) % source->stride;
+                        u_int64_t skip = wanted;
+                        u_int64_t newline = scanSkip(source->data, offset, end, &skip);
+                        segment->count += wanted - skip;
+                        if (newline >= end){
+                            break;
+                        }
+                        if (0 != segmentPush(segment, newline)){
+                            return -1;
+                        }
+                        offset = newline + 1;
+                    }
+                    //give back what the estimate reserved beyond the stored offsets
+                    if ((0 < segment->stored) && (segment->stored < segment->capacity)){
+                        u_int64_t * fitted = realloc(segment->newlines, segment->stored * sizeof(u_int64_t));
+                        if (NULL != fitted){
+                            segment->newlines = fitted;
+                            segment->capacity = segment->stored;
+                        }
+                    }
+                    return 0;
+                }
+            /*////////////////////////////
+                Scan skip
+                    passes skip newlines in [begin, end) with the widest vector
+                    unit the cpu supports, taking each one passed off skip
+                    returns the offset of the newline after them, end when the
+                    range runs out first
+            */////////////////////////////
+                static u_int64_t scanSkip(const char * data, u_int64_t begin, u_int64_t end, u_int64_t * skip){
+                    u_int64_t offset = begin;
+#if defined(__x86_64__) || defined(__i386__)
+                    __builtin_cpu_init();
+                    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt")){
+                        if (skipAVX2(data, &offset, end, skip)){
+                            return offset;
+                        }
+                    }else if (__builtin_cpu_supports("sse2")){
+                        if (skipSSE2(data, &offset, end, skip)){
+                            return offset;
+                        }
+                    }
+#endif
+                    while (offset < end){
+                        const char * newline = memchr(data + offset, '\n', end - offset);
+                        if (NULL == newline){
+                            break;
+                        }
+                        offset = newline - data;
+                        if (0 == *skip){
+                            return offset;
+                        }
+                        (*skip)--;
+                        offset++;
+                    }
+                    return end;
+                }
+//End of file
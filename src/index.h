@@ -0,0 +1,63 @@
+/*////////////////////////////
+    Guard
+*/////////////////////////////
+    #ifndef INDEX_H
+    #define INDEX_H
+
+/*////////////////////////////
+    Includes
+*/////////////////////////////
+    #include <sys/types.h>
+
+/*////////////////////////////
+    Defines
+*/////////////////////////////
+    #define INDEX_CHUNK_SHIFT   22
+    #define INDEX_CHUNK_SIZE    ((u_int64_t)1 << INDEX_CHUNK_SHIFT)
+
+/*////////////////////////////
+    Structs
+*/////////////////////////////
+    struct segment{
+        u_int64_t *             newlines;   //sorted offsets of the newlines in this chunk, every stride-th one when sparse
+        u_int64_t               stored;     //offsets in use
+        u_int64_t               count;      //newlines in this chunk
+        u_int64_t               capacity;   //offsets allocated
+        u_int64_t               first;      //newlines in every earlier chunk
+    };
+    struct source{
+        char *                  data;       //bytes of this source
+        u_int64_t               size;       //bytes in use
+        u_int64_t               capacity;   //bytes allocated, 0 when not owned
+        struct segment *        segments;   //newline index, one segment per chunk of data
+        u_int64_t               segment_count;//segments published to readers
+        u_int64_t               segment_capacity;//segments allocated
+        u_int64_t               stride;     //newlines per stored offset, 0 or 1 stores every one
+    };
+
+/*////////////////////////////
+    Typedefs
+*/////////////////////////////
+    typedef struct segment      segment_t;
+    typedef struct source       source_t;
+
+/*////////////////////////////
+    Prototypes
+*/////////////////////////////
+    //Lifetime
+        int sourceReserve(source_t * source, u_int64_t size);
+        void sourceRelease(source_t * source);
+    //Building
+        int sourceIndex(source_t * source, u_int64_t begin, u_int64_t end);
+        int sourceScanChunk(source_t * source, u_int64_t chunk);
+        void sourceCommit(source_t * source, u_int64_t chunk);
+        int sourceAppend(source_t * source, const char * text, u_int64_t length);
+    //Queries
+        u_int64_t sourceNewlineCount(source_t * source);
+        u_int64_t sourceIndexedBytes(source_t * source);
+        u_int64_t sourceMemory(source_t * source);
+        u_int64_t sourceNewlinesBefore(source_t * source, u_int64_t offset);
+        u_int64_t sourceNewlineAt(source_t * source, u_int64_t newline);
+
+    #endif
+//End of file
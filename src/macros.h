@@ -0,0 +1,38 @@
+/*////////////////////////////
+    Guard
+*/////////////////////////////
+    #ifndef MACROS_H
+    #define MACROS_H
+
+/*////////////////////////////
+    Includes
+*/////////////////////////////
+    #include <stdlib.h>
+
+/*////////////////////////////
+    Macros
+*/////////////////////////////
+    #define CTRL_KEY(k) ((k) & 0x1f)
+    #define free(pointer) (\
+        {\
+            (free(pointer));\
+            ((pointer) = (NULL));\
+        }\
+        )
+    #define recalloc(mem_ptr, count, size) (\
+        {\
+            if (NULL == (mem_ptr))\
+            {\
+                (mem_ptr) = calloc((count), (size));\
+            }\
+            else\
+            {\
+                (mem_ptr) = realloc((mem_ptr), (count) * (size));\
+            }\
+            mem_ptr;\
+        }\
+        )
+    #define node_data(node, node_type) (((typeof(node_type)*) ((node)->data))[0])
+
+    #endif
+//End of file
@@ -5,12 +5,38 @@
     #include <ctype.h>
     #include <fcntl.h>
     #include <errno.h>
+    #include <dirent.h>
+    #include <poll.h>
+    #include <time.h>
     #include <stdio.h>
+    #include <locale.h>
+    #include <signal.h>
     #include <stdlib.h>
     #include <string.h>
     #include <unistd.h>
     #include <ncurses.h>
+    #include <sys/mman.h>
     #include <sys/stat.h>
+    #include <sys/ioctl.h>
+    #include <sys/inotify.h>
+    #include "macros.h"
+    #include "arena.h"
+    #include "index.h"
+    #include "buffer.h"
+    #include "search.h"
+    #include "finder.h"
+    #include "browser.h"
+    #include "project.h"
+    #include "save.h"
+    #include "history.h"
+    #include "syntax.h"
+    #include "bench.h"
+    #include "trace.h"
+    #include "recording.h"
+    #include "delta.h"
+    #include "unpack.h"
+    #include "metrics.h"
+    #include "columns.h"
 
 /*////////////////////////////
     Defines
@@ -28,40 +54,113 @@
     #define PAIR_GRAY           3
     #define PAIR_BLACK          4
     #define PAIR_TAN            5
+    #define PAIR_MATCH          6
     #define RGB_DARK_GRAY       100,100,100
     #define RGB_GRAY            150,150,150
     #define RGB_RED             784,0,0
     #define RGB_BLACK           0,0,0
     #define RGB_TAN             200,200,200
-
-/*////////////////////////////
-    Macros
-*/////////////////////////////
-    #define CTRL_KEY(k) ((k) & 0x1f)
-    #define free(pointer) (\
-        {\
-            (free(pointer));\
-            ((pointer) = (NULL));\
-        }\
-        )
-    #define recalloc(mem_ptr, count, size) (\
-        {\
-            if (NULL == (mem_ptr))\
-            {\
-                (mem_ptr) = calloc((count), (size));\
-            }\
-            else\
-            {\
-                (mem_ptr) = realloc((mem_ptr), (count) * (size));\
-            }\
-            mem_ptr;\
-        }\
-        )
-    #define node_data(node, node_type) (((typeof(node_type)*) ((node)->data))[0])
+    #define RGB_MATCH           900,700,100
+    #define COLOR_MATCH         COLOR_WHITE+4
+    #define COLOR_SYNTAX        COLOR_WHITE+5
+    #define PAIR_SYNTAX         7
+    #define PAIR_SYNTAX_CURSOR  PAIR_SYNTAX+TOKEN_COUNT
+    #define EVENT_INPUT         0
+    #define EVENT_SIGNAL        1
+    #define EVENT_WATCH         2
+    #define EVENT_COUNT         3
+    #define MAX_TIMERS          8
+    #define MAX_TYPED_RUN       4096
+    #define MAX_PROMPT_SIZE     256
+    #define MAX_EXTENDED_KEYS   1024
+    #define MAX_FUZZY_RESULTS   256
 
 /*////////////////////////////
     Structs
 */////////////////////////////
+    struct keypress{
+        int64_t                 key;        //key code from getch
+        MEVENT                  mouse;      //mouse event when key is KEY_MOUSE
+    };
+    struct periodic{
+        u_int64_t               due;        //monotonic time of next run in ms
+        u_int64_t               interval;   //ms between runs
+        int                     (*callback)();//work to run, nonzero cancels the timer
+    };
+    struct prompt{
+        u_int8_t                active;     //keys go to the prompt
+        const char *            label;      //text shown before the input
+        char                    text[MAX_PROMPT_SIZE];//typed input, null terminated
+        u_int64_t               length;     //bytes typed
+        void                    (*accept)(const char * text);//run on enter
+        void                    (*change)(const char * text);//run as the text is edited, may be NULL
+        void                    (*cancel)();//run on escape, may be NULL
+        void                    (*navigate)(int64_t input);//run on up and down, may be NULL
+    };
+    struct search{
+        char                    pattern[MAX_PATTERN_SIZE];//bytes to find, highlighted while set
+        u_int64_t               length;     //bytes in pattern
+        u_int64_t               cursx;      //cursor x when the search began
+        u_int64_t               cursy;      //cursor y when the search began
+        u_int64_t               scrolly;    //vertical scroll when the search began
+        u_int8_t                regex;      //pattern is a regex searched by the finder
+        u_int8_t                pending;    //regex waits for the index before starting
+        u_int8_t                polling;    //regex results are being polled
+        u_int8_t                invalid;    //last regex failed to compile
+        u_int64_t               shown;      //regex matches painted so far
+    };
+    struct fuzzy{
+        u_int8_t                active;     //results replace the file rows
+        u_int64_t               results[MAX_FUZZY_RESULTS];//project paths, best first
+        u_int64_t               count;      //results in use
+        u_int64_t               selected;   //result opened on enter
+    };
+    struct place{
+        u_int8_t                at_end;     //the cursor was on the last line
+        u_int64_t               cursy;      //cursor line
+        u_int64_t               column;     //column the cursor was drawn at
+        u_int64_t               scrollx;    //horizontal scroll
+        u_int64_t               scrolly;    //vertical scroll
+    };
+    struct document{
+        char *                  file;       //path the file was opened from
+        char *                  owned_file; //heap copy of file, NULL when it is not owned
+        buffer_t *              text;       //piece table over the file data, NULL once evicted
+        char *                  data;       //file contents (mapping or heap copy)
+        u_int64_t               data_size;  //length of file contents
+        u_int8_t                mapped;     //data is a memory mapping
+        u_int64_t               map_size;   //bytes mapped, past data_size when following
+        int                     data_fd;    //descriptor data was mapped from, -1 when read
+        struct stat             disk;       //the file on disk when last read or written
+        u_int8_t                modified;   //edited since last read or written
+        u_int8_t                patched;    //changes on disk were applied over data, which no longer matches
+        u_int8_t                packed;     //data is the file decompressed, which is read only
+        u_int8_t                lost;       //pages of data cut off on disk were read back as zeros
+        unpack_t *              unpack;     //decompresses the rest of the file, NULL once done
+        history_t               history;    //undo and redo of the file
+        syntax_t                syntax;     //lexer states for coloring the file
+        u_int64_t               cursx;      //cursor x when it was last shown
+        u_int64_t               cursy;      //cursor y when it was last shown
+        u_int64_t               scrollx;    //horizontal scroll when it was last shown
+        u_int64_t               scrolly;    //vertical scroll when it was last shown
+        u_int64_t               used;       //switch it was last shown on, the oldest is evicted first
+    };
+    struct replay{
+        u_int8_t                active;     //a replay is running, its report is printed on exit
+        const char *            path;       //recording being replayed
+        bench_t                 bench;      //cost of every replayed frame
+        u_int64_t               started;    //monotonic ns the replay began
+        u_int64_t               bytes;      //terminal bytes every frame emitted together
+    };
+    struct frame{
+        u_int8_t                valid;      //set once a frame has been painted
+        u_int64_t               cursy;      //highlighted line
+        u_int64_t               scrollx;    //horizontal scroll
+        u_int64_t               scrolly;    //vertical scroll
+        u_int64_t               state;      //working state
+        u_int64_t               lines;      //terminal rows
+        u_int64_t               cols;       //terminal columns
+    };
     struct state{
         u_int64_t               cursx;      //cursor x
         u_int64_t               cursy;      //cursor y
@@ -69,15 +168,80 @@
         u_int64_t               margin_top; //top margin for file view
         u_int64_t               scrollx;    //horizontal scroll within file
         u_int64_t               scrolly;    //vertical scroll within file
-        u_int64_t               line_count; //size of current file buffer
-        char **                 buffer;     //current file buffer
-        u_int64_t *             buffer_size;//length of each line number
+        buffer_t *              text;       //piece table over the file data
+        char *                  data;       //file contents (mapping or heap copy)
+        u_int64_t               data_size;  //length of file contents
+        u_int8_t                mapped;     //data is a memory mapping
+        u_int64_t               map_size;   //bytes mapped, past data_size when following
+        int                     data_fd;    //descriptor data was mapped from, -1 when read
+        struct stat             disk;       //the file on disk when last read or written
+        u_int8_t                modified;   //edited since last read or written
+        u_int8_t                patched;    //changes on disk were applied over data, which no longer matches
+        u_int8_t                packed;     //data is the file decompressed, which is read only
+        u_int8_t                lost;       //pages of data cut off on disk were read back as zeros
+        u_int8_t                holding;    //a reload found the file too short for the cursor
+        struct place            held;       //where the cursor was before that reload, restored by the next
+        u_int64_t               held_line;  //line that reload left the cursor on, leaving it drops the hold
+        unpack_t *              unpack;     //decompresses the rest of the file, NULL once done
+        u_int8_t                unpack_polling;//decompression is advanced by a timer
+        u_int64_t               indexed_lines;//line count when the indexer was last polled
         char *                  file;       //current file
+        char *                  owned_file; //heap copy of file when it was picked in the browser
         char *                  dir;        //current working directory
+        u_int64_t               jobs;       //threads indexing large files, 0 for one per core
+        int                     sync;       //SYNC_NONE, SYNC_DATA or SYNC_FULL when saving
+        history_t               history;    //undo and redo of the open file
+        u_int64_t               undo_limit; //history bytes kept in memory before spilling
+        u_int64_t               unpack_limit;//text bytes a compressed file may decompress to
+        syntax_t                syntax;     //lexer states for coloring the open file
+        columns_t               columns;    //where long lines of the shown file reach each column
+        struct document *       documents;  //every open file, the active one's fields live here instead
+        u_int64_t               document_count;//files open
+        u_int64_t               document_capacity;//documents allocated
+        u_int64_t               active;     //document shown
+        u_int64_t               switches;   //files shown so far, stamps documents for eviction
+        u_int64_t               memory_budget;//bytes open files may hold before inactive ones are evicted
+        u_int8_t                index_polling;//indexing progress is being polled
+        u_int8_t                project_polling;//the project index is polled until it is ready
+        u_int8_t                view;       //files are read only with a sparse line index
+        u_int8_t                follow;     //the shown file is watched and grows as it is appended to
+        int                     watch_fd;   //inotify instance, -1 when unavailable
+        int                     watch;      //watch on the shown file, -1 for none
+        u_int8_t                disk_pending;//a change to the shown file waits on the check timer
+        const char *            notice;     //shown in the banner until the next key
+        u_int8_t *              dirty;      //rows needing a repaint
+        struct frame            painted;    //view as of the last repaint
+        struct prompt           prompt;     //single line input in the banner
+        struct search           search;     //incremental find and match highlighting
+        finder_t                finder;     //background regex search
+        browser_t               browser;    //directory listings for the file select pane
+        project_t               project;    //every file under the working directory
+        struct fuzzy            fuzzy;      //fuzzy open results
+        struct keypress *       keys;       //input drained in the current batch
+        u_int64_t               key_count;  //keys in the current batch
+        u_int64_t               key_capacity;//keys allocated
+        trace_t                 trace;      //keystroke to paint latency
+        char *                  trace_file; //where the trace is written on exit, NULL for none
+        u_int8_t                latency;    //latency percentiles are shown in the banner
+        recording_t             recording;  //input being recorded, file is NULL when not
+        struct replay           replay;     //recorded input being applied without a terminal
     };
     struct arguments{
       char *                    file;
       char *                    dir;
+      u_int64_t                 jobs;
+      int                       sync;
+      u_int64_t                 undo_limit;
+      u_int64_t                 unpack_limit;
+      u_int64_t                 memory_budget;
+      u_int8_t                  view;
+      u_int8_t                  follow;
+      char *                    bench;
+      char *                    trace;
+      u_int8_t                  latency;
+      char *                    record;
+      char *                    replay;
+      u_int8_t                  realtime;
     };
     struct node;
     struct node{
@@ -88,7 +252,16 @@
 /*////////////////////////////
     Typedefs
 */////////////////////////////
+    typedef struct document     document_t;
+    typedef struct replay       replay_t;
+    typedef struct frame        frame_t;
     typedef struct state        state_t;
+    typedef struct keypress     keypress_t;
+    typedef struct periodic     periodic_t;
+    typedef struct prompt       prompt_t;
+    typedef struct search       search_t;
+    typedef struct fuzzy        fuzzy_t;
+    typedef struct place        place_t;
     typedef struct node         node_t;
     typedef struct argp_option  argp_option_t;
     typedef struct argp_state   argp_state_t;
@@ -101,11 +274,56 @@
 */////////////////////////////
     //Output
         static void editorRefreshScreen();
+        static void printLine(u_int64_t row, u_int64_t col, u_int64_t line);
+        static void paintCells(u_int64_t row, u_int64_t col, const char * cells, const u_int64_t * places, const u_int64_t * marks, u_int64_t begin, u_int64_t end);
+        static void highlightSyntax(u_int64_t row, u_int64_t col, const u_int8_t * tokens, const char * cells, const u_int64_t * places, const u_int64_t * marks, u_int64_t visible, u_int8_t cursor);
+        static void highlightLiteral(u_int64_t row, u_int64_t col, u_int64_t start, u_int64_t length, u_int64_t first, u_int64_t visible, const char * cells, const u_int64_t * places, const u_int64_t * marks);
+        static void highlightRegex(u_int64_t row, u_int64_t col, u_int64_t start, u_int64_t first, u_int64_t visible, const char * cells, const u_int64_t * places, const u_int64_t * marks);
+        static void paintRow(u_int64_t row);
+        static void paintBanner(u_int64_t row);
+        static void formatLatency(char * text, u_int64_t size, u_int64_t nanoseconds);
+        static void paintBrowserRow(u_int64_t row);
+        static void paintFuzzyRow(u_int64_t row);
+        static void scrollView(int64_t delta);
+        static void markDirtyLine(u_int64_t line);
+        static void markDirtyFrom(u_int64_t line);
+        static void markAllDirty();
+        static void markDirtyBanner();
     //File
         static void closeFile();
-        static void openFile(char * fname);
+        static void releaseFile();
+        static void reloadFile();
+        static void openFile(char * fname, char * owned);
+        static void storeFile();
+        static void loadFile(u_int64_t index);
+        static void switchFile(u_int64_t index);
+        static void closeDocument();
+        static void trimFiles();
+        static void resetFile();
+        static u_int64_t fileMemory(document_t * document);
+        static void watchIndexing();
+        static void watchFile();
+        static void unwatchFile();
+        static void scheduleCheck();
+        static int checkDisk();
+        static int mappingShrunk();
+        static void checkShrunk();
+        static void growFile(u_int64_t size);
+        static void refreshFile();
+        static u_int64_t remapLine(u_int64_t target, u_int64_t line, u_int64_t removed, u_int64_t added);
+        static u_int64_t countNewlines(const char * text, u_int64_t length);
         static void getFileContents();
+        static int openText();
+        static int mapFileContents(int file_desc);
+        static int unpackFileContents(int file_desc);
+        static int pollUnpacking();
+        static void watchUnpacking();
+        static int readFileContents(int file_desc);
+        static int pollIndexing();
         static int64_t getLineLength(u_int64_t line);
+        static u_int64_t getLineCount();
+        static u_int64_t getCursorOffset();
+        static void saveFile();
     //Cursor
         static void moveBegin();
         static void moveEOL();
@@ -113,15 +331,93 @@
         static void moveRight();
         static void moveDown();
         static void moveUp();
+        static void movePage(int64_t pages);
+        static void moveToLine(u_int64_t line);
+        static void moveToOffset(u_int64_t offset);
+        static void moveFileStart();
+        static void moveFileEnd();
+        static void moveLines(int64_t count);
+        static void moveChars(int64_t count);
+        static u_int64_t getCursorColumn();
+        static void setCursorColumn(u_int64_t column);
+        static void followCursor();
+        static void placeCursor();
+    //Edit
+        static void insertChar(char input);
+        static void insertText(const char * text, u_int64_t length);
+        static void insertNewline();
+        static void deleteBackward();
+        static void deleteForward();
+        static int readOnly();
+        static void markEdited(u_int64_t line, u_int64_t from, u_int64_t removed, u_int64_t added);
+        static void undoEdit();
+        static void redoEdit();
     //Input
-        static void editorProcessKeypress();
+        static void editorProcessKeypress(keypress_t * keypress);
+        static int findExtendedKey(const char * name);
+        static int isTyped(int64_t key);
+    //Prompt
+        static void openPrompt(const char * label, void (*accept)(const char * text), void (*change)(const char * text), void (*cancel)());
+        static void closePrompt();
+        static void promptKeypress(int64_t input);
+        static void acceptGotoLine(const char * text);
+    //Browser
+        static void openBrowser();
+        static void browserKeypress(int64_t input, MEVENT * event);
+        static void selectEntry(int64_t delta);
+        static void activateEntry(u_int64_t index);
+    //Fuzzy Open
+        static void openFuzzy();
+        static void changeFuzzy(const char * text);
+        static void acceptFuzzy(const char * text);
+        static void cancelFuzzy();
+        static void navigateFuzzy(int64_t input);
+        static int pollProject();
+    //Search
+        static void openSearch();
+        static void changeSearch(const char * text);
+        static void acceptSearch(const char * text);
+        static void cancelSearch();
+        static void clearSearch();
+        static void findNext();
+        static void findPrevious();
+        static void acceptRegex(const char * text);
+        static void startRegex();
+        static int pollRegex();
+    //Events
+        static void eventLoop();
+        static void processInput();
+        static keypress_t * nextKeypress();
+        static void applyKeys();
+        static void handleSignals();
+        static void handleWatch();
+        static void onSignal(int signal_number);
+        static void onBusError(int signal_number, siginfo_t * info, void * context);
+        static void findFault();
+        static void resizeTerminal();
+        static int addTimer(u_int64_t interval, int (*callback)());
+        static void paceTimer(int (*callback)(), u_int64_t interval);
+        static int runTimers();
+        static u_int64_t monotonicMilliseconds();
     //Execution Flow
         static void initProgram();
+        static void guardMappings();
         static void exitFunc();
         static void die(const char *s);
         static error_t parse_opt (int key, char * p_arg, argp_state_t * p_state);
+    //Bench
+        static int runBench(const char * dir);
+        static void benchFile(bench_t * bench, const char * dir, char * path, const char * name);
+        static int compareNames(const void * left, const void * right);
+    //Recording
+        static void recordKeys();
+        static void recordResize();
+        static void runReplay(const char * path, u_int8_t realtime);
+        static void reportReplay();
     //Terminal
         static void initCurses();
+        static void initHeadless(u_int8_t counting);
+        static u_int64_t terminalBytes();
         static void exitCurses();
 
 /*////////////////////////////
@@ -130,13 +426,54 @@
     state_t     program;
     char *      DEFAULT_FILE =          NULL;
     char *      DEFAULT_DIR =           NULL;
+    u_int64_t   DEFAULT_JOBS =          0;
+    int         DEFAULT_SYNC =          SYNC_FULL;
+    u_int64_t   DEFAULT_UNDO_LIMIT =    67108864;
+    u_int64_t   DEFAULT_UNPACK_LIMIT =  1073741824;
+    u_int64_t   DEFAULT_MEMORY_BUDGET = 536870912;
+    u_int64_t   VIEW_INDEX_BUDGET =     67108864;
+    u_int64_t   FOLLOW_WINDOW =         68719476736;
+    u_int64_t   WATCH_INTERVAL =        50;
+    u_int64_t   REFRESH_LIMIT =         67108864;
+    u_int64_t   UNPACK_WINDOW =         1099511627776;
+    u_int64_t   UNPACK_FIRST =          1048576;
+    u_int64_t   UNPACK_STEP =           4194304;
+    u_int64_t   UNPACK_INTERVAL =       1;
+    u_int64_t   UNPACK_WAIT_INTERVAL =  100;
     u_int64_t   DEFAULT_STATE =         STATE_FILE_EDIT;
     u_int64_t   DEFAULT_SCROLL =        0;
     u_int64_t   FILE_BROWSER_WIDTH =    64;
     u_int64_t   MAX_PATH_SIZE =         1024;
-    u_int64_t   MAX_LINE_SIZE =         512;
+    u_int64_t   READ_CHUNK_SIZE =       65536;
     u_int64_t   SCROLLX_BUFFER =        5;
     u_int64_t   SCROLLY_BUFFER =        3;
+    u_int64_t   ESCAPE_DELAY =          25;
+    u_int64_t   MIN_KEY_CAPACITY =      64;
+    u_int64_t   MIN_DOCUMENT_CAPACITY = 8;
+    u_int64_t   INDEX_POLL_INTERVAL =   100;
+    u_int64_t   REGEX_POLL_INTERVAL =   50;
+    u_int64_t   PROJECT_POLL_INTERVAL = 100;
+    u_int64_t   BENCH_ROWS =            50;
+    u_int64_t   BENCH_COLS =            200;
+    u_int64_t   BENCH_FRAMES =          200;
+    u_int64_t   BENCH_MOVES =           2000;
+    u_int64_t   BENCH_LINES =           100;
+    char *      BENCH_PATTERN =         "pattern absent from every corpus";
+    char *      BENCH_REGEX =           "[qz][0-9]{3}x";
+    char *      BENCH_TERM =            "xterm-256color";
+    //plain, keyword, type, string, number, comment, preprocessor, key, section
+    short       SYNTAX_RGB[TOKEN_COUNT][3] = {
+        {0, 0, 0}, {1000, 650, 300}, {450, 850, 1000}, {650, 950, 450}, {950, 550, 800},
+        {700, 700, 600}, {1000, 450, 450}, {450, 850, 1000}, {1000, 850, 450}
+    };
+    int         KEY_CTRL_HOME =         -1;
+    int         KEY_CTRL_END =          -1;
+    int         signal_pipe[2] =        {-1, -1};
+    u_int64_t   page_size =             4096;
+    uintptr_t   fault_address =         0;
+    FILE *      terminal_output =       NULL;
+    periodic_t  timers[MAX_TIMERS];
+    u_int64_t   timer_count =           0;
 
 /*////////////////////////////
     Functions
@@ -152,6 +489,19 @@
                 argp_option_t options[] = {
                     {"file",        'f', "FILE",    0,  "file to open",         0},
                     {"directory",   'd', "DIR",     0,  "working directory",    0},
+                    {"jobs",        'j', "JOBS",    0,  "threads indexing large files, 0 for one per core",0},
+                    {"sync",        's', "MODE",    0,  "flush on save: none, data or full",0},
+                    {"undo-memory", 'u', "BYTES",   0,  "undo history kept in memory before spilling to disk",0},
+                    {"unpack-limit",'z', "BYTES",   0,  "text a compressed file may decompress to in TMPDIR, the rest is not shown",0},
+                    {"memory",      'm', "BYTES",   0,  "memory open files may hold before inactive ones are evicted",0},
+                    {"view",        'v', 0,         0,  "open files read only with a line index of bounded size",0},
+                    {"follow",      'F', 0,         0,  "show lines appended to the open file as they are written",0},
+                    {"bench",       'b', "DIR",     0,  "time the editor on every file in DIR without a terminal and print JSON",0},
+                    {"trace",       't', "FILE",    0,  "write keystroke to paint latency histograms to FILE on exit",0},
+                    {"latency",     'l', 0,         0,  "show keystroke to paint latency percentiles in the banner",0},
+                    {"record",      'r', "FILE",    0,  "record every key, mouse event and resize to FILE",0},
+                    {"replay",      'p', "FILE",    0,  "apply the input recorded in FILE without a terminal and print timings as JSON",0},
+                    {"realtime",    'R', 0,         0,  "replay at the recorded pace instead of as fast as possible",0},
                     { 0 }
                 };
             
@@ -159,19 +509,62 @@
                 args_t args;
                 args.file = DEFAULT_FILE;
                 args.dir = DEFAULT_DIR;
+                args.jobs = DEFAULT_JOBS;
+                args.sync = DEFAULT_SYNC;
+                args.undo_limit = DEFAULT_UNDO_LIMIT;
+                args.unpack_limit = DEFAULT_UNPACK_LIMIT;
+                args.memory_budget = DEFAULT_MEMORY_BUDGET;
+                args.view = 0;
+                args.follow = 0;
+                args.bench = NULL;
+                args.trace = NULL;
+                args.latency = 0;
+                args.record = NULL;
+                args.replay = NULL;
+                args.realtime = 0;
                 
                 //process input
                 argp_t argp = {options, parse_opt, ARGS_DOC, PROG_DOC, 0, 0, 0};
                 argp_parse(&argp, argc, argv, 0, 0, &args);
 
+                //text is measured and drawn in the terminal's encoding
+                setlocale(LC_CTYPE, "");
+
                 //start screen
                 atexit(exitFunc);
-                initCurses();
+                if ((NULL == args.bench) && (NULL == args.replay)){
+                    initCurses();
+                }else{
+                    initHeadless(NULL != args.replay);
+                }
 
                 //setup initial state
                 initProgram();
-                program.file = args.file;
+                guardMappings();
                 program.dir = args.dir;
+                program.jobs = args.jobs;
+                program.sync = args.sync;
+                program.undo_limit = args.undo_limit;
+                program.unpack_limit = args.unpack_limit;
+                program.memory_budget = args.memory_budget;
+                program.view = args.view;
+                //without inotify files are simply not watched, unless following
+                program.watch_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+                if (args.follow){
+                    if (-1 == program.watch_fd){
+                        die("main - inotify_init1");
+                    }
+                    program.follow = 1;
+                }
+                program.trace_file = args.trace;
+                program.latency = args.latency;
+                if (NULL != args.record){
+                    if (0 != recordingCreate(&program.recording, args.record, benchNow())){
+                        die("main - recordingCreate");
+                    }
+                    //the first event is the size everything after was laid out for
+                    recordResize();
+                }
 
                 //colors
                 init_color(COLOR_DARK_GRAY, RGB_DARK_GRAY);
@@ -179,15 +572,27 @@
                 init_color(COLOR_GRAY, RGB_GRAY);
                 init_color(COLOR_BLACK, RGB_BLACK);
                 init_color(COLOR_TAN, RGB_TAN);
+                init_color(COLOR_MATCH, RGB_MATCH);
                 init_pair(PAIR_DARK_GRAY, COLOR_WHITE, COLOR_DARK_GRAY);
                 init_pair(PAIR_RED, COLOR_WHITE, COLOR_RED);
                 init_pair(PAIR_BLACK, COLOR_WHITE, COLOR_BLACK);
                 init_pair(PAIR_GRAY, COLOR_WHITE, COLOR_GRAY);
                 init_pair(PAIR_TAN, COLOR_WHITE, COLOR_TAN);
+                init_pair(PAIR_MATCH, COLOR_BLACK, COLOR_MATCH);
+                for (short token = TOKEN_PLAIN + 1; token < TOKEN_COUNT; token++){
+                    init_color(COLOR_SYNTAX + token, SYNTAX_RGB[token][0], SYNTAX_RGB[token][1], SYNTAX_RGB[token][2]);
+                    init_pair(PAIR_SYNTAX + token, COLOR_SYNTAX + token, COLOR_DARK_GRAY);
+                    init_pair(PAIR_SYNTAX_CURSOR + token, COLOR_SYNTAX + token, COLOR_GRAY);
+                }
                 wbkgd(stdscr, COLOR_PAIR(PAIR_DARK_GRAY));
                 move(program.cursy + program.margin_top, program.cursx);
                 refresh();
 
+                //benchmarks run instead of the editor
+                if (NULL != args.bench){
+                    return runBench(args.bench);
+                }
+
                 //check if directory was set
                 if (program.dir == DEFAULT_DIR){
                     char * curr_wd = calloc(MAX_PATH_SIZE, sizeof(char));
@@ -201,18 +606,20 @@
                     }
                 }
 
-                if (program.file == DEFAULT_FILE){
-                    program.state = STATE_FILE_SELECT;
+                if (args.file == DEFAULT_FILE){
+                    openBrowser();
                 }else{
-                    openFile(args.file);
+                    openFile(args.file, NULL);
                 }
 
-                //begin main loop
-                while (1){
-                    editorRefreshScreen();
-                    editorProcessKeypress();
-                    refresh();
+                //recorded input runs instead of the terminal's
+                if (NULL != args.replay){
+                    runReplay(args.replay, args.realtime);
+                    exit(EXIT_SUCCESS);
                 }
+
+                //begin main loop
+                eventLoop();
                 //exit
                 return EXIT_SUCCESS;
             }
@@ -228,432 +635,2833 @@
                 u_int64_t x;
                 u_int64_t y;
                 getyx(stdscr, y, x);
-                move(0, 0);
-                
-                //print each line of buffer
-                for (u_int64_t curr_line = 0; curr_line < (u_int64_t)LINES; curr_line++){
-                    move(curr_line, 0);
-                    clrtoeol();
-                    switch (program.state){
-                        case STATE_FILE_SELECT:
-                            //print top banner
-                            if (curr_line < program.margin_top){
-                                attron(COLOR_PAIR(PAIR_RED));
-                                u_int64_t file_length = strnlen(program.file, MAX_PATH_SIZE);
-                                u_int64_t dir_length = strnlen(program.dir, MAX_PATH_SIZE);
-                                mvwprintw(stdscr, curr_line, 0, program.file);
-                                for (u_int64_t blank = file_length; blank < ((u_int64_t)COLS - dir_length) / 2; blank++){
-                                    mvwprintw(stdscr, curr_line, blank, " ");
-                                }
-                                mvwprintw(stdscr, curr_line, (COLS - dir_length) / 2, program.dir);
-                                for (u_int64_t blank = ((u_int64_t)COLS + dir_length) / 2; blank < (u_int64_t)COLS; blank++){
-                                    mvwprintw(stdscr, curr_line, blank, " ");
-                                }
-                                attroff(COLOR_PAIR(PAIR_RED));
-                                continue;
-                            }
-                            if (NULL != program.file){
-                                attron(COLOR_PAIR(PAIR_TAN));
-                                for (u_int64_t blank = 0; blank < FILE_BROWSER_WIDTH; blank++){
-                                    mvwprintw(stdscr, curr_line, blank, " ");
-                                }
-                                attroff(COLOR_PAIR(PAIR_TAN));
-                                if (curr_line + program.scrolly < program.line_count){
-                                    //check if on current cursors line 
-                                    if (curr_line == program.cursy - program.scrolly + program.margin_top){
-                                        attron(COLOR_PAIR(PAIR_GRAY));
-                                        mvwprintw(stdscr, curr_line, FILE_BROWSER_WIDTH, program.buffer[curr_line + program.scrolly - program.margin_top] + program.scrollx);
-                                        for (u_int64_t blank = getLineLength(curr_line + program.scrolly - program.margin_top) + FILE_BROWSER_WIDTH; blank < (u_int64_t)COLS; blank++){
-                                            mvwprintw(stdscr, curr_line, blank, " ");
-                                        }
-                                        attroff(COLOR_PAIR(PAIR_GRAY));
-                                    //normal print
-                                    }else{
-                                        mvwprintw(stdscr, curr_line,  FILE_BROWSER_WIDTH, program.buffer[curr_line + program.scrolly - program.margin_top] + program.scrollx);
-                                    }
-                                }
-                            }
-                        break;
-                        
-                        case STATE_FILE_EDIT:
-                            //print top banner
-                            if (curr_line < program.margin_top){
-                                attron(COLOR_PAIR(PAIR_RED));
-                                u_int64_t file_length = strnlen(program.file, MAX_PATH_SIZE);
-                                u_int64_t dir_length = strnlen(program.dir, MAX_PATH_SIZE);
-                                mvwprintw(stdscr, curr_line, 0, program.file);
-                                for (u_int64_t blank = file_length; blank < ((u_int64_t)COLS - dir_length) / 2; blank++){
-                                    mvwprintw(stdscr, curr_line, blank, " ");
-                                }
-                                mvwprintw(stdscr, curr_line, (COLS - dir_length) / 2, program.dir);
-                                for (u_int64_t blank = ((u_int64_t)COLS + dir_length) / 2; blank < (u_int64_t)COLS; blank++){
-                                    mvwprintw(stdscr, curr_line, blank, " ");
-                                }
-                                attroff(COLOR_PAIR(PAIR_RED));
-                                continue;
-                            }
-                            if (curr_line + program.scrolly < program.line_count){
-                                //check if on current cursors line 
-                                if (curr_line == program.cursy - program.scrolly + program.margin_top){
-                                    attron(COLOR_PAIR(PAIR_GRAY));
-                                    mvwprintw(stdscr, curr_line, 0, program.buffer[curr_line + program.scrolly - program.margin_top] + program.scrollx);
-                                    for (u_int64_t blank = getLineLength(curr_line + program.scrolly - program.margin_top); blank < (u_int64_t)COLS; blank++){
-                                        mvwprintw(stdscr, curr_line, blank, " ");
-                                    }
-                                    attroff(COLOR_PAIR(PAIR_GRAY));
-                                //normal print
-                                }else{
-                                    mvwprintw(stdscr, curr_line, 0, program.buffer[curr_line + program.scrolly - program.margin_top] + program.scrollx);
-                                }
-                            }
-                        break;
+
+                //work out which rows changed since the last frame
+                if ((!program.painted.valid) || (program.painted.lines != (u_int64_t)LINES) || (program.painted.cols != (u_int64_t)COLS)){
+                    program.dirty = recalloc(program.dirty, LINES, sizeof(u_int8_t));
+                    if (NULL == program.dirty){
+                        die("editorRefreshScreen - calloc");
+                    }
+                    program.painted.lines = LINES;
+                    program.painted.cols = COLS;
+                    markAllDirty();
+                }else if ((program.painted.state != program.state) || (program.painted.scrollx != program.scrollx)){
+                    markAllDirty();
+                }else if (program.painted.scrolly != program.scrolly){
+                    scrollView(program.scrolly - program.painted.scrolly);
+                }
+                if (program.painted.cursy != program.cursy){
+                    markDirtyLine(program.painted.cursy);
+                    markDirtyLine(program.cursy);
+                }
+
+                //repaint only damaged rows
+                for (u_int64_t row = 0; row < (u_int64_t)LINES; row++){
+                    if (program.dirty[row]){
+                        paintRow(row);
+                        program.dirty[row] = 0;
                     }
                 }
+                program.painted.valid = 1;
+                program.painted.cursy = program.cursy;
+                program.painted.scrollx = program.scrollx;
+                program.painted.scrolly = program.scrolly;
+                program.painted.state = program.state;
                 //restore cursor position
                 move(y, x);
             }
-        /*////////////////////////////
-            File Functions
-        */////////////////////////////
             /*////////////////////////////
-                Close the currently open file
+                Paint row
+                    redraws a single screen row
             */////////////////////////////
-                static void closeFile(){
-                    program.file = NULL;
-                    for (u_int64_t iter = 0; iter < program.line_count; iter++){
-                        free(program.buffer[iter]);
+                static void paintRow(u_int64_t row){
+                    u_int64_t col = (STATE_FILE_SELECT == program.state) ? FILE_BROWSER_WIDTH : 0;
+                    u_int64_t line = row - program.margin_top + program.scrolly;
+                    //print top banner
+                    if (row < program.margin_top){
+                        paintBanner(row);
+                        return;
+                    }
+                    move(row, 0);
+                    clrtoeol();
+                    //fuzzy open results cover the file
+                    if (program.fuzzy.active){
+                        paintFuzzyRow(row);
+                        return;
+                    }
+                    if (STATE_FILE_SELECT == program.state){
+                        paintBrowserRow(row);
+                    }
+                    if (NULL == program.file){
+                        return;
+                    }
+                    if (line >= getLineCount()){
+                        return;
+                    }
+                    //check if on current cursors line
+                    if (line == program.cursy){
+                        if (col < (u_int64_t)COLS){
+                            mvwhline(stdscr, row, col, ' ' | COLOR_PAIR(PAIR_GRAY), COLS - col);
+                        }
+                        attron(COLOR_PAIR(PAIR_GRAY));
+                        printLine(row, col, line);
+                        attroff(COLOR_PAIR(PAIR_GRAY));
+                    //normal print
+                    }else{
+                        printLine(row, col, line);
                     }
-                    free(program.buffer);
-                    free(program.buffer_size);
-                    program.cursx = 0;
-                    program.cursy = 0;
-                    program.scrolly = DEFAULT_SCROLL;
-                    program.scrollx = 0;
-                    program.line_count = 0;
-                    program.buffer_size = 0;
-                    program.margin_top = 1;
                 }
             /*////////////////////////////
-                Open a file
+                Paint banner
+                    file name on the left, working directory centered and indexing progress on the right
             */////////////////////////////
-                static void openFile(char * fname){
+                static void paintBanner(u_int64_t row){
+                    mvwhline(stdscr, row, 0, ' ' | COLOR_PAIR(PAIR_RED), COLS);
+                    attron(COLOR_PAIR(PAIR_RED));
+                    //an open prompt takes over the banner
+                    if (program.prompt.active){
+                        mvwaddnstr(stdscr, row, 0, program.prompt.label, COLS);
+                        waddnstr(stdscr, program.prompt.text, program.prompt.length);
+                        attroff(COLOR_PAIR(PAIR_RED));
+                        return;
+                    }
                     if (NULL != program.file){
-                        closeFile();
+                        mvwaddnstr(stdscr, row, 0, program.file, COLS);
                     }
-                    program.file = fname;
-                    getFileContents();
+                    if (NULL != program.dir){
+                        u_int64_t dir_length = strnlen(program.dir, MAX_PATH_SIZE);
+                        if (dir_length < (u_int64_t)COLS){
+                            mvwaddnstr(stdscr, row, (COLS - dir_length) / 2, program.dir, dir_length);
+                        }
+                    }
+                    //progress of background indexing or searching on the right
+                    char status[64];
+                    int length = 0;
+                    if ((NULL != program.file) && (NULL != program.unpack) && (0 < program.unpack->input_size)){
+                        length = snprintf(status, sizeof(status), "unpacking %3llu%%", (unsigned long long)(program.unpack->consumed * 100 / program.unpack->input_size));
+                    }else if ((NULL != program.file) && (0 < program.data_size) && (1 == bufferIndexing(program.text))){
+                        length = snprintf(status, sizeof(status), "indexing %3llu%%", (unsigned long long)(bufferIndexedBytes(program.text) * 100 / program.data_size));
+                    }else if (NULL != program.notice){
+                        length = snprintf(status, sizeof(status), "%s", program.notice);
+                    }else if (program.search.invalid){
+                        length = snprintf(status, sizeof(status), "invalid pattern");
+                    }else if (program.search.regex){
+                        length = snprintf(status, sizeof(status), "%llu matches%s", (unsigned long long)finderMatchCount(&program.finder), finderRunning(&program.finder) ? "..." : "");
+                    }
+                    if ((0 < length) && (length < COLS)){
+                        mvwaddnstr(stdscr, row, COLS - length, status, length);
+                    }
+                    //latency percentiles left of the status
+                    if (program.latency){
+                        histogram_t * total = &program.trace.stages[TRACE_STAGE_TOTAL];
+                        char p50[16];
+                        char p99[16];
+                        formatLatency(p50, sizeof(p50), traceQuantile(total, 0.5));
+                        formatLatency(p99, sizeof(p99), traceQuantile(total, 0.99));
+                        char overlay[48];
+                        int overlay_length = snprintf(overlay, sizeof(overlay), "p50 %s p99 %s", p50, p99);
+                        int right = (0 < length) ? length + 1 : 0;
+                        if ((0 < overlay_length) && (overlay_length + right < COLS)){
+                            mvwaddnstr(stdscr, row, COLS - right - overlay_length, overlay, overlay_length);
+                        }
+                    }
+                    attroff(COLOR_PAIR(PAIR_RED));
                 }
             /*////////////////////////////
-                Get file contents
+                Format latency
+                    writes nanoseconds as microseconds or milliseconds
             */////////////////////////////
-                static void getFileContents(){
-                    if (NULL == program.file){
-                        return;
+                static void formatLatency(char * text, u_int64_t size, u_int64_t nanoseconds){
+                    if (nanoseconds < 1000000){
+                        snprintf(text, size, "%lluus", (unsigned long long)(nanoseconds / 1000));
+                    }else{
+                        snprintf(text, size, "%.1fms", (double)nanoseconds / 1000000.0);
                     }
-                    //open file
-                    int file_desc = open(program.file, O_RDONLY);
-                    if (-1 == file_desc){
+                }
+            /*////////////////////////////
+                Paint browser row
+                    one directory entry in the file select pane, stating it
+                    only now that it is visible
+            */////////////////////////////
+                static void paintBrowserRow(u_int64_t row){
+                    u_int64_t index = program.browser.scroll + row - program.margin_top;
+                    u_int64_t width = ((u_int64_t)COLS < FILE_BROWSER_WIDTH) ? (u_int64_t)COLS : FILE_BROWSER_WIDTH;
+                    u_int64_t pair = (index == program.browser.selected) ? PAIR_GRAY : PAIR_TAN;
+                    mvwhline(stdscr, row, 0, ' ' | COLOR_PAIR(pair), width);
+                    entry_t * entry = browserEntry(&program.browser, index);
+                    if (NULL == entry){
                         return;
                     }
-                    //setup for loop
-                    program.line_count++;
-                    program.buffer = recalloc(program.buffer, program.line_count, sizeof(char*));
-                    if (NULL == program.buffer){
-                        die("getLineContents - calloc");
+                    char size[16] = "";
+                    int size_length = 0;
+                    if (ENTRY_DIR != entry->type){
+                        const char * units = "BKMGTP";
+                        double amount = entry->size;
+                        while ((1024 <= amount) && ('\0' != units[1])){
+                            amount /= 1024;
+                            units++;
+                        }
+                        size_length = snprintf(size, sizeof(size), (units[0] == 'B') ? "%.0f%c" : "%.1f%c", amount, units[0]);
                     }
-                    program.buffer_size = recalloc(program.buffer_size, program.line_count, sizeof(u_int64_t));
-                    if (NULL == program.buffer_size){
-                        die("getLineContents - calloc");
+                    attron(COLOR_PAIR(pair));
+                    u_int64_t name_width = (width > (u_int64_t)size_length + 2) ? width - size_length - 2 : 0;
+                    mvwaddnstr(stdscr, row, 0, entry->name, name_width);
+                    if (ENTRY_DIR == entry->type){
+                        u_int64_t name_length = strlen(entry->name);
+                        if (name_length < name_width){
+                            mvwaddch(stdscr, row, name_length, '/');
+                        }
                     }
-                    program.buffer_size[program.line_count - 1] = 0;
-                    program.buffer[program.line_count-1] = calloc(MAX_LINE_SIZE, sizeof(char));
-                    if (NULL == program.buffer[program.line_count - 1]){
-                        die("getLineContents - calloc");
+                    if ((0 < size_length) && ((u_int64_t)size_length < width)){
+                        mvwaddnstr(stdscr, row, width - size_length - 1, size, size_length);
                     }
-                    u_int64_t offset = 0;
-                    char buffer;
-                    //read contents
-                    for(;;){
-                        //attempt to read
-                        ssize_t read_size = pread(file_desc, &buffer, 1, offset);
-                        if (0 >= read_size){
-                            break;
-                        }
-                        //copy into buffer
-                        offset++;
-                        memcpy(program.buffer[program.line_count - 1] + program.buffer_size[program.line_count - 1], &buffer, 1);
-                        program.buffer_size[program.line_count - 1]++;
-                        //check for end of lines
-                        if (buffer == '\n'){
-                            program.line_count++;
-                            program.buffer = recalloc(program.buffer, program.line_count, sizeof(char*));
-                            if (NULL == program.buffer){
-                                die("getLineContents - calloc");
-                            }
-                            program.buffer_size = recalloc(program.buffer_size, program.line_count, sizeof(u_int64_t));
-                            if (NULL == program.buffer_size){
-                                die("getLineContents - calloc");
-                            }
-                            program.buffer_size[program.line_count - 1] = 0;
-                            program.buffer[program.line_count-1] = calloc(MAX_LINE_SIZE, sizeof(char));
-                            if (NULL == program.buffer[program.line_count - 1]){
-                                die("getLineContents - calloc");
-                            }
+                    attroff(COLOR_PAIR(pair));
+                }
+            /*////////////////////////////
+                Paint fuzzy row
+                    one fuzzy open result, or the state of the project
+                    index on the first row until it is ready
+            */////////////////////////////
+                static void paintFuzzyRow(u_int64_t row){
+                    u_int64_t index = row - program.margin_top;
+                    int ready = projectReady(&program.project);
+                    if (1 != ready){
+                        if (0 == index){
+                            const char * note = (0 == ready) ? "indexing project..." : "project index failed";
+                            mvwaddnstr(stdscr, row, 0, note, COLS);
                         }
+                        return;
+                    }
+                    if (index >= program.fuzzy.count){
+                        return;
+                    }
+                    const char * path = program.project.paths[program.fuzzy.results[index]];
+                    if (index == program.fuzzy.selected){
+                        mvwhline(stdscr, row, 0, ' ' | COLOR_PAIR(PAIR_GRAY), COLS);
+                        attron(COLOR_PAIR(PAIR_GRAY));
+                        mvwaddnstr(stdscr, row, 0, path, COLS);
+                        attroff(COLOR_PAIR(PAIR_GRAY));
+                    }else{
+                        mvwaddnstr(stdscr, row, 0, path, COLS);
                     }
-                    //cleanup
-                    close(file_desc);
                 }
             /*////////////////////////////
-                Get line length
-                    returns the length of a specific lineg
+                Scroll view
+                    shifts the file rows with the terminal's scroll region
+                    so only newly exposed rows are repainted
             */////////////////////////////
-                static int64_t getLineLength(u_int64_t line){
-                    if (NULL == program.file){
-                        return -1;
-                    }
-                    if (line >= program.line_count){
-                        return -1;
+                static void scrollView(int64_t delta){
+                    u_int64_t rows = LINES - program.margin_top;
+                    u_int64_t distance = (0 > delta) ? -delta : delta;
+                    if ((distance >= rows) || (program.margin_top >= (u_int64_t)LINES)){
+                        markAllDirty();
+                        return;
                     }
-                    if (0 == program.buffer_size[line]){
-                        return 0;
+                    setscrreg(program.margin_top, LINES - 1);
+                    scrollok(stdscr, TRUE);
+                    wscrl(stdscr, delta);
+                    scrollok(stdscr, FALSE);
+                    setscrreg(0, LINES - 1);
+                    //damage moves with the rows it was recorded against
+                    u_int8_t * first = program.dirty + program.margin_top;
+                    if (0 < delta){
+                        memmove(first, first + distance, rows - distance);
+                        memset(first + rows - distance, 1, distance);
+                    }else{
+                        memmove(first + distance, first, rows - distance);
+                        memset(first, 1, distance);
                     }
-                    return program.buffer_size[line] - 1;
                 }
-        /*////////////////////////////
-            Cursor Functions
-        */////////////////////////////
             /*////////////////////////////
-                Move to beginning of line
+                Mark dirty line
+                    schedules the row showing a file line for repaint
             */////////////////////////////
-                static void moveBegin(){
-                    program.cursx = 0;
-                    program.scrollx = 0;
-                    move(program.cursy - program.scrolly + program.margin_top, program.cursx);
+                static void markDirtyLine(u_int64_t line){
+                    if ((NULL == program.dirty) || (line < program.painted.scrolly)){
+                        return;
+                    }
+                    u_int64_t row = line - program.painted.scrolly + program.margin_top;
+                    if (row < program.painted.lines){
+                        program.dirty[row] = 1;
+                    }
                 }
             /*////////////////////////////
-                Move to end of line
+                Mark dirty from
+                    schedules every row from a file line down, used when lines shift
             */////////////////////////////
-                static void moveEOL(){
-                    int64_t length = getLineLength(program.cursy);
-                    if (0 > length){
+                static void markDirtyFrom(u_int64_t line){
+                    if (NULL == program.dirty){
                         return;
                     }
-                    program.cursx = length;
-                    while ((program.cursx - program.scrollx > (u_int64_t)COLS - SCROLLX_BUFFER) && (length - program.scrollx >= (u_int64_t)COLS) && (UINT64_MAX > program.scrollx)){
-                        program.scrollx++;
+                    u_int64_t row = program.margin_top;
+                    if (line > program.painted.scrolly){
+                        row += line - program.painted.scrolly;
+                    }
+                    for (; row < program.painted.lines; row++){
+                        program.dirty[row] = 1;
                     }
-                    move(program.cursy - program.scrolly + program.margin_top, program.cursx - program.scrollx);
                 }
             /*////////////////////////////
-                Move cursor left
+                Mark all dirty
+                    schedules a full repaint
             */////////////////////////////
-                static void moveLeft(){
-                    int64_t length = getLineLength(program.cursy);
-                    //if we were previously beyond line length
-                    if ((0 <= length) && (program.cursx > (u_int64_t)length)){
-                        program.cursx = length;
-                    }
-                    //if there is more to our left
-                    if (0 < program.cursx){
-                        program.cursx--;
-                        //scroll left
-                        if ((0 < program.scrollx) && (program.cursx - program.scrollx < SCROLLX_BUFFER)){
-                            program.scrollx--;
-                        }
-                        move(program.cursy - program.scrolly + program.margin_top, program.cursx - program.scrollx);
-                    }else{
-                        //go to end of previous line
-                        if (0 < program.cursy){
-                            moveUp();
-                            moveEOL();
-                        }
+                static void markAllDirty(){
+                    if (NULL == program.dirty){
+                        return;
                     }
+                    memset(program.dirty, 1, program.painted.lines);
                 }
             /*////////////////////////////
-                Move cursor right
+                Mark dirty banner
+                    schedules the banner rows for repaint
             */////////////////////////////
-                static void moveRight(){
-                    int64_t length = getLineLength(program.cursy);
-                    //there is more to right
-                    if ((0 <= length) && (program.cursx + 1 <= (u_int64_t)length)){
-                        program.cursx++;
-                        //scroll right
-                        if (((u_int64_t)COLS < program.cursx + SCROLLX_BUFFER) && (length - program.scrollx >= (u_int64_t)COLS) && (UINT64_MAX > program.scrollx)){
-                            program.scrollx++;
-                        }
-                        move(program.cursy - program.scrolly + program.margin_top, program.cursx - program.scrollx);
-                    }else{
-                        //go to start of next line
-                        if (program.cursy < program.line_count){
-                            moveDown(program);
-                            moveBegin(program);
-                        }
+                static void markDirtyBanner(){
+                    if (NULL == program.dirty){
+                        return;
+                    }
+                    for (u_int64_t row = 0; (row < program.margin_top) && (row < program.painted.lines); row++){
+                        program.dirty[row] = 1;
                     }
                 }
             /*////////////////////////////
-                Move cursor down
+                Print line
+                    prints the columns of a line that fit on the row, reading
+                    only the bytes drawn there so long lines cost no more
+                    than short ones, lines are not null terminated
             */////////////////////////////
-                static void moveDown(){
-                    int64_t length = getLineLength(program.cursy + 1);
-                    if (0 <= length){
-                        program.cursy++;
-                        //if we need to scroll down
-                        if ((UINT64_MAX > program.scrolly) && (program.cursy - program.scrolly + program.margin_top > (u_int64_t)LINES - SCROLLY_BUFFER)){
-                            program.scrolly++;
-                        }
-                        //if our x cursor was greater than line length
-                        if (program.cursx > (u_int64_t)length){
-                            //move our horizontal scroll left
-                            while ((0 < program.scrollx) && (program.scrollx > (u_int64_t)length - SCROLLX_BUFFER)){
-                                program.scrollx--;
-                            }
-                            move(program.cursy - program.scrolly + program.margin_top, length - program.scrollx);
-                        }else{//if our x cursor wasnt greater than line length
-                            //move our horizontal scroll right
-                            while ((program.cursx - program.scrollx > (u_int64_t)COLS - SCROLLX_BUFFER) && (length - program.scrollx >= (u_int64_t)COLS) && (UINT64_MAX > program.scrollx)){
-                                program.scrollx++;
+                static void printLine(u_int64_t row, u_int64_t col, u_int64_t line){
+                    static char * scratch = NULL;
+                    static char * cells = NULL;
+                    static u_int64_t * places = NULL;
+                    static u_int64_t * marks = NULL;
+                    static u_int64_t scratch_size = 0;
+                    int64_t length = getLineLength(line);
+                    if ((0 > length) || (col >= (u_int64_t)COLS)){
+                        return;
+                    }
+                    u_int64_t width = COLS - col;
+                    //the character drawn over the left edge may start before it
+                    u_int64_t column = 0;
+                    u_int64_t first = columnsOffsetOf(&program.columns, program.text, line, program.scrollx, &column);
+                    if (first >= (u_int64_t)length){
+                        return;
+                    }
+                    //every cell holds a character of a few bytes at most
+                    u_int64_t size = (width + 1) * MAX_CHAR_SIZE;
+                    u_int64_t visible = length - first;
+                    if (visible > size){
+                        visible = size;
+                    }
+                    if (size > scratch_size){
+                        scratch_size = size;
+                        scratch = recalloc(scratch, scratch_size, sizeof(char));
+                        cells = recalloc(cells, scratch_size, METRICS_GLYPH);
+                        places = recalloc(places, scratch_size + 1, sizeof(u_int64_t));
+                        marks = recalloc(marks, scratch_size + 1, sizeof(u_int64_t));
+                        if ((NULL == scratch) || (NULL == cells) || (NULL == places) || (NULL == marks)){
+                            die("printLine - calloc");
+                        }
+                    }
+                    u_int64_t start = bufferLineStart(program.text, line);
+                    visible = bufferRead(program.text, start + first, scratch, visible);
+                    //tabs, control bytes and wide characters are laid out here so the row never wraps
+                    u_int64_t filled = 0;
+                    u_int64_t written = 0;
+                    u_int64_t shown = 0;
+                    while (shown < visible){
+                        u_int64_t cell_width = 0;
+                        u_int64_t glyph_length = 0;
+                        const char * glyph = NULL;
+                        u_int64_t bytes = metricsChar(&program.columns.metrics, scratch + shown, visible - shown, column, &cell_width, &glyph, &glyph_length);
+                        u_int64_t skip = (column < program.scrollx) ? program.scrollx - column : 0;
+                        u_int64_t take = cell_width - skip;
+                        if (take > width - filled){
+                            take = width - filled;
+                        }
+                        if ((0 == take) && (0 != cell_width)){
+                            break;
+                        }
+                        for (u_int64_t iter = 0; iter < bytes; iter++){
+                            places[shown + iter] = filled;
+                            marks[shown + iter] = written;
+                        }
+                        //a wide character cut by an edge leaves blank cells
+                        if (take == cell_width){
+                            if ((0 != cell_width) || (0 != filled)){
+                                memcpy(cells + written, glyph, glyph_length);
+                                written += glyph_length;
                             }
-                            move(program.cursy - program.scrolly + program.margin_top, program.cursx - program.scrollx);
+                        }else if (glyph_length == cell_width){
+                            memcpy(cells + written, glyph + skip, take);
+                            written += take;
+                        }else{
+                            memset(cells + written, ' ', take);
+                            written += take;
                         }
+                        filled += take;
+                        column += cell_width;
+                        shown += bytes;
+                    }
+                    places[shown] = filled;
+                    marks[shown] = written;
+                    visible = shown;
+                    mvwaddnstr(stdscr, row, col, cells, written);
+                    //syntax colors over the visible columns
+                    u_int64_t token_length = 0;
+                    const u_int8_t * tokens = syntaxLine(&program.syntax, program.text, line, first + visible, &token_length);
+                    if ((NULL != tokens) && (token_length >= first + visible)){
+                        highlightSyntax(row, col, tokens + first, cells, places, marks, visible, line == program.cursy);
+                    }
+                    //matches over the visible columns
+                    if (program.search.regex){
+                        highlightRegex(row, col, start, first, visible, cells, places, marks);
+                    }else if (0 != program.search.length){
+                        highlightLiteral(row, col, start, length, first, visible, cells, places, marks);
                     }
                 }
             /*////////////////////////////
-                Move cursor up
+                Paint cells
+                    redraws the cells of the visible bytes from begin to end
+                    in the current colors
             */////////////////////////////
-                static void moveUp(){
-                    if (0 < program.cursy){
-                        program.cursy--;
-                        //if we need to scroll down
-                        if ((0 < program.scrolly) && (program.cursy - program.scrolly + program.margin_top < SCROLLY_BUFFER)){
-                            program.scrolly--;
-                        }
-                        int64_t length = getLineLength(program.cursy);
-                        //if our x cursor was greater than line length
-                        if ((0 <= length) && (program.cursx > (u_int64_t)length)){
-                            //move our horizontal scroll left
-                            while ((0 < program.scrollx) && (program.scrollx > (u_int64_t)length - SCROLLX_BUFFER)){
-                                program.scrollx--;
-                            }
-                            move(program.cursy - program.scrolly + program.margin_top, length - program.scrollx);
-                        }else{//if our x cursor was greater than line length
-                            //move our horizontal scroll right
-                            while ((program.cursx - program.scrollx > (u_int64_t)COLS - SCROLLX_BUFFER) && (length - program.scrollx >= (u_int64_t)COLS) && (UINT64_MAX > program.scrollx)){
-                                program.scrollx++;
-                            }
-                            move(program.cursy - program.scrolly + program.margin_top, program.cursx - program.scrollx);
+                static void paintCells(u_int64_t row, u_int64_t col, const char * cells, const u_int64_t * places, const u_int64_t * marks, u_int64_t begin, u_int64_t end){
+                    mvwaddnstr(stdscr, row, col + places[begin], cells + marks[begin], marks[end] - marks[begin]);
+                }
+            /*////////////////////////////
+                Highlight syntax
+                    repaints each run of colored tokens over the plain text
+            */////////////////////////////
+                static void highlightSyntax(u_int64_t row, u_int64_t col, const u_int8_t * tokens, const char * cells, const u_int64_t * places, const u_int64_t * marks, u_int64_t visible, u_int8_t cursor){
+                    u_int64_t base = cursor ? PAIR_SYNTAX_CURSOR : PAIR_SYNTAX;
+                    for (u_int64_t begin = 0; begin < visible;){
+                        u_int64_t end = begin + 1;
+                        while ((end < visible) && (tokens[end] == tokens[begin])){
+                            end++;
                         }
+                        if (TOKEN_PLAIN != tokens[begin]){
+                            attron(COLOR_PAIR(base + tokens[begin]));
+                            paintCells(row, col, cells, places, marks, begin, end);
+                            attroff(COLOR_PAIR(base + tokens[begin]));
+                        }
+                        begin = end;
                     }
                 }
-        /*////////////////////////////
-            Input Functions
-        */////////////////////////////
             /*////////////////////////////
-                Process Key for editor
-                    gets input and processes it
+                Highlight literal
+                    repaints literal matches overlapping the visible bytes,
+                    from first on, of the line at start, including ones cut
+                    by the left edge
             */////////////////////////////
-                static void editorProcessKeypress(){
-                    int64_t input = getch();
-                    MEVENT event;
-                    //keybinds that are always valid
-                    switch (input){
-                        case CTRL_KEY('q'):
-                            exit(EXIT_SUCCESS);
-                        break;
-                        default:
-                        break;
+                static void highlightLiteral(u_int64_t row, u_int64_t col, u_int64_t start, u_int64_t length, u_int64_t first, u_int64_t visible, const char * cells, const u_int64_t * places, const u_int64_t * marks){
+                    static char * scratch = NULL;
+                    static u_int64_t scratch_size = 0;
+                    u_int64_t pattern_length = program.search.length;
+                    u_int64_t left = (first > pattern_length - 1) ? first - (pattern_length - 1) : 0;
+                    u_int64_t right = first + visible + pattern_length - 1;
+                    if (right > length){
+                        right = length;
                     }
-                    if ((NULL == program.file) || (STATE_FILE_SELECT == program.state)){
-                        //when no file is open
-                        switch (input){
-                            case KEY_MOUSE:
-                                if (getmouse(&event) == OK){
-                                    //left mouse button on down
-                                    if(event.bstate & BUTTON1_PRESSED){
-                                        int x = strnlen(program.file, MAX_PATH_SIZE);
-                                        int y = program.margin_top;
-                                        wmouse_trafo(stdscr, &y, &x, FALSE);
-                                        if ((event.y < y) && (event.x < x)){
-                                            program.state = STATE_FILE_EDIT;
-                                            move(program.cursy - program.scrolly + program.margin_top, program.cursx - program.scrollx);
-                                        }
-                                    }
-                                    //middle mouse button on down
-                                    else if(event.bstate & BUTTON2_PRESSED){
-                                    }
-                                    //right mouse button on down
-                                    else if(event.bstate & BUTTON3_PRESSED){
-                                    }
-                                }
-                            break;
-                            default:
-                            break;
+                    if (right - left > scratch_size){
+                        scratch_size = right - left;
+                        scratch = recalloc(scratch, scratch_size, sizeof(char));
+                        if (NULL == scratch){
+                            die("highlightLiteral - calloc");
                         }
                     }
-                    else if ((NULL != program.file) && (STATE_FILE_EDIT == program.state)){
-                        //keybinds specific to open files
-                        switch (input){
-                            case KEY_LEFT:
-                                moveLeft();
-                            break;
-                            case KEY_RIGHT:
-                                moveRight();
-                            break;
-                            case KEY_DOWN:
-                                moveDown();
-                            break;
-                            case KEY_UP:
-                                moveUp();
-                            break;
-                            case KEY_ENTER:
-                            break;
-                            case KEY_BACKSPACE:
-                            break;
-                            case KEY_DC: //delete key
-                            break;
-                            case KEY_MOUSE:
-                                if (getmouse(&event) == OK){
-                                    //left mouse button on down
-                                    if(event.bstate & BUTTON1_PRESSED){
-                                        int x = strnlen(program.file, MAX_PATH_SIZE);
-                                        int y = program.margin_top;
-                                        wmouse_trafo(stdscr, &y, &x, FALSE);
-                                        if ((event.y < y) && (event.x < x)){
-                                            program.state = STATE_FILE_SELECT;
-                                            move(program.cursy - program.scrolly + program.margin_top, program.cursx - program.scrollx + FILE_BROWSER_WIDTH);
-                                        }
-                                    }
-                                    //middle mouse button on down
-                                    else if(event.bstate & BUTTON2_PRESSED){
-                                    }
-                                    //right mouse button on down
-                                    else if(event.bstate & BUTTON3_PRESSED){
-                                    }
-                                }
-                            break;
-                            default:
+                    u_int64_t window = bufferRead(program.text, start + left, scratch, right - left);
+                    attron(COLOR_PAIR(PAIR_MATCH));
+                    for (u_int64_t offset = 0; offset < window;){
+                        u_int64_t match = searchMemory(scratch + offset, window - offset, program.search.pattern, pattern_length);
+                        if (SEARCH_NONE == match){
                             break;
                         }
+                        //clip the match to the screen
+                        u_int64_t begin = left + offset + match;
+                        u_int64_t end = begin + pattern_length;
+                        if (begin < first){
+                            begin = first;
+                        }
+                        if (end > first + visible){
+                            end = first + visible;
+                        }
+                        if (begin < end){
+                            paintCells(row, col, cells, places, marks, begin - first, end - first);
+                        }
+                        offset += match + pattern_length;
                     }
+                    attroff(COLOR_PAIR(PAIR_MATCH));
+                }
+            /*////////////////////////////
+                Highlight regex
+                    repaints finished regex matches over the visible bytes,
+                    from first on, of the line at start
+            */////////////////////////////
+                static void highlightRegex(u_int64_t row, u_int64_t col, u_int64_t start, u_int64_t first, u_int64_t visible, const char * cells, const u_int64_t * places, const u_int64_t * marks){
+                    u_int64_t left = start + first;
+                    u_int64_t right = left + visible;
+                    //a match cut by the left edge starts before it
+                    const match_t * match = finderMatchBefore(&program.finder, left + 1);
+                    if ((NULL == match) || (match->offset < start) || (match->offset + match->length <= left)){
+                        match = finderMatchAfter(&program.finder, left);
+                    }
+                    attron(COLOR_PAIR(PAIR_MATCH));
+                    while ((NULL != match) && (match->offset < right)){
+                        u_int64_t begin = (match->offset < left) ? left : match->offset;
+                        u_int64_t end = (match->offset + match->length > right) ? right : match->offset + match->length;
+                        paintCells(row, col, cells, places, marks, begin - left, end - left);
+                        match = finderMatchAfter(&program.finder, match->offset + 1);
+                    }
+                    attroff(COLOR_PAIR(PAIR_MATCH));
                 }
-
         /*////////////////////////////
-            Execution Flow
+            File Functions
         */////////////////////////////
             /*////////////////////////////
-                Init, initializes program state to defaults
+                Close the currently open file
+                    and forget its document
             */////////////////////////////
-                static void initProgram(){
-                    program.file = DEFAULT_FILE;
-                    program.dir = DEFAULT_DIR;
-                    program.cursx = 0;
-                    program.cursy = 0;
-                    program.scrolly = DEFAULT_SCROLL;
-                    program.scrollx = 0;
-                    program.line_count = 0;
-                    program.buffer = NULL;
-                    program.buffer_size = 0;
-                    program.margin_top = 1;
+                static void closeFile(){
+                    if (NULL == program.file){
+                        return;
+                    }
+                    releaseFile();
+                    program.file = NULL;
+                    free(program.owned_file);
+                    program.document_count--;
+                    memmove(program.documents + program.active, program.documents + program.active + 1, (program.document_count - program.active) * sizeof(document_t));
+                    resetFile();
+                }
+            /*////////////////////////////
+                Release file
+                    frees the shown file's buffer, data, history and colors
+                    but keeps its path and document
+            */////////////////////////////
+                static void releaseFile(){
+                    //the finder and indexer read the data so they stop first
+                    clearSearch();
+                    unwatchFile();
+                    if (NULL != program.text){
+                        bufferClose(program.text);
+                        free(program.text);
+                        program.text = NULL;
+                    }
+                    if (NULL != program.data){
+                        if (program.mapped){
+                            munmap(program.data, program.map_size);
+                            program.data = NULL;
+                        }else{
+                            free(program.data);
+                        }
+                    }
+                    if (-1 != program.data_fd){
+                        close(program.data_fd);
+                        program.data_fd = -1;
+                    }
+                    if (NULL != program.unpack){
+                        unpackClose(program.unpack);
+                        free(program.unpack);
+                        program.unpack = NULL;
+                    }
+                    program.packed = 0;
+                    program.lost = 0;
+                    historyRelease(&program.history);
+                    syntaxRelease(&program.syntax);
+                    columnsTruncate(&program.columns, 0);
+                }
+            /*////////////////////////////
+                Reload file
+                    reads the shown file again from disk, keeping the cursor
+                    on the same line and column and the view around it when
+                    the line still exists or at the end when it was there
+                    a file rewritten in place is often cut short first, so a
+                    cursor the shorter file had no room for goes back where
+                    it was on the next reload unless it was moved since
+            */////////////////////////////
+                static void reloadFile(){
+                    place_t place = program.held;
+                    if ((!program.holding) || (program.cursy != program.held_line)){
+                        place.cursy = program.cursy;
+                        place.at_end = (place.cursy == getLineCount() - 1);
+                        //pages lost to a file cut short are not read, the byte offset stands in for the column
+                        place.column = ((program.lost) || (mappingShrunk())) ? program.cursx : getCursorColumn();
+                        place.scrollx = program.scrollx;
+                        place.scrolly = program.scrolly;
+                    }
+                    program.holding = 0;
+                    releaseFile();
+                    program.data = NULL;
+                    program.data_size = 0;
+                    program.map_size = 0;
+                    program.mapped = 0;
+                    program.text = calloc(1, sizeof(buffer_t));
+                    if (NULL == program.text){
+                        die("reloadFile - calloc");
+                    }
+                    getFileContents();
+                    program.painted.valid = 0;
+                    if (place.at_end){
+                        moveFileEnd();
+                        return;
+                    }
+                    moveToLine(place.cursy);
+                    if (place.cursy != program.cursy){
+                        program.holding = 1;
+                        program.held = place;
+                        program.held_line = program.cursy;
+                        return;
+                    }
+                    program.scrollx = place.scrollx;
+                    program.scrolly = (place.scrolly <= place.cursy) ? place.scrolly : place.cursy;
+                    setCursorColumn(place.column);
+                    followCursor();
+                    placeCursor();
+                }
+            /*////////////////////////////
+                Open a file
+                    switches to the file when it is already open, otherwise the
+                    shown file is kept open behind the new one
+                    owned is freed once it is no longer needed, NULL when fname
+                    is not owned
+            */////////////////////////////
+                static void openFile(char * fname, char * owned){
+                    for (u_int64_t iter = 0; iter < program.document_count; iter++){
+                        if (0 == strcmp(program.documents[iter].file, fname)){
+                            switchFile(iter);
+                            free(owned);
+                            return;
+                        }
+                    }
+                    storeFile();
+                    if (program.document_count == program.document_capacity){
+                        program.document_capacity = growCapacity(program.document_capacity, program.document_count + 1, MIN_DOCUMENT_CAPACITY);
+                        program.documents = realloc(program.documents, program.document_capacity * sizeof(document_t));
+                        if (NULL == program.documents){
+                            die("openFile - realloc");
+                        }
+                    }
+                    program.active = program.document_count++;
+                    memset(&program.documents[program.active], 0, sizeof(document_t));
+                    program.documents[program.active].file = fname;
+                    program.file = fname;
+                    program.owned_file = owned;
+                    program.text = calloc(1, sizeof(buffer_t));
+                    if (NULL == program.text){
+                        die("openFile - calloc");
+                    }
+                    getFileContents();
+                    //followed files open on their newest lines, as tail does,
+                    //once a file cut short while it was indexed is read again
+                    if (program.follow && program.mapped){
+                        if (0 != bufferFinishIndex(program.text)){
+                            die("openFile - index");
+                        }
+                        checkShrunk();
+                        moveFileEnd();
+                    }
+                    program.switches++;
+                    trimFiles();
+                }
+            /*////////////////////////////
+                Store file
+                    parks the shown file in its document, leaving no file shown
+            */////////////////////////////
+                static void storeFile(){
+                    if (NULL == program.file){
+                        return;
+                    }
+                    //the finder reads the buffer so it stops first
+                    clearSearch();
+                    document_t * document = &program.documents[program.active];
+                    document->file = program.file;
+                    document->owned_file = program.owned_file;
+                    document->text = program.text;
+                    document->data = program.data;
+                    document->data_size = program.data_size;
+                    document->mapped = program.mapped;
+                    document->map_size = program.map_size;
+                    document->data_fd = program.data_fd;
+                    document->disk = program.disk;
+                    document->modified = program.modified;
+                    document->patched = program.patched;
+                    document->packed = program.packed;
+                    document->lost = program.lost;
+                    document->unpack = program.unpack;
+                    document->history = program.history;
+                    document->syntax = program.syntax;
+                    document->cursx = program.cursx;
+                    document->cursy = program.cursy;
+                    document->scrollx = program.scrollx;
+                    document->scrolly = program.scrolly;
+                    document->used = program.switches;
+                    resetFile();
+                }
+            /*////////////////////////////
+                Load file
+                    shows a parked document, rebuilding it when it was evicted
+            */////////////////////////////
+                static void loadFile(u_int64_t index){
+                    document_t * document = &program.documents[index];
+                    program.active = index;
+                    program.file = document->file;
+                    program.owned_file = document->owned_file;
+                    program.text = document->text;
+                    program.data = document->data;
+                    program.data_size = document->data_size;
+                    program.mapped = document->mapped;
+                    program.map_size = document->map_size;
+                    program.data_fd = document->data_fd;
+                    program.disk = document->disk;
+                    program.modified = document->modified;
+                    program.patched = document->patched;
+                    program.packed = document->packed;
+                    program.lost = document->lost;
+                    program.unpack = document->unpack;
+                    program.history = document->history;
+                    program.syntax = document->syntax;
+                    program.cursx = document->cursx;
+                    program.cursy = document->cursy;
+                    program.scrollx = document->scrollx;
+                    program.scrolly = document->scrolly;
+                    program.switches++;
+                    //evicted files kept only their mapping, which is not indexed
+                    //again when the file was cut short while parked
+                    if (NULL == program.text){
+                        program.text = calloc(1, sizeof(buffer_t));
+                        if (NULL == program.text){
+                            die("loadFile - calloc");
+                        }
+                        if ((!program.lost) && (!mappingShrunk())){
+                            madvise(program.data, program.data_size, program.view ? MADV_SEQUENTIAL : MADV_SEQUENTIAL | MADV_WILLNEED);
+                            if (0 != openText()){
+                                die("loadFile - bufferOpen");
+                            }
+                            historyInit(&program.history, program.undo_limit);
+                            if (!program.view){
+                                syntaxOpen(&program.syntax, program.file);
+                            }
+                        }
+                    }
+                    program.indexed_lines = bufferLineCount(program.text);
+                    watchIndexing();
+                    watchUnpacking();
+                    program.painted.valid = 0;
+                    //a file cut short while parked is read again before a paint
+                    //reads the pages it lost, as one cut short while shown is
+                    checkShrunk();
+                    watchFile();
+                }
+            /*////////////////////////////
+                Switch file
+                    shows an open file in place of the current one
+            */////////////////////////////
+                static void switchFile(u_int64_t index){
+                    if ((NULL != program.file) && (index == program.active)){
+                        return;
+                    }
+                    storeFile();
+                    loadFile(index);
+                    trimFiles();
+                }
+            /*////////////////////////////
+                Close document
+                    closes the shown file and shows the one seen most recently
+                    before it, or the file select pane when none are left
+            */////////////////////////////
+                static void closeDocument(){
+                    closeFile();
+                    if (0 == program.document_count){
+                        openBrowser();
+                        return;
+                    }
+                    u_int64_t recent = 0;
+                    for (u_int64_t iter = 1; iter < program.document_count; iter++){
+                        if (program.documents[iter].used > program.documents[recent].used){
+                            recent = iter;
+                        }
+                    }
+                    loadFile(recent);
+                }
+            /*////////////////////////////
+                Trim files
+                    evicts the least recently shown files until the open files
+                    fit the memory budget
+                    only unedited mapped files are evicted, they keep their
+                    mapping and cursor and rebuild the rest when shown again
+            */////////////////////////////
+                static void trimFiles(){
+                    u_int64_t total = program.mapped ? 0 : program.data_size;
+                    if (NULL != program.text){
+                        total += bufferMemory(program.text) + historyMemory(&program.history) + syntaxMemory(&program.syntax);
+                    }
+                    for (u_int64_t iter = 0; iter < program.document_count; iter++){
+                        if ((iter != program.active) || (NULL == program.file)){
+                            total += fileMemory(&program.documents[iter]);
+                        }
+                    }
+                    while (total > program.memory_budget){
+                        document_t * oldest = NULL;
+                        for (u_int64_t iter = 0; iter < program.document_count; iter++){
+                            document_t * document = &program.documents[iter];
+                            if (((iter == program.active) && (NULL != program.file)) || (NULL == document->text) || (!document->mapped)){
+                                continue;
+                            }
+                            if ((0 != document->history.count) || (0 != document->history.block_count) || (document->patched)){
+                                continue;
+                            }
+                            if ((NULL == oldest) || (document->used < oldest->used)){
+                                oldest = document;
+                            }
+                        }
+                        if (NULL == oldest){
+                            return;
+                        }
+                        total -= fileMemory(oldest);
+                        bufferClose(oldest->text);
+                        free(oldest->text);
+                        historyRelease(&oldest->history);
+                        syntaxRelease(&oldest->syntax);
+                        madvise(oldest->data, oldest->data_size, MADV_DONTNEED);
+                    }
+                }
+            /*////////////////////////////
+                File memory
+                    returns the heap bytes a parked document holds
+            */////////////////////////////
+                static u_int64_t fileMemory(document_t * document){
+                    u_int64_t memory = document->mapped ? 0 : document->data_size;
+                    if (NULL != document->text){
+                        memory += bufferMemory(document->text) + historyMemory(&document->history) + syntaxMemory(&document->syntax);
+                    }
+                    return memory;
+                }
+            /*////////////////////////////
+                Reset file
+                    clears the fields of the shown file
+            */////////////////////////////
+                static void resetFile(){
+                    program.file = NULL;
+                    program.owned_file = NULL;
+                    program.text = NULL;
+                    program.data = NULL;
+                    program.data_size = 0;
+                    program.mapped = 0;
+                    program.map_size = 0;
+                    program.data_fd = -1;
+                    memset(&program.disk, 0, sizeof(stat_t));
+                    program.modified = 0;
+                    program.patched = 0;
+                    program.packed = 0;
+                    program.lost = 0;
+                    program.holding = 0;
+                    program.unpack = NULL;
+                    historyInit(&program.history, program.undo_limit);
+                    memset(&program.syntax, 0, sizeof(syntax_t));
+                    columnsTruncate(&program.columns, 0);
+                    program.cursx = 0;
+                    program.cursy = 0;
+                    program.scrolly = DEFAULT_SCROLL;
+                    program.scrollx = 0;
+                    program.margin_top = 1;
+                    program.painted.valid = 0;
+                }
+            /*////////////////////////////
+                Get file contents
+                    maps the file (or streams it for pipes and special files)
+                    and builds the line index in one pass
+            */////////////////////////////
+                static void getFileContents(){
+                    if (NULL == program.file){
+                        return;
+                    }
+                    //open file
+                    int file_desc = open(program.file, O_RDONLY);
+                    if (-1 == file_desc){
+                        return;
+                    }
+                    if (0 != fstat(file_desc, &program.disk)){
+                        memset(&program.disk, 0, sizeof(stat_t));
+                    }
+                    program.modified = 0;
+                    program.patched = 0;
+                    //compressed files are shown as their text arrives, regular
+                    //files are mapped, anything else is streamed
+                    if (0 == unpackFileContents(file_desc)){
+                        close(file_desc);
+                    }else{
+                        if (0 != mapFileContents(file_desc)){
+                            if (0 != readFileContents(file_desc)){
+                                die("getFileContents - read");
+                            }
+                        }
+                        //mapped files stay open so saves can copy from them
+                        if (program.mapped){
+                            program.data_fd = file_desc;
+                        }else{
+                            close(file_desc);
+                        }
+                    }
+                    if (0 != openText()){
+                        die("getFileContents - bufferOpen");
+                    }
+                    historyInit(&program.history, program.undo_limit);
+                    //the lexer keeps a state per line, which a view cannot afford
+                    if (!program.view){
+                        syntaxOpen(&program.syntax, program.file);
+                    }
+                    //large files keep indexing while the first screen is shown
+                    program.indexed_lines = bufferLineCount(program.text);
+                    watchIndexing();
+                    watchUnpacking();
+                    watchFile();
+                }
+            /*////////////////////////////
+                Open text
+                    builds the shown file's buffer over its data, with a sparse
+                    line index when viewing
+                    returns 0 on success
+            */////////////////////////////
+                static int openText(){
+                    if (program.view){
+                        return bufferOpenView(program.text, program.data, program.data_size, program.jobs, VIEW_INDEX_BUDGET);
+                    }
+                    return bufferOpen(program.text, program.data, program.data_size, program.jobs);
+                }
+            /*////////////////////////////
+                Map file contents
+                    returns 0 when the file could be mapped
+            */////////////////////////////
+                static int mapFileContents(int file_desc){
+                    stat_t file_stat;
+                    if ((0 != fstat(file_desc, &file_stat)) || (!S_ISREG(file_stat.st_mode)) || ((0 >= file_stat.st_size) && (!program.follow))){
+                        return -1;
+                    }
+                    //a followed file is mapped with room to grow into, pages
+                    //past its end are only touched once it has grown over them
+                    u_int64_t map_size = file_stat.st_size + (program.follow ? FOLLOW_WINDOW : 0);
+                    void * data = mmap(NULL, map_size, PROT_READ, MAP_PRIVATE, file_desc, 0);
+                    if (MAP_FAILED == data){
+                        return -1;
+                    }
+                    //a view of a file larger than memory must not read it all ahead
+                    madvise(data, file_stat.st_size, program.view ? MADV_SEQUENTIAL : MADV_SEQUENTIAL | MADV_WILLNEED);
+                    program.data = data;
+                    program.data_size = file_stat.st_size;
+                    program.map_size = map_size;
+                    program.mapped = 1;
+                    return 0;
+                }
+            /*////////////////////////////
+                Unpack file contents
+                    decompresses the start of a gzip file into a temporary
+                    file mapped with room for the rest, which a timer adds
+                    until the unpack limit or the space in TMPDIR runs out
+                    returns 0 when the file was compressed
+            */////////////////////////////
+                static int unpackFileContents(int file_desc){
+                    unpack_t * unpack = malloc(sizeof(unpack_t));
+                    if (NULL == unpack){
+                        return -1;
+                    }
+                    if (0 != unpackOpen(unpack, file_desc, program.unpack_limit)){
+                        free(unpack);
+                        return -1;
+                    }
+                    //corrupt from the start is shown as it is
+                    void * data = mmap(NULL, UNPACK_WINDOW, PROT_READ, MAP_SHARED, unpack->output_fd, 0);
+                    if ((MAP_FAILED == data) || ((0 > unpackStep(unpack, UNPACK_FIRST)) && (!unpack->limited))){
+                        if (MAP_FAILED != data){
+                            munmap(data, UNPACK_WINDOW);
+                        }
+                        close(unpack->output_fd);
+                        unpackClose(unpack);
+                        free(unpack);
+                        return -1;
+                    }
+                    program.data = data;
+                    program.data_size = unpack->produced;
+                    program.map_size = UNPACK_WINDOW;
+                    program.mapped = 1;
+                    program.data_fd = unpack->output_fd;
+                    program.packed = 1;
+                    program.unpack = unpack;
+                    if (unpack->limited){
+                        program.notice = "unpack limit reached";
+                    }
+                    return 0;
+                }
+            /*////////////////////////////
+                Poll unpacking
+                    decompresses the next part of the shown file and appends
+                    it, once the tree is free of the finder and indexer
+                    returns nonzero once the whole file is shown
+            */////////////////////////////
+                static int pollUnpacking(){
+                    if ((NULL == program.file) || (NULL == program.unpack)){
+                        program.unpack_polling = 0;
+                        return 1;
+                    }
+                    unpack_t * unpack = program.unpack;
+                    //text the finder or indexer holds back from the buffer is not inflated further until they let go
+                    if ((unpack->produced > program.data_size) && ((finderRunning(&program.finder)) || (1 == bufferIndexing(program.text)))){
+                        paceTimer(pollUnpacking, UNPACK_WAIT_INTERVAL);
+                        return 0;
+                    }
+                    paceTimer(pollUnpacking, UNPACK_INTERVAL);
+                    if ((!unpack->done) && (0 > unpackStep(unpack, UNPACK_STEP))){
+                        program.notice = unpack->limited ? "unpack limit reached" : "unpack failed";
+                    }
+                    if (unpack->produced > program.data_size){
+                        growFile(unpack->produced);
+                    }
+                    markDirtyBanner();
+                    if ((unpack->done) && (program.data_size == unpack->produced)){
+                        unpackClose(unpack);
+                        free(program.unpack);
+                        //neither the banner, a switch nor a close may reach it again
+                        program.unpack = NULL;
+                        program.documents[program.active].unpack = NULL;
+                        program.unpack_polling = 0;
+                        return 1;
+                    }
+                    return 0;
+                }
+            /*////////////////////////////
+                Watch unpacking
+                    keeps decompressing the shown file while part is left
+            */////////////////////////////
+                static void watchUnpacking(){
+                    if ((!program.unpack_polling) && (NULL != program.unpack)){
+                        program.unpack_polling = (0 == addTimer(UNPACK_INTERVAL, pollUnpacking));
+                    }
+                }
+            /*////////////////////////////
+                Read file contents
+                    streaming fallback for pipes and special files
+                    returns 0 on success
+            */////////////////////////////
+                static int readFileContents(int file_desc){
+                    u_int64_t capacity = READ_CHUNK_SIZE;
+                    program.data = malloc(capacity);
+                    if (NULL == program.data){
+                        die("readFileContents - malloc");
+                    }
+                    program.data_size = 0;
+                    program.mapped = 0;
+                    for(;;){
+                        //grow geometrically so reads stay amortized
+                        if (capacity - program.data_size < READ_CHUNK_SIZE){
+                            capacity = growCapacity(capacity, program.data_size + READ_CHUNK_SIZE, READ_CHUNK_SIZE);
+                            program.data = realloc(program.data, capacity);
+                            if (NULL == program.data){
+                                die("readFileContents - realloc");
+                            }
+                        }
+                        ssize_t read_size = read(file_desc, program.data + program.data_size, READ_CHUNK_SIZE);
+                        if (0 == read_size){
+                            break;
+                        }
+                        if (0 > read_size){
+                            if (EINTR == errno){
+                                continue;
+                            }
+                            return -1;
+                        }
+                        program.data_size += read_size;
+                    }
+                    return 0;
+                }
+            /*////////////////////////////
+                Poll indexing
+                    refreshes the banner progress and the rows of newly found lines
+                    returns nonzero once indexing is over to cancel its timer
+            */////////////////////////////
+                static int pollIndexing(){
+                    if (NULL == program.file){
+                        program.index_polling = 0;
+                        return 1;
+                    }
+                    int indexing = bufferIndexing(program.text);
+                    if (-1 == indexing){
+                        die("pollIndexing - index");
+                    }
+                    markDirtyFrom(program.indexed_lines - 1);
+                    markDirtyBanner();
+                    program.indexed_lines = bufferLineCount(program.text);
+                    //a view lets go of pages the indexer is done with, the
+                    //rows on screen fault back in when painted
+                    if (program.view && program.mapped){
+                        u_int64_t page = sysconf(_SC_PAGESIZE);
+                        madvise(program.data, bufferIndexedBytes(program.text) / page * page, MADV_DONTNEED);
+                    }
+                    program.index_polling = indexing;
+                    return !indexing;
+                }
+            /*////////////////////////////
+                Watch indexing
+                    polls the shown file's progress while it is being indexed
+            */////////////////////////////
+                static void watchIndexing(){
+                    if ((!program.index_polling) && (1 == bufferIndexing(program.text))){
+                        program.index_polling = (0 == addTimer(INDEX_POLL_INTERVAL, pollIndexing));
+                    }
+                }
+            /*////////////////////////////
+                Watch file
+                    watches the shown file for changes on disk, checking once
+                    for those made while it was parked
+            */////////////////////////////
+                static void watchFile(){
+                    unwatchFile();
+                    //a compressed file is not patched from its new bytes
+                    if ((NULL == program.file) || (-1 == program.watch_fd) || (!S_ISREG(program.disk.st_mode)) || (program.packed)){
+                        return;
+                    }
+                    program.watch = inotify_add_watch(program.watch_fd, program.file, IN_MODIFY | IN_ATTRIB | IN_MOVE_SELF | IN_DELETE_SELF);
+                    if (-1 != program.watch){
+                        scheduleCheck();
+                    }
+                }
+            /*////////////////////////////
+                Unwatch file
+                    stops watching the shown file
+            */////////////////////////////
+                static void unwatchFile(){
+                    if (-1 != program.watch){
+                        inotify_rm_watch(program.watch_fd, program.watch);
+                        program.watch = -1;
+                    }
+                }
+            /*////////////////////////////
+                Schedule check
+                    compares the shown file with the disk after a short wait,
+                    so a burst of writes costs one check
+            */////////////////////////////
+                static void scheduleCheck(){
+                    if (!program.disk_pending){
+                        program.disk_pending = (0 == addTimer(WATCH_INTERVAL, checkDisk));
+                    }
+                }
+            /*////////////////////////////
+                Check disk
+                    compares the shown file with what is on disk by identity,
+                    size and modification time, appending what a followed file
+                    grew by, patching in what changed in a replaced file and
+                    reloading one rewritten in place, whose mapping already
+                    shows the new bytes, edits are never thrown away
+                    one rewritten shorter, as cmd > file does, is reloaded by
+                    checkShrunk as soon as it is noticed instead
+                    returns nonzero once nothing is left to do to cancel its timer
+            */////////////////////////////
+                static int checkDisk(){
+                    if ((NULL == program.file) || (NULL == program.text)){
+                        program.disk_pending = 0;
+                        return 1;
+                    }
+                    stat_t disk;
+                    if (0 != stat(program.file, &disk)){
+                        //a followed file rotated away comes back
+                        if (program.follow){
+                            return 0;
+                        }
+                        program.disk_pending = 0;
+                        return 1;
+                    }
+                    if ((disk.st_ino == program.disk.st_ino) && (disk.st_dev == program.disk.st_dev) && (disk.st_size == program.disk.st_size)
+                        && (disk.st_mtim.tv_sec == program.disk.st_mtim.tv_sec) && (disk.st_mtim.tv_nsec == program.disk.st_mtim.tv_nsec)){
+                        program.disk_pending = 0;
+                        return 1;
+                    }
+                    stat_t open;
+                    u_int8_t aliased = (program.mapped) && (0 == fstat(program.data_fd, &open)) && (disk.st_ino == open.st_ino) && (disk.st_dev == open.st_dev);
+                    u_int64_t size = disk.st_size;
+                    //a file cut short and grown back has lost pages, which only a reload brings back
+                    if ((aliased) && (program.follow) && (!program.lost) && (size >= program.data_size) && (size <= program.map_size)){
+                        //the finder and indexer read the tree being appended to
+                        if ((size > program.data_size) && (finderRunning(&program.finder) || (1 == bufferIndexing(program.text)))){
+                            return 0;
+                        }
+                        program.disk_pending = 0;
+                        if (size > program.data_size){
+                            growFile(size);
+                        }
+                        program.disk = disk;
+                        return 1;
+                    }
+                    //what follows reads the file again, which may change once more
+                    program.disk_pending = 0;
+                    if (program.modified){
+                        program.disk = disk;
+                        program.notice = "changed on disk";
+                        markDirtyBanner();
+                        watchFile();
+                    }else if ((aliased) || (program.follow) || (program.view)){
+                        reloadFile();
+                    }else{
+                        refreshFile();
+                    }
+                    return 1;
+                }
+            /*////////////////////////////
+                Mapping shrunk
+                    returns nonzero when the shown file is now shorter than
+                    the data mapped from it, whose pages past the new end
+                    fault when read
+            */////////////////////////////
+                static int mappingShrunk(){
+                    stat_t open;
+                    if ((NULL == program.file) || (!program.mapped) || (program.packed) || (-1 == program.data_fd) || (0 != fstat(program.data_fd, &open))){
+                        return 0;
+                    }
+                    return (u_int64_t)open.st_size < program.data_size;
+                }
+            /*////////////////////////////
+                Check shrunk
+                    reads the shown file again at once when it was cut short
+                    under its mapping or lost pages to a read past its end,
+                    before a paint reads the pages it lost,
+                    the finder and indexer are stopped by the reload first,
+                    an edited file keeps its edits and is only flagged
+            */////////////////////////////
+                static void checkShrunk(){
+                    if ((!program.lost) && (!mappingShrunk())){
+                        return;
+                    }
+                    if (program.modified){
+                        program.notice = "changed on disk";
+                        markDirtyBanner();
+                        return;
+                    }
+                    reloadFile();
+                }
+            /*////////////////////////////
+                Grow file
+                    appends what was written to the shown file, scrolling
+                    along when the cursor was on the last line
+            */////////////////////////////
+                static void growFile(u_int64_t size){
+                    u_int64_t last = getLineCount() - 1;
+                    u_int64_t from = bufferLineLength(program.text, last);
+                    u_int8_t at_end = (program.cursy == last);
+                    int status = bufferGrow(program.text, size);
+                    if (0 > status){
+                        die("growFile - bufferGrow");
+                    }
+                    if (0 < status){
+                        return;
+                    }
+                    program.data_size = size;
+                    markEdited(last, from, 0, getLineCount() - 1 - last);
+                    program.indexed_lines = bufferLineCount(program.text);
+                    if (at_end){
+                        moveFileEnd();
+                    }
+                }
+            /*////////////////////////////
+                Refresh file
+                    patches the changes between the shown file and its new
+                    contents on disk into the buffer, so only changed lines
+                    are indexed, lexed and painted and the cursor and scroll
+                    keep their place in the text around them, each change can
+                    be undone, a file mostly rewritten is reloaded instead
+            */////////////////////////////
+                static void refreshFile(){
+                    int file_desc = open(program.file, O_RDONLY);
+                    if (-1 == file_desc){
+                        return;
+                    }
+                    stat_t disk;
+                    char * data = NULL;
+                    if ((0 != fstat(file_desc, &disk)) || (!S_ISREG(disk.st_mode))){
+                        close(file_desc);
+                        return;
+                    }
+                    u_int64_t size = disk.st_size;
+                    if (0 < size){
+                        data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, file_desc, 0);
+                        if (MAP_FAILED == data){
+                            close(file_desc);
+                            reloadFile();
+                            return;
+                        }
+                        madvise(data, size, MADV_SEQUENTIAL | MADV_WILLNEED);
+                    }
+                    close(file_desc);
+                    //the finder reads the buffer being patched
+                    clearSearch();
+                    delta_t delta;
+                    deltaInit(&delta);
+                    int status = deltaCompute(&delta, program.text, data, size, REFRESH_LIMIT);
+                    if (0 > status){
+                        die("refreshFile - deltaCompute");
+                    }
+                    u_int64_t replaced = 0;
+                    for (u_int64_t iter = 0; iter < delta.count; iter++){
+                        replaced += delta.hunks[iter].new_length;
+                    }
+                    //new bytes are copied into the buffer while a reload maps them
+                    if ((0 != status) || (2 * replaced > size)){
+                        deltaRelease(&delta);
+                        if (NULL != data){
+                            munmap(data, size);
+                        }
+                        reloadFile();
+                        return;
+                    }
+                    //last first, so the offsets of those before stay put, each
+                    //hunk is one undo step that brings back what was on screen
+                    for (u_int64_t iter = delta.count; iter-- > 0;){
+                        hunk_t * hunk = &delta.hunks[iter];
+                        u_int64_t line = bufferLineOfOffset(program.text, hunk->old_offset);
+                        u_int64_t from = hunk->old_offset - bufferLineStart(program.text, line);
+                        u_int64_t removed = bufferLineOfOffset(program.text, hunk->old_offset + hunk->old_length) - line;
+                        u_int64_t added = countNewlines(data + hunk->new_offset, hunk->new_length);
+                        historyBreak(&program.history);
+                        if ((0 != historyDelete(&program.history, program.text, hunk->old_offset, hunk->old_length))
+                            || (0 != historyInsert(&program.history, program.text, hunk->old_offset, data + hunk->new_offset, hunk->new_length))){
+                            die("refreshFile - patch");
+                        }
+                        markEdited(line, from, removed, added);
+                        program.cursy = remapLine(program.cursy, line, removed, added);
+                        program.scrolly = remapLine(program.scrolly, line, removed, added);
+                    }
+                    if (0 != delta.count){
+                        program.patched = 1;
+                    }
+                    deltaRelease(&delta);
+                    if (NULL != data){
+                        munmap(data, size);
+                    }
+                    historyBreak(&program.history);
+                    program.indexed_lines = bufferLineCount(program.text);
+                    program.disk = disk;
+                    program.notice = "reloaded";
+                    markDirtyBanner();
+                    followCursor();
+                    placeCursor();
+                    //a replaced file is a new inode to watch
+                    watchFile();
+                }
+            /*////////////////////////////
+                Remap line
+                    returns where target went once the removed lines after
+                    line became added lines, lines inside the change keep
+                    their distance from line while it lasts
+            */////////////////////////////
+                static u_int64_t remapLine(u_int64_t target, u_int64_t line, u_int64_t removed, u_int64_t added){
+                    if (target <= line){
+                        return target;
+                    }
+                    if (target > line + removed){
+                        return target + added - removed;
+                    }
+                    return (target - line < added) ? target : line + added;
+                }
+            /*////////////////////////////
+                Count newlines
+            */////////////////////////////
+                static u_int64_t countNewlines(const char * text, u_int64_t length){
+                    u_int64_t count = 0;
+                    for (const char * newline = memchr(text, '\n', length); NULL != newline; newline = memchr(newline + 1, '\n', text + length - newline - 1)){
+                        count++;
+                    }
+                    return count;
+                }
+            /*////////////////////////////
+                Get line length
+                    returns the length of a specific line without its newline
+            */////////////////////////////
+                static int64_t getLineLength(u_int64_t line){
+                    if (NULL == program.file){
+                        return -1;
+                    }
+                    if (line >= getLineCount()){
+                        return -1;
+                    }
+                    return bufferLineLength(program.text, line);
+                }
+            /*////////////////////////////
+                Get line count
+                    returns the number of lines in the current file
+            */////////////////////////////
+                static u_int64_t getLineCount(){
+                    if (NULL == program.file){
+                        return 0;
+                    }
+                    return bufferLineCount(program.text);
+                }
+            /*////////////////////////////
+                Get cursor offset
+                    returns the document offset under the cursor
+            */////////////////////////////
+                static u_int64_t getCursorOffset(){
+                    u_int64_t length = getLineLength(program.cursy);
+                    u_int64_t column = program.cursx > length ? length : program.cursx;
+                    return bufferLineStart(program.text, program.cursy) + column;
+                }
+            /*////////////////////////////
+                Save file
+                    replaces the file on disk with the buffer, the mapping and
+                    its descriptor keep the old contents the pieces refer to
+            */////////////////////////////
+                static void saveFile(){
+                    if (readOnly()){
+                        return;
+                    }
+                    if (0 == saveBuffer(program.text, program.file, program.data_fd, program.sync)){
+                        program.notice = "saved";
+                        //the save replaced the file, its own change is not reloaded
+                        if (0 == stat(program.file, &program.disk)){
+                            program.modified = 0;
+                        }
+                        watchFile();
+                    }else{
+                        program.notice = "save failed";
+                    }
+                    markDirtyBanner();
+                }
+        /*////////////////////////////
+            Cursor Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Move to beginning of line
+            */////////////////////////////
+                static void moveBegin(){
+                    program.cursx = 0;
+                    followCursor();
+                    placeCursor();
+                }
+            /*////////////////////////////
+                Move to end of line
+            */////////////////////////////
+                static void moveEOL(){
+                    int64_t length = getLineLength(program.cursy);
+                    if (0 > length){
+                        return;
+                    }
+                    program.cursx = length;
+                    followCursor();
+                    placeCursor();
+                }
+            /*////////////////////////////
+                Move cursor left
+                    wraps to the end of the previous line
+            */////////////////////////////
+                static void moveLeft(){
+                    moveChars(-1);
+                }
+            /*////////////////////////////
+                Move cursor right
+                    wraps to the start of the next line
+            */////////////////////////////
+                static void moveRight(){
+                    moveChars(1);
+                }
+            /*////////////////////////////
+                Move cursor down
+            */////////////////////////////
+                static void moveDown(){
+                    moveLines(1);
+                }
+            /*////////////////////////////
+                Move cursor up
+            */////////////////////////////
+                static void moveUp(){
+                    moveLines(-1);
+                }
+            /*////////////////////////////
+                Move page
+                    scrolls a screen at a time, the cursor keeps its row
+            */////////////////////////////
+                static void movePage(int64_t pages){
+                    u_int64_t rows = LINES - program.margin_top;
+                    u_int64_t last = getLineCount() - 1;
+                    u_int64_t distance = (0 > pages) ? -pages * rows : pages * rows;
+                    u_int64_t row = program.cursy - program.scrolly;
+                    u_int64_t column = getCursorColumn();
+                    if (0 > pages){
+                        program.scrolly = (program.scrolly > distance) ? program.scrolly - distance : 0;
+                    }else{
+                        program.scrolly = (last - program.scrolly > distance) ? program.scrolly + distance : last;
+                    }
+                    program.cursy = (last - program.scrolly > row) ? program.scrolly + row : last;
+                    setCursorColumn(column);
+                    followCursor();
+                    placeCursor();
+                }
+            /*////////////////////////////
+                Move to line
+                    jumps straight to a line, clamped to the file
+            */////////////////////////////
+                static void moveToLine(u_int64_t line){
+                    //past the indexed point only the chunk holding line is waited on
+                    bufferLineStart(program.text, line);
+                    u_int64_t last = getLineCount() - 1;
+                    program.cursy = (line > last) ? last : line;
+                    program.cursx = 0;
+                    followCursor();
+                    placeCursor();
+                }
+            /*////////////////////////////
+                Move to offset
+                    places the cursor on a document offset
+            */////////////////////////////
+                static void moveToOffset(u_int64_t offset){
+                    program.cursy = bufferLineOfOffset(program.text, offset);
+                    program.cursx = offset - bufferLineStart(program.text, program.cursy);
+                    followCursor();
+                    placeCursor();
+                }
+            /*////////////////////////////
+                Move to start of file
+            */////////////////////////////
+                static void moveFileStart(){
+                    moveToLine(0);
+                }
+            /*////////////////////////////
+                Move to end of file
+            */////////////////////////////
+                static void moveFileEnd(){
+                    if (0 != bufferFinishIndex(program.text)){
+                        die("moveFileEnd - index");
+                    }
+                    moveToLine(getLineCount() - 1);
+                    moveEOL();
+                }
+            /*////////////////////////////
+                Move lines
+                    moves the cursor count lines in one step, negative moves
+                    up, keeping the column it is drawn at
+            */////////////////////////////
+                static void moveLines(int64_t count){
+                    u_int64_t last = getLineCount() - 1;
+                    u_int64_t column = getCursorColumn();
+                    if ((0 > count) && ((u_int64_t)-count > program.cursy)){
+                        program.cursy = 0;
+                    }else if ((0 < count) && ((u_int64_t)count > last - program.cursy)){
+                        program.cursy = last;
+                    }else{
+                        program.cursy += count;
+                    }
+                    setCursorColumn(column);
+                    followCursor();
+                    placeCursor();
+                }
+            /*////////////////////////////
+                Move characters
+                    moves the cursor count characters in one step, wrapping
+                    across lines, a character being every byte it takes and
+                    the marks drawn over it
+            */////////////////////////////
+                static void moveChars(int64_t count){
+                    u_int64_t offset = getCursorOffset();
+                    for (; (0 > count) && (0 < offset); count++){
+                        offset = columnsPrevious(&program.columns, program.text, offset);
+                    }
+                    for (; 0 < count; count--){
+                        u_int64_t next = columnsNext(&program.columns, program.text, offset);
+                        if (next == offset){
+                            break;
+                        }
+                        offset = next;
+                    }
+                    moveToOffset(offset);
+                }
+            /*////////////////////////////
+                Get cursor column
+                    returns the column the cursor is drawn at, the bytes it
+                    was left past the end of a shorter line counting as a
+                    column each
+            */////////////////////////////
+                static u_int64_t getCursorColumn(){
+                    int64_t length = getLineLength(program.cursy);
+                    if (0 > length){
+                        return program.cursx;
+                    }
+                    if (program.cursx > (u_int64_t)length){
+                        return columnsOfOffset(&program.columns, program.text, program.cursy, length) + program.cursx - length;
+                    }
+                    return columnsOfOffset(&program.columns, program.text, program.cursy, program.cursx);
+                }
+            /*////////////////////////////
+                Set cursor column
+                    puts the cursor on the character of its line drawn over
+                    column, remembering how far past the end of a shorter
+                    line it was
+            */////////////////////////////
+                static void setCursorColumn(u_int64_t column){
+                    int64_t length = getLineLength(program.cursy);
+                    if (0 > length){
+                        program.cursx = column;
+                        return;
+                    }
+                    u_int64_t begin = 0;
+                    u_int64_t offset = columnsOffsetOf(&program.columns, program.text, program.cursy, column, &begin);
+                    program.cursx = ((u_int64_t)length == offset) ? offset + column - begin : offset;
+                }
+            /*////////////////////////////
+                Follow cursor
+                    clamps the scroll so the cursor stays inside the scroll buffers
+            */////////////////////////////
+                static void followCursor(){
+                    u_int64_t rows = LINES - program.margin_top;
+                    u_int64_t bottom = (rows > SCROLLY_BUFFER) ? rows - SCROLLY_BUFFER : 0;
+                    u_int64_t top = (bottom > SCROLLY_BUFFER) ? SCROLLY_BUFFER : 0;
+                    //vertical
+                    if (program.cursy > program.scrolly + bottom){
+                        program.scrolly = program.cursy - bottom;
+                    }else if (program.cursy < program.scrolly + top){
+                        program.scrolly = (program.cursy > top) ? program.cursy - top : 0;
+                    }
+                    //horizontal, the column past the end of line must stay reachable
+                    int64_t length = getLineLength(program.cursy);
+                    if (0 > length){
+                        return;
+                    }
+                    u_int64_t offset = (program.cursx > (u_int64_t)length) ? (u_int64_t)length : program.cursx;
+                    u_int64_t column = columnsOfOffset(&program.columns, program.text, program.cursy, offset);
+                    u_int64_t width = COLS;
+                    u_int64_t right = (width > SCROLLX_BUFFER) ? width - SCROLLX_BUFFER : 0;
+                    u_int64_t left = (right > SCROLLX_BUFFER) ? SCROLLX_BUFFER : 0;
+                    //the line's end is only measured when it is within a screen, every byte taking a cell at least
+                    u_int64_t limit = column;
+                    if ((u_int64_t)length - offset < width){
+                        u_int64_t line_width = columnsOfOffset(&program.columns, program.text, program.cursy, length);
+                        limit = (line_width + 1 > width) ? line_width + 1 - width : 0;
+                    }
+                    if (column > program.scrollx + right){
+                        program.scrollx = column - right;
+                        if (program.scrollx > limit){
+                            program.scrollx = limit;
+                        }
+                    }else if (column < program.scrollx + left){
+                        program.scrollx = (column > left) ? column - left : 0;
+                    }
+                    if (column < program.scrollx){
+                        program.scrollx = column;
+                    }
+                }
+            /*////////////////////////////
+                Place cursor
+                    moves the terminal cursor to the logical cursor
+            */////////////////////////////
+                static void placeCursor(){
+                    if (program.prompt.active){
+                        move(0, strlen(program.prompt.label) + program.prompt.length);
+                        return;
+                    }
+                    int64_t length = getLineLength(program.cursy);
+                    u_int64_t offset = ((0 <= length) && (program.cursx > (u_int64_t)length)) ? (u_int64_t)length : program.cursx;
+                    u_int64_t column = (0 <= length) ? columnsOfOffset(&program.columns, program.text, program.cursy, offset) : offset;
+                    u_int64_t col = (STATE_FILE_SELECT == program.state) ? FILE_BROWSER_WIDTH : 0;
+                    move(program.cursy - program.scrolly + program.margin_top, column - program.scrollx + col);
+                }
+        /*////////////////////////////
+            Edit Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Insert character
+                    inserts a character at the cursor and steps past it
+            */////////////////////////////
+                static void insertChar(char input){
+                    insertText(&input, 1);
+                }
+            /*////////////////////////////
+                Insert text
+                    inserts a run of text at the cursor in one edit and steps past it
+            */////////////////////////////
+                static void insertText(const char * text, u_int64_t length){
+                    if (readOnly()){
+                        return;
+                    }
+                    u_int64_t offset = getCursorOffset();
+                    program.cursx = offset - bufferLineStart(program.text, program.cursy);
+                    //results would point at stale offsets
+                    if (program.search.regex){
+                        clearSearch();
+                    }
+                    if (0 != historyInsert(&program.history, program.text, offset, text, length)){
+                        die("insertText - historyInsert");
+                    }
+                    program.modified = 1;
+                    markEdited(program.cursy, program.cursx, 0, countNewlines(text, length));
+                    moveToOffset(offset + length);
+                }
+            /*////////////////////////////
+                Insert newline
+                    splits the line at the cursor
+            */////////////////////////////
+                static void insertNewline(){
+                    insertChar('\n');
+                }
+            /*////////////////////////////
+                Delete backward
+                    removes the character before the cursor, joining lines at column 0
+            */////////////////////////////
+                static void deleteBackward(){
+                    if (readOnly()){
+                        return;
+                    }
+                    if (0 == getCursorOffset()){
+                        return;
+                    }
+                    moveLeft();
+                    deleteForward();
+                }
+            /*////////////////////////////
+                Delete forward
+                    removes the character under the cursor with the marks
+                    drawn over it, joining lines at end of line
+            */////////////////////////////
+                static void deleteForward(){
+                    if (readOnly()){
+                        return;
+                    }
+                    u_int64_t offset = getCursorOffset();
+                    char removed = '\0';
+                    if (0 == bufferRead(program.text, offset, &removed, 1)){
+                        return;
+                    }
+                    if (program.search.regex){
+                        clearSearch();
+                    }
+                    u_int64_t next = columnsNext(&program.columns, program.text, offset);
+                    if (0 != historyDelete(&program.history, program.text, offset, next - offset)){
+                        die("deleteForward - historyDelete");
+                    }
+                    program.modified = 1;
+                    markEdited(program.cursy, offset - bufferLineStart(program.text, program.cursy), '\n' == removed, 0);
+                }
+            /*////////////////////////////
+                Read only
+                    refuses edits to files opened as a view or decompressed
+                    returns 1 when the edit must not happen
+            */////////////////////////////
+                static int readOnly(){
+                    if ((!program.view) && (!program.packed)){
+                        return 0;
+                    }
+                    program.notice = "read only";
+                    markDirtyBanner();
+                    return 1;
+                }
+            /*////////////////////////////
+                Mark edited
+                    line, changed from byte from on, and the removed lines
+                    after it became line and added lines, syntax is relexed
+                    through the screen and every row whose colors may have
+                    changed is repainted
+            */////////////////////////////
+                static void markEdited(u_int64_t line, u_int64_t from, u_int64_t removed, u_int64_t added){
+                    columnsEdit(&program.columns, line, from, removed, added);
+                    u_int64_t horizon = program.scrolly + LINES - program.margin_top;
+                    u_int64_t clean = syntaxEdit(&program.syntax, program.text, line, removed, added, horizon);
+                    if ((0 != removed) || (0 != added) || (clean > line + 1)){
+                        markDirtyFrom(line);
+                    }else{
+                        markDirtyLine(line);
+                    }
+                }
+            /*////////////////////////////
+                Undo edit
+                    reverts the last undo step and moves to where it happened
+            */////////////////////////////
+                static void undoEdit(){
+                    if (readOnly()){
+                        return;
+                    }
+                    u_int64_t offset = 0;
+                    u_int64_t first = 0;
+                    if (program.search.regex){
+                        clearSearch();
+                    }
+                    int status = historyUndo(&program.history, program.text, &offset, &first);
+                    if (0 > status){
+                        die("undoEdit - historyUndo");
+                    }
+                    if (0 < status){
+                        program.modified = 1;
+                        syntaxTruncate(&program.syntax, bufferLineOfOffset(program.text, first));
+                        columnsTruncate(&program.columns, bufferLineOfOffset(program.text, first));
+                        markAllDirty();
+                        moveToOffset(offset);
+                    }
+                }
+            /*////////////////////////////
+                Redo edit
+                    reapplies the last undone step
+            */////////////////////////////
+                static void redoEdit(){
+                    if (readOnly()){
+                        return;
+                    }
+                    u_int64_t offset = 0;
+                    u_int64_t first = 0;
+                    if (program.search.regex){
+                        clearSearch();
+                    }
+                    int status = historyRedo(&program.history, program.text, &offset, &first);
+                    if (0 > status){
+                        die("redoEdit - historyRedo");
+                    }
+                    if (0 < status){
+                        program.modified = 1;
+                        syntaxTruncate(&program.syntax, bufferLineOfOffset(program.text, first));
+                        columnsTruncate(&program.columns, bufferLineOfOffset(program.text, first));
+                        markAllDirty();
+                        moveToOffset(offset);
+                    }
+                }
+        /*////////////////////////////
+            Input Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Process Key for editor
+                    gets input and processes it
+            */////////////////////////////
+                static void editorProcessKeypress(keypress_t * keypress){
+                    int64_t input = keypress->key;
+                    MEVENT event = keypress->mouse;
+                    //keybinds that are always valid
+                    switch (input){
+                        case CTRL_KEY('q'):
+                            exit(EXIT_SUCCESS);
+                        break;
+                        default:
+                        break;
+                    }
+                    if (program.prompt.active){
+                        promptKeypress(input);
+                        return;
+                    }
+                    //fuzzy open works from the editor and the file select pane
+                    if (CTRL_KEY('o') == input){
+                        openFuzzy();
+                        return;
+                    }
+                    if ((NULL == program.file) || (STATE_FILE_SELECT == program.state)){
+                        //when no file is open
+                        switch (input){
+                            case KEY_MOUSE:
+                                //left mouse button on down
+                                if(event.bstate & BUTTON1_PRESSED){
+                                    int x = (NULL == program.file) ? 0 : strnlen(program.file, MAX_PATH_SIZE);
+                                    int y = program.margin_top;
+                                    wmouse_trafo(stdscr, &y, &x, FALSE);
+                                    if ((event.y < y) && (event.x < x)){
+                                        program.state = STATE_FILE_EDIT;
+                                        placeCursor();
+                                    }else{
+                                        browserKeypress(input, &event);
+                                    }
+                                }
+                                //middle mouse button on down
+                                else if(event.bstate & BUTTON2_PRESSED){
+                                }
+                                //right mouse button on down
+                                else if(event.bstate & BUTTON3_PRESSED){
+                                }
+                            break;
+                            default:
+                                browserKeypress(input, &event);
+                            break;
+                        }
+                    }
+                    else if ((NULL != program.file) && (STATE_FILE_EDIT == program.state)){
+                        //typing groups into one undo step until anything else happens
+                        u_int8_t typing = isTyped(input) || (KEY_BACKSPACE == input) || (CTRL_KEY('h') == input) || (127 == input) || (KEY_DC == input);
+                        if (!typing){
+                            historyBreak(&program.history);
+                        }
+                        //keybinds specific to open files
+                        switch (input){
+                            case KEY_LEFT:
+                                moveLeft();
+                            break;
+                            case KEY_RIGHT:
+                                moveRight();
+                            break;
+                            case KEY_DOWN:
+                                moveDown();
+                            break;
+                            case KEY_UP:
+                                moveUp();
+                            break;
+                            case KEY_HOME:
+                                moveBegin();
+                            break;
+                            case KEY_END:
+                                moveEOL();
+                            break;
+                            case KEY_PPAGE:
+                                movePage(-1);
+                            break;
+                            case KEY_NPAGE:
+                                movePage(1);
+                            break;
+                            case CTRL_KEY('g'):
+                                openPrompt("Go to line: ", acceptGotoLine, NULL, NULL);
+                            break;
+                            case CTRL_KEY('f'):
+                                openSearch();
+                            break;
+                            case CTRL_KEY('n'):
+                                findNext();
+                            break;
+                            case CTRL_KEY('p'):
+                                findPrevious();
+                            break;
+                            case CTRL_KEY('r'):
+                                openPrompt("Regex: ", acceptRegex, NULL, NULL);
+                            break;
+                            case CTRL_KEY('s'):
+                                saveFile();
+                            break;
+                            case CTRL_KEY('z'):
+                                undoEdit();
+                            break;
+                            case CTRL_KEY('y'):
+                                redoEdit();
+                            break;
+                            case CTRL_KEY('b'):
+                                if (1 < program.document_count){
+                                    switchFile((program.active + 1) % program.document_count);
+                                }
+                            break;
+                            case CTRL_KEY('w'):
+                                closeDocument();
+                            break;
+                            case 27: //escape
+                                clearSearch();
+                            break;
+                            case KEY_ENTER:
+                            case '\r':
+                            case '\n':
+                                insertNewline();
+                            break;
+                            case KEY_BACKSPACE:
+                            case CTRL_KEY('h'):
+                            case 127:
+                                deleteBackward();
+                            break;
+                            case KEY_DC: //delete key
+                                deleteForward();
+                            break;
+                            case KEY_MOUSE:
+                                //left mouse button on down
+                                if(event.bstate & BUTTON1_PRESSED){
+                                    int x = (NULL == program.file) ? 0 : strnlen(program.file, MAX_PATH_SIZE);
+                                    int y = program.margin_top;
+                                    wmouse_trafo(stdscr, &y, &x, FALSE);
+                                    if ((event.y < y) && (event.x < x)){
+                                        openBrowser();
+                                        placeCursor();
+                                    }
+                                }
+                                //middle mouse button on down
+                                else if(event.bstate & BUTTON2_PRESSED){
+                                }
+                                //right mouse button on down
+                                else if(event.bstate & BUTTON3_PRESSED){
+                                }
+                            break;
+                            default:
+                                //extended keys only have codes at runtime
+                                if ((0 <= KEY_CTRL_HOME) && (KEY_CTRL_HOME == input)){
+                                    moveFileStart();
+                                }else if ((0 <= KEY_CTRL_END) && (KEY_CTRL_END == input)){
+                                    moveFileEnd();
+                                //typed characters are inserted
+                                }else if (isTyped(input)){
+                                    insertChar(input);
+                                }
+                            break;
+                        }
+                    }
+                }
+
+            /*////////////////////////////
+                Find extended key
+                    looks up the code ncurses assigned to a named extended key
+                    returns -1 when the terminal does not define it
+            */////////////////////////////
+                static int findExtendedKey(const char * name){
+                    for (int code = KEY_MAX + 1; code < KEY_MAX + MAX_EXTENDED_KEYS; code++){
+                        const char * key = keyname(code);
+                        if ((NULL != key) && (0 == strcmp(key, name))){
+                            return code;
+                        }
+                    }
+                    return -1;
+                }
+            /*////////////////////////////
+                Is typed
+                    returns nonzero for keys inserted as text, printable
+                    characters, tab and the bytes of a UTF-8 character,
+                    which getch hands over one at a time
+            */////////////////////////////
+                static int isTyped(int64_t key){
+                    return ((0 <= key) && (key < 256) && (isprint(key))) || ('\t' == key) || ((0x80 <= key) && (key < 256));
+                }
+        /*////////////////////////////
+            Prompt Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Open prompt
+                    takes over the banner for a line of input
+            */////////////////////////////
+                static void openPrompt(const char * label, void (*accept)(const char * text), void (*change)(const char * text), void (*cancel)()){
+                    program.prompt.active = 1;
+                    program.prompt.label = label;
+                    program.prompt.text[0] = '\0';
+                    program.prompt.length = 0;
+                    program.prompt.accept = accept;
+                    program.prompt.change = change;
+                    program.prompt.cancel = cancel;
+                    program.prompt.navigate = NULL;
+                    markDirtyBanner();
+                    placeCursor();
+                }
+            /*////////////////////////////
+                Close prompt
+                    gives the banner back to the file
+            */////////////////////////////
+                static void closePrompt(){
+                    program.prompt.active = 0;
+                    markDirtyBanner();
+                    placeCursor();
+                }
+            /*////////////////////////////
+                Prompt keypress
+                    edits the prompt, enter accepts and escape cancels
+            */////////////////////////////
+                static void promptKeypress(int64_t input){
+                    u_int64_t length = program.prompt.length;
+                    switch (input){
+                        case KEY_ENTER:
+                        case '\r':
+                        case '\n':
+                            closePrompt();
+                            program.prompt.accept(program.prompt.text);
+                        break;
+                        case 27: //escape
+                        case CTRL_KEY('g'):
+                            closePrompt();
+                            if (NULL != program.prompt.cancel){
+                                program.prompt.cancel();
+                            }
+                        break;
+                        case KEY_UP:
+                        case KEY_DOWN:
+                            if (NULL != program.prompt.navigate){
+                                program.prompt.navigate(input);
+                            }
+                        break;
+                        case KEY_BACKSPACE:
+                        case CTRL_KEY('h'):
+                        case 127:
+                            if (0 < program.prompt.length){
+                                program.prompt.text[--program.prompt.length] = '\0';
+                            }
+                        break;
+                        default:
+                            if (isTyped(input) && (program.prompt.length + 1 < MAX_PROMPT_SIZE)){
+                                program.prompt.text[program.prompt.length++] = input;
+                                program.prompt.text[program.prompt.length] = '\0';
+                            }
+                        break;
+                    }
+                    if ((length != program.prompt.length) && (NULL != program.prompt.change)){
+                        program.prompt.change(program.prompt.text);
+                    }
+                    if (program.prompt.active){
+                        markDirtyBanner();
+                        placeCursor();
+                    }
+                }
+            /*////////////////////////////
+                Accept go to line
+                    lines are numbered from 1 in the prompt
+            */////////////////////////////
+                static void acceptGotoLine(const char * text){
+                    char * end = NULL;
+                    u_int64_t line = strtoull(text, &end, 10);
+                    if ((end == text) || (0 == line)){
+                        return;
+                    }
+                    moveToLine(line - 1);
+                }
+        /*////////////////////////////
+            Browser Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Open browser
+                    shows the file select pane, listing the working directory
+                    the first time
+            */////////////////////////////
+                static void openBrowser(){
+                    if ((NULL == program.browser.current) && (NULL != program.dir)){
+                        browserOpen(&program.browser, program.dir);
+                    }
+                    program.state = STATE_FILE_SELECT;
+                }
+            /*////////////////////////////
+                Browser keypress
+                    moves the selection, enter opens it and backspace goes up
+            */////////////////////////////
+                static void browserKeypress(int64_t input, MEVENT * event){
+                    u_int64_t rows = LINES - program.margin_top;
+                    switch (input){
+                        case KEY_UP:
+                            selectEntry(-1);
+                        break;
+                        case KEY_DOWN:
+                            selectEntry(1);
+                        break;
+                        case KEY_PPAGE:
+                            selectEntry(-(int64_t)rows);
+                        break;
+                        case KEY_NPAGE:
+                            selectEntry(rows);
+                        break;
+                        case KEY_HOME:
+                            selectEntry(-(int64_t)program.browser.selected);
+                        break;
+                        case KEY_END:
+                            selectEntry(browserCount(&program.browser) - program.browser.selected);
+                        break;
+                        case KEY_ENTER:
+                        case '\r':
+                        case '\n':
+                            activateEntry(program.browser.selected);
+                        break;
+                        case KEY_BACKSPACE:
+                        case CTRL_KEY('h'):
+                        case 127:
+                            //the parent sorts first
+                            if ((0 < browserCount(&program.browser)) && (0 == strcmp(browserEntry(&program.browser, 0)->name, ".."))){
+                                activateEntry(0);
+                            }
+                        break;
+                        case 27: //escape
+                            if (NULL != program.file){
+                                program.state = STATE_FILE_EDIT;
+                                placeCursor();
+                            }
+                        break;
+                        case KEY_MOUSE:
+                            //a click on an entry opens it
+                            if ((event->x < (int)FILE_BROWSER_WIDTH) && ((u_int64_t)event->y >= program.margin_top)){
+                                u_int64_t index = program.browser.scroll + event->y - program.margin_top;
+                                if (index < browserCount(&program.browser)){
+                                    program.browser.selected = index;
+                                    activateEntry(index);
+                                }
+                            }
+                        break;
+                        default:
+                        break;
+                    }
+                }
+            /*////////////////////////////
+                Select entry
+                    moves the selection by delta entries, keeping it on screen
+            */////////////////////////////
+                static void selectEntry(int64_t delta){
+                    u_int64_t count = browserCount(&program.browser);
+                    u_int64_t rows = LINES - program.margin_top;
+                    if (0 == count){
+                        return;
+                    }
+                    if ((0 > delta) && ((u_int64_t)-delta > program.browser.selected)){
+                        program.browser.selected = 0;
+                    }else if ((0 < delta) && ((u_int64_t)delta > count - 1 - program.browser.selected)){
+                        program.browser.selected = count - 1;
+                    }else{
+                        program.browser.selected += delta;
+                    }
+                    if (program.browser.selected < program.browser.scroll){
+                        program.browser.scroll = program.browser.selected;
+                    }else if ((0 < rows) && (program.browser.selected >= program.browser.scroll + rows)){
+                        program.browser.scroll = program.browser.selected - rows + 1;
+                    }
+                    markAllDirty();
+                }
+            /*////////////////////////////
+                Activate entry
+                    enters a directory or opens a file for editing
+            */////////////////////////////
+                static void activateEntry(u_int64_t index){
+                    entry_t * entry = browserEntry(&program.browser, index);
+                    char * path = browserPath(&program.browser, index);
+                    if ((NULL == entry) || (NULL == path)){
+                        free(path);
+                        return;
+                    }
+                    if (ENTRY_DIR == entry->type){
+                        browserOpen(&program.browser, path);
+                        free(path);
+                        markAllDirty();
+                        return;
+                    }
+                    openFile(path, path);
+                    program.state = STATE_FILE_EDIT;
+                    placeCursor();
+                }
+        /*////////////////////////////
+            Fuzzy Open Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Open fuzzy
+                    prompts for a file under the working directory, loading
+                    the project index the first time
+            */////////////////////////////
+                static void openFuzzy(){
+                    if (NULL == program.dir){
+                        return;
+                    }
+                    if ((!program.project.started) && (0 != projectLoad(&program.project, program.dir, program.jobs))){
+                        return;
+                    }
+                    program.fuzzy.active = 1;
+                    openPrompt("Open: ", acceptFuzzy, changeFuzzy, cancelFuzzy);
+                    program.prompt.navigate = navigateFuzzy;
+                    changeFuzzy(program.prompt.text);
+                    if ((!program.project_polling) && (0 == projectReady(&program.project))){
+                        program.project_polling = (0 == addTimer(PROJECT_POLL_INTERVAL, pollProject));
+                    }
+                }
+            /*////////////////////////////
+                Change fuzzy
+                    reranks the paths as the query is typed
+            */////////////////////////////
+                static void changeFuzzy(const char * text){
+                    program.fuzzy.count = projectMatch(&program.project, text, program.fuzzy.results, MAX_FUZZY_RESULTS);
+                    program.fuzzy.selected = 0;
+                    markAllDirty();
+                }
+            /*////////////////////////////
+                Accept fuzzy
+                    opens the selected result for editing
+            */////////////////////////////
+                static void acceptFuzzy(const char * text){
+                    (void)text;
+                    program.fuzzy.active = 0;
+                    markAllDirty();
+                    if (program.fuzzy.selected >= program.fuzzy.count){
+                        return;
+                    }
+                    char * path = projectPath(&program.project, program.fuzzy.results[program.fuzzy.selected]);
+                    if (NULL == path){
+                        return;
+                    }
+                    openFile(path, path);
+                    program.state = STATE_FILE_EDIT;
+                    placeCursor();
+                }
+            /*////////////////////////////
+                Cancel fuzzy
+            */////////////////////////////
+                static void cancelFuzzy(){
+                    program.fuzzy.active = 0;
+                    markAllDirty();
+                }
+            /*////////////////////////////
+                Navigate fuzzy
+                    moves the selection through the visible results
+            */////////////////////////////
+                static void navigateFuzzy(int64_t input){
+                    u_int64_t rows = (LINES > (int)program.margin_top) ? LINES - program.margin_top : 0;
+                    u_int64_t visible = (program.fuzzy.count < rows) ? program.fuzzy.count : rows;
+                    if ((KEY_UP == input) && (0 < program.fuzzy.selected)){
+                        program.dirty[program.margin_top + program.fuzzy.selected--] = 1;
+                        program.dirty[program.margin_top + program.fuzzy.selected] = 1;
+                    }else if ((KEY_DOWN == input) && (program.fuzzy.selected + 1 < visible)){
+                        program.dirty[program.margin_top + program.fuzzy.selected++] = 1;
+                        program.dirty[program.margin_top + program.fuzzy.selected] = 1;
+                    }
+                }
+            /*////////////////////////////
+                Poll project
+                    ranks the results once the project index is ready
+            */////////////////////////////
+                static int pollProject(){
+                    if (!program.fuzzy.active){
+                        program.project_polling = 0;
+                        return 1;
+                    }
+                    if (0 == projectReady(&program.project)){
+                        return 0;
+                    }
+                    changeFuzzy(program.prompt.text);
+                    program.project_polling = 0;
+                    return 1;
+                }
+        /*////////////////////////////
+            Search Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Open search
+                    prompts for a pattern, remembering where the cursor was
+            */////////////////////////////
+                static void openSearch(){
+                    clearSearch();
+                    program.search.cursx = program.cursx;
+                    program.search.cursy = program.cursy;
+                    program.search.scrolly = program.scrolly;
+                    openPrompt("Find: ", acceptSearch, changeSearch, cancelSearch);
+                }
+            /*////////////////////////////
+                Change search
+                    reruns the search from where it began as the pattern is typed
+            */////////////////////////////
+                static void changeSearch(const char * text){
+                    program.search.length = strnlen(text, MAX_PATTERN_SIZE - 1);
+                    memcpy(program.search.pattern, text, program.search.length);
+                    markAllDirty();
+                    if (0 == program.search.length){
+                        return;
+                    }
+                    u_int64_t from = bufferLineStart(program.text, program.search.cursy) + program.search.cursx;
+                    u_int64_t match = searchForward(program.text, program.search.pattern, program.search.length, from);
+                    if (SEARCH_NONE == match){
+                        match = searchForward(program.text, program.search.pattern, program.search.length, 0);
+                    }
+                    if (SEARCH_NONE != match){
+                        moveToOffset(match);
+                    }
+                }
+            /*////////////////////////////
+                Accept search
+                    keeps the cursor on the match and the pattern highlighted
+            */////////////////////////////
+                static void acceptSearch(const char * text){
+                    (void)text;
+                    placeCursor();
+                }
+            /*////////////////////////////
+                Cancel search
+                    puts the cursor back where the search began
+            */////////////////////////////
+                static void cancelSearch(){
+                    clearSearch();
+                    program.cursx = program.search.cursx;
+                    program.cursy = program.search.cursy;
+                    program.scrolly = program.search.scrolly;
+                    followCursor();
+                    placeCursor();
+                }
+            /*////////////////////////////
+                Clear search
+                    drops the pattern and its highlights
+            */////////////////////////////
+                static void clearSearch(){
+                    if ((0 != program.search.length) || (program.search.regex) || (program.search.invalid)){
+                        finderStop(&program.finder);
+                        program.search.length = 0;
+                        program.search.regex = 0;
+                        program.search.pending = 0;
+                        program.search.invalid = 0;
+                        markAllDirty();
+                        markDirtyBanner();
+                    }
+                }
+            /*////////////////////////////
+                Find next
+                    moves to the next match after the cursor, wrapping at the end
+            */////////////////////////////
+                static void findNext(){
+                    if (program.search.regex){
+                        const match_t * match = finderMatchAfter(&program.finder, getCursorOffset() + 1);
+                        if (NULL == match){
+                            match = finderMatchAfter(&program.finder, 0);
+                        }
+                        if (NULL != match){
+                            moveToOffset(match->offset);
+                        }
+                        return;
+                    }
+                    if (0 == program.search.length){
+                        return;
+                    }
+                    u_int64_t match = searchForward(program.text, program.search.pattern, program.search.length, getCursorOffset() + 1);
+                    if (SEARCH_NONE == match){
+                        match = searchForward(program.text, program.search.pattern, program.search.length, 0);
+                    }
+                    if (SEARCH_NONE != match){
+                        moveToOffset(match);
+                    }
+                }
+            /*////////////////////////////
+                Find previous
+                    moves to the previous match before the cursor, wrapping at the start
+            */////////////////////////////
+                static void findPrevious(){
+                    if (program.search.regex){
+                        const match_t * match = finderMatchBefore(&program.finder, getCursorOffset());
+                        if (NULL == match){
+                            match = finderMatchBefore(&program.finder, UINT64_MAX);
+                        }
+                        if (NULL != match){
+                            moveToOffset(match->offset);
+                        }
+                        return;
+                    }
+                    if (0 == program.search.length){
+                        return;
+                    }
+                    u_int64_t match = searchBackward(program.text, program.search.pattern, program.search.length, getCursorOffset());
+                    if (SEARCH_NONE == match){
+                        match = searchBackward(program.text, program.search.pattern, program.search.length, bufferLength(program.text));
+                    }
+                    if (SEARCH_NONE != match){
+                        moveToOffset(match);
+                    }
+                }
+            /*////////////////////////////
+                Accept regex
+                    replaces any search with a background regex search
+            */////////////////////////////
+                static void acceptRegex(const char * text){
+                    clearSearch();
+                    program.search.length = strnlen(text, MAX_PATTERN_SIZE - 1);
+                    memcpy(program.search.pattern, text, program.search.length);
+                    program.search.pattern[program.search.length] = '\0';
+                    program.search.regex = 1;
+                    program.search.shown = 0;
+                    startRegex();
+                    if ((program.search.regex) && (!program.search.polling)){
+                        program.search.polling = (0 == addTimer(REGEX_POLL_INTERVAL, pollRegex));
+                    }
+                }
+            /*////////////////////////////
+                Start regex
+                    starts the finder once the line index is complete
+            */////////////////////////////
+                static void startRegex(){
+                    program.search.pending = (1 == bufferIndexing(program.text));
+                    if (program.search.pending){
+                        return;
+                    }
+                    if (0 != finderStart(&program.finder, program.text, program.search.pattern, program.jobs)){
+                        program.search.regex = 0;
+                        program.search.length = 0;
+                        program.search.invalid = 1;
+                        markDirtyBanner();
+                    }
+                }
+            /*////////////////////////////
+                Poll regex
+                    repaints as results stream in
+                    returns nonzero once the search is over to cancel its timer
+            */////////////////////////////
+                static int pollRegex(){
+                    if ((program.search.regex) && (program.search.pending)){
+                        startRegex();
+                    }
+                    u_int64_t count = finderMatchCount(&program.finder);
+                    if (count != program.search.shown){
+                        program.search.shown = count;
+                        markAllDirty();
+                    }
+                    markDirtyBanner();
+                    program.search.polling = (program.search.regex) && ((program.search.pending) || (finderRunning(&program.finder)));
+                    return !program.search.polling;
+                }
+        /*////////////////////////////
+            Event Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Event loop
+                    waits on input, signals and timers, applies every pending
+                    event and then renders once
+            */////////////////////////////
+                static void eventLoop(){
+                    struct pollfd events[EVENT_COUNT];
+                    events[EVENT_INPUT].fd = STDIN_FILENO;
+                    events[EVENT_INPUT].events = POLLIN;
+                    events[EVENT_SIGNAL].fd = signal_pipe[0];
+                    events[EVENT_SIGNAL].events = POLLIN;
+                    events[EVENT_WATCH].fd = program.watch_fd;
+                    events[EVENT_WATCH].events = POLLIN;
+                    for (;;){
+                        //timers run first so whatever they damage is painted before waiting
+                        int timeout = runTimers();
+                        editorRefreshScreen();
+                        traceRender(&program.trace);
+                        refresh();
+                        traceRefresh(&program.trace);
+                        int ready = poll(events, EVENT_COUNT, timeout);
+                        if (0 > ready){
+                            if (EINTR == errno){
+                                continue;
+                            }
+                            die("eventLoop - poll");
+                        }
+                        if (events[EVENT_SIGNAL].revents & POLLIN){
+                            handleSignals();
+                        }
+                        if (events[EVENT_WATCH].revents & POLLIN){
+                            handleWatch();
+                        }
+                        if (events[EVENT_INPUT].revents & POLLIN){
+                            traceReceive(&program.trace);
+                            processInput();
+                            traceUpdate(&program.trace, program.key_count);
+                            if (program.latency){
+                                markDirtyBanner();
+                            }
+                        }else if (events[EVENT_INPUT].revents & (POLLHUP | POLLERR)){
+                            exit(EXIT_SUCCESS);
+                        }
+                    }
+                }
+            /*////////////////////////////
+                Process input
+                    drains every queued key and applies them as one batch
+            */////////////////////////////
+                static void processInput(){
+                    //drain everything already queued
+                    program.key_count = 0;
+                    for (;;){
+                        int64_t key = getch();
+                        if (ERR == key){
+                            break;
+                        }
+                        keypress_t * keypress = nextKeypress();
+                        keypress->key = key;
+                        if ((KEY_MOUSE == key) && (OK != getmouse(&keypress->mouse))){
+                            continue;
+                        }
+                        program.key_count++;
+                    }
+                    if (NULL != program.recording.file){
+                        recordKeys();
+                    }
+                    applyKeys();
+                }
+            /*////////////////////////////
+                Next keypress
+                    returns the slot after the batch, growing it when full
+            */////////////////////////////
+                static keypress_t * nextKeypress(){
+                    if (program.key_count == program.key_capacity){
+                        program.key_capacity = growCapacity(program.key_capacity, program.key_count + 1, MIN_KEY_CAPACITY);
+                        program.keys = recalloc(program.keys, program.key_capacity, sizeof(keypress_t));
+                        if (NULL == program.keys){
+                            die("nextKeypress - calloc");
+                        }
+                    }
+                    return &program.keys[program.key_count];
+                }
+            /*////////////////////////////
+                Apply keys
+                    applies the drained batch, folding runs of movement keys
+                    into one move and runs of typed characters into one insert
+            */////////////////////////////
+                static void applyKeys(){
+                    //notices last until the next key, those the batch raises are shown
+                    if ((0 != program.key_count) && (NULL != program.notice)){
+                        program.notice = NULL;
+                        markDirtyBanner();
+                    }
+                    u_int64_t iter = 0;
+                    while (iter < program.key_count){
+                        int64_t key = program.keys[iter].key;
+                        u_int64_t run = iter + 1;
+                        if ((NULL == program.file) || (STATE_FILE_EDIT != program.state) || (program.prompt.active)){
+                            editorProcessKeypress(&program.keys[iter]);
+                        }else if ((KEY_UP == key) || (KEY_DOWN == key) || (KEY_LEFT == key) || (KEY_RIGHT == key)){
+                            while ((run < program.key_count) && (key == program.keys[run].key)){
+                                run++;
+                            }
+                            int64_t count = run - iter;
+                            historyBreak(&program.history);
+                            switch (key){
+                                case KEY_UP:
+                                    moveLines(-count);
+                                break;
+                                case KEY_DOWN:
+                                    moveLines(count);
+                                break;
+                                case KEY_LEFT:
+                                    moveChars(-count);
+                                break;
+                                case KEY_RIGHT:
+                                    moveChars(count);
+                                break;
+                            }
+                        }else if (isTyped(key)){
+                            char typed[MAX_TYPED_RUN];
+                            u_int64_t length = 0;
+                            typed[length++] = key;
+                            while ((run < program.key_count) && (length < MAX_TYPED_RUN)){
+                                int64_t next = program.keys[run].key;
+                                if (!isTyped(next)){
+                                    break;
+                                }
+                                typed[length++] = next;
+                                run++;
+                            }
+                            insertText(typed, length);
+                        }else{
+                            editorProcessKeypress(&program.keys[iter]);
+                        }
+                        iter = run;
+                    }
+                }
+            /*////////////////////////////
+                Handle signals
+                    runs deferred work for signals caught since the last poll
+            */////////////////////////////
+                static void handleSignals(){
+                    unsigned char caught[64];
+                    ssize_t count = read(signal_pipe[0], caught, sizeof(caught));
+                    for (ssize_t iter = 0; iter < count; iter++){
+                        switch (caught[iter]){
+                            case SIGWINCH:
+                                resizeTerminal();
+                            break;
+                            case SIGBUS:
+                                findFault();
+                            break;
+                            default:
+                            break;
+                        }
+                    }
+                }
+            /*////////////////////////////
+                Handle watch
+                    drains the inotify events, which can come one per write,
+                    and leaves the work to one follow check after a short wait,
+                    except for a file cut short, which cannot wait for it
+            */////////////////////////////
+                static void handleWatch(){
+                    char events[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+                    while (0 < read(program.watch_fd, events, sizeof(events))){
+                        //only the shown file is watched, so any event means a check
+                    }
+                    if (-1 != program.watch){
+                        checkShrunk();
+                        scheduleCheck();
+                    }
+                }
+            /*////////////////////////////
+                On signal
+                    async signal handler, defers the work to the event loop
+            */////////////////////////////
+                static void onSignal(int signal_number){
+                    int saved_errno = errno;
+                    unsigned char caught = signal_number;
+                    if (-1 == write(signal_pipe[1], &caught, 1)){
+                        //pipe full, a wakeup is already pending
+                    }
+                    errno = saved_errno;
+                }
+            /*////////////////////////////
+                On bus error
+                    async signal handler for reads past the end of a file cut
+                    short under its mapping, from the main thread or a worker,
+                    the lost page is replaced with zeros so the read finishes
+                    and its address is left for the event loop to find the
+                    file it belongs to, any other bus error still ends the program
+                    it reads no program state, which the main thread may be
+                    changing, and mmap is the bare system call, taking no lock
+            */////////////////////////////
+                static void onBusError(int signal_number, siginfo_t * info, void * context){
+                    (void)context;
+                    int saved_errno = errno;
+                    char * page = (char *)((uintptr_t)info->si_addr / page_size * page_size);
+                    if ((BUS_ADRERR != info->si_code) || (MAP_FAILED == mmap(page, page_size, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED | MAP_NORESERVE, -1, 0))){
+                        //the read faults again, now without a handler
+                        signal(SIGBUS, SIG_DFL);
+                        errno = saved_errno;
+                        return;
+                    }
+                    __atomic_store_n(&fault_address, (uintptr_t)page, __ATOMIC_RELEASE);
+                    unsigned char caught = signal_number;
+                    if (-1 == write(signal_pipe[1], &caught, 1)){
+                        //pipe full or headless, the next check finds the file cut short
+                    }
+                    errno = saved_errno;
+                }
+            /*////////////////////////////
+                Find fault
+                    marks the file whose mapping held the page a bus error
+                    replaced, the shown one is read again at once, a parked
+                    one when it is shown next
+            */////////////////////////////
+                static void findFault(){
+                    char * page = (char *)__atomic_exchange_n(&fault_address, 0, __ATOMIC_ACQ_REL);
+                    if (NULL == page){
+                        return;
+                    }
+                    if ((NULL != program.file) && (program.mapped) && (program.data <= page) && (page < program.data + program.map_size)){
+                        program.lost = 1;
+                        checkShrunk();
+                        return;
+                    }
+                    for (u_int64_t iter = 0; iter < program.document_count; iter++){
+                        document_t * document = &program.documents[iter];
+                        if ((iter != program.active) && (document->mapped) && (document->data <= page) && (page < document->data + document->map_size)){
+                            document->lost = 1;
+                        }
+                    }
+                }
+            /*////////////////////////////
+                Resize terminal
+                    picks up the new window size and keeps the cursor in view
+            */////////////////////////////
+                static void resizeTerminal(){
+                    struct winsize size;
+                    if ((0 != ioctl(STDOUT_FILENO, TIOCGWINSZ, &size)) || (0 == size.ws_row) || (0 == size.ws_col)){
+                        return;
+                    }
+                    resizeterm(size.ws_row, size.ws_col);
+                    if (NULL != program.recording.file){
+                        recordResize();
+                    }
+                    if (NULL != program.file){
+                        followCursor();
+                        placeCursor();
+                    }
+                }
+            /*////////////////////////////
+                Add timer
+                    runs callback every interval ms from the event loop
+                    returns 0 on success, -1 when every timer is taken
+            */////////////////////////////
+                static int addTimer(u_int64_t interval, int (*callback)()){
+                    if (MAX_TIMERS <= timer_count){
+                        return -1;
+                    }
+                    timers[timer_count].interval = interval;
+                    timers[timer_count].due = monotonicMilliseconds() + interval;
+                    timers[timer_count].callback = callback;
+                    timer_count++;
+                    return 0;
+                }
+            /*////////////////////////////
+                Pace timer
+                    sets the interval of the timer running callback, from its next run on
+            */////////////////////////////
+                static void paceTimer(int (*callback)(), u_int64_t interval){
+                    for (u_int64_t iter = 0; iter < timer_count; iter++){
+                        if (callback == timers[iter].callback){
+                            timers[iter].interval = interval;
+                        }
+                    }
+                }
+            /*////////////////////////////
+                Run timers
+                    runs every due timer, dropping those whose callback asks to stop
+                    returns the poll timeout until the next one, -1 when none
+            */////////////////////////////
+                static int runTimers(){
+                    u_int64_t now = monotonicMilliseconds();
+                    for (u_int64_t iter = 0; iter < timer_count;){
+                        if ((timers[iter].due <= now) && (0 != timers[iter].callback())){
+                            timers[iter] = timers[--timer_count];
+                            continue;
+                        }
+                        if (timers[iter].due <= now){
+                            timers[iter].due = now + timers[iter].interval;
+                        }
+                        iter++;
+                    }
+                    if (0 == timer_count){
+                        return -1;
+                    }
+                    u_int64_t next = UINT64_MAX;
+                    for (u_int64_t iter = 0; iter < timer_count; iter++){
+                        if (timers[iter].due < next){
+                            next = timers[iter].due;
+                        }
+                    }
+                    return next - now;
+                }
+            /*////////////////////////////
+                Monotonic milliseconds
+            */////////////////////////////
+                static u_int64_t monotonicMilliseconds(){
+                    struct timespec now;
+                    clock_gettime(CLOCK_MONOTONIC, &now);
+                    return (u_int64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+                }
+
+        /*////////////////////////////
+            Execution Flow
+        */////////////////////////////
+            /*////////////////////////////
+                Init, initializes program state to defaults
+            */////////////////////////////
+                static void initProgram(){
+                    program.file = DEFAULT_FILE;
+                    program.dir = DEFAULT_DIR;
+                    program.jobs = DEFAULT_JOBS;
+                    program.cursx = 0;
+                    program.cursy = 0;
+                    program.scrolly = DEFAULT_SCROLL;
+                    program.scrollx = 0;
+                    program.text = NULL;
+                    program.data = NULL;
+                    program.data_size = 0;
+                    program.mapped = 0;
+                    program.map_size = 0;
+                    program.data_fd = -1;
+                    program.sync = DEFAULT_SYNC;
+                    program.undo_limit = DEFAULT_UNDO_LIMIT;
+                    program.unpack_limit = DEFAULT_UNPACK_LIMIT;
+                    historyInit(&program.history, DEFAULT_UNDO_LIMIT);
+                    memset(&program.syntax, 0, sizeof(syntax_t));
+                    columnsInit(&program.columns);
+                    program.documents = NULL;
+                    program.document_count = 0;
+                    program.document_capacity = 0;
+                    program.active = 0;
+                    program.switches = 0;
+                    program.memory_budget = DEFAULT_MEMORY_BUDGET;
+                    program.index_polling = 0;
+                    program.view = 0;
+                    program.follow = 0;
+                    program.watch_fd = -1;
+                    program.watch = -1;
+                    program.disk_pending = 0;
+                    program.notice = NULL;
+                    program.margin_top = 1;
+                    program.dirty = NULL;
+                    memset(&program.painted, 0, sizeof(frame_t));
+                    memset(&program.prompt, 0, sizeof(prompt_t));
+                    memset(&program.browser, 0, sizeof(browser_t));
+                    memset(&program.project, 0, sizeof(project_t));
+                    memset(&program.fuzzy, 0, sizeof(fuzzy_t));
+                    program.owned_file = NULL;
+                    program.keys = NULL;
+                    program.key_count = 0;
+                    program.key_capacity = 0;
+                    traceInit(&program.trace);
+                    program.trace_file = NULL;
+                    program.latency = 0;
+                    memset(&program.recording, 0, sizeof(recording_t));
+                    memset(&program.replay, 0, sizeof(replay_t));
+                }
+            /*////////////////////////////
+                Guard mappings
+                    files are mapped rather than read, so one cut short by
+                    another program, as log rotation does, would otherwise
+                    end the editor on the next read of a page it lost, from
+                    the paint, the indexer or the finder alike
+            */////////////////////////////
+                static void guardMappings(){
+                    long page = sysconf(_SC_PAGESIZE);
+                    if (0 < page){
+                        page_size = page;
+                    }
+                    struct sigaction action;
+                    memset(&action, 0, sizeof(action));
+                    action.sa_sigaction = onBusError;
+                    sigemptyset(&action.sa_mask);
+                    action.sa_flags = SA_SIGINFO | SA_RESTART;
+                    sigaction(SIGBUS, &action, NULL);
                 }
             /*////////////////////////////
                 At Exit
@@ -661,6 +3469,22 @@
             */////////////////////////////
                 static void exitFunc(){
                     exitCurses();
+                    if (0 != recordingClose(&program.recording)){
+                        perror("exitFunc - recordingClose");
+                    }
+                    if (program.replay.active){
+                        reportReplay();
+                    }
+                    if (NULL != program.trace_file){
+                        FILE * output = fopen(program.trace_file, "w");
+                        if (NULL == output){
+                            perror("exitFunc - fopen");
+                            return;
+                        }
+                        if ((0 != traceWrite(&program.trace, output)) | (0 != fclose(output))){
+                            perror("exitFunc - traceWrite");
+                        }
+                    }
                 }
             /*////////////////////////////
                 Die, exit program and display error
@@ -687,6 +3511,73 @@
                             p_input->dir = p_arg;
                             args_count--;
                         break;
+                        case 'j':{
+                            char * end = NULL;
+                            p_input->jobs = strtoull(p_arg, &end, 10);
+                            if ((end == p_arg) || ('\0' != *end)){
+                                argp_error(p_state, "invalid job count '%s'", p_arg);
+                            }
+                        }
+                        break;
+                        case 'u':{
+                            char * end = NULL;
+                            p_input->undo_limit = strtoull(p_arg, &end, 10);
+                            if ((end == p_arg) || ('\0' != *end)){
+                                argp_error(p_state, "invalid undo memory '%s'", p_arg);
+                            }
+                        }
+                        break;
+                        case 'z':{
+                            char * end = NULL;
+                            p_input->unpack_limit = strtoull(p_arg, &end, 10);
+                            if ((end == p_arg) || ('\0' != *end)){
+                                argp_error(p_state, "invalid unpack limit '%s'", p_arg);
+                            }
+                        }
+                        break;
+                        case 'b':
+                            p_input->bench = p_arg;
+                        break;
+                        case 't':
+                            p_input->trace = p_arg;
+                        break;
+                        case 'l':
+                            p_input->latency = 1;
+                        break;
+                        case 'r':
+                            p_input->record = p_arg;
+                        break;
+                        case 'p':
+                            p_input->replay = p_arg;
+                        break;
+                        case 'R':
+                            p_input->realtime = 1;
+                        break;
+                        case 'v':
+                            p_input->view = 1;
+                        break;
+                        case 'F':
+                            p_input->follow = 1;
+                        break;
+                        case 'm':{
+                            char * end = NULL;
+                            p_input->memory_budget = strtoull(p_arg, &end, 10);
+                            if ((end == p_arg) || ('\0' != *end)){
+                                argp_error(p_state, "invalid memory budget '%s'", p_arg);
+                            }
+                        }
+                        break;
+                        case 's':
+                            if (0 == strcmp(p_arg, "none")){
+                                p_input->sync = SYNC_NONE;
+                            }else if (0 == strcmp(p_arg, "data")){
+                                p_input->sync = SYNC_DATA;
+                            }else if (0 == strcmp(p_arg, "full")){
+                                p_input->sync = SYNC_FULL;
+                            }else{
+                                argp_error(p_state, "invalid sync mode '%s'", p_arg);
+                            }
+                        break;
                         case ARGP_KEY_ARG:
                             switch (p_state->arg_num){
                                 case 0:
@@ -710,6 +3601,320 @@
                     }
                     return 0;
                 }
+        /*////////////////////////////
+            Bench Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Run bench
+                    times every file in dir in name order and prints the
+                    measures as JSON once the screen is closed
+                    returns the exit status
+            */////////////////////////////
+                static int runBench(const char * dir){
+                    DIR * listing = opendir(dir);
+                    if (NULL == listing){
+                        die("runBench - opendir");
+                    }
+                    char ** names = NULL;
+                    u_int64_t count = 0;
+                    u_int64_t capacity = 0;
+                    for (struct dirent * entry = readdir(listing); NULL != entry; entry = readdir(listing)){
+                        //hidden files include the bench's own saves
+                        if ('.' == entry->d_name[0]){
+                            continue;
+                        }
+                        if (count == capacity){
+                            capacity = growCapacity(capacity, count + 1, MIN_KEY_CAPACITY);
+                            names = realloc(names, capacity * sizeof(char *));
+                            if (NULL == names){
+                                die("runBench - realloc");
+                            }
+                        }
+                        names[count] = strdup(entry->d_name);
+                        if (NULL == names[count]){
+                            die("runBench - strdup");
+                        }
+                        count++;
+                    }
+                    closedir(listing);
+                    qsort(names, count, sizeof(char *), compareNames);
+                    bench_t bench;
+                    benchInit(&bench);
+                    for (u_int64_t iter = 0; iter < count; iter++){
+                        u_int64_t size = strlen(dir) + strlen(names[iter]) + 2;
+                        char * path = malloc(size);
+                        if (NULL == path){
+                            die("runBench - malloc");
+                        }
+                        snprintf(path, size, "%s/%s", dir, names[iter]);
+                        stat_t file_stat;
+                        if ((0 != stat(path, &file_stat)) || (!S_ISREG(file_stat.st_mode))){
+                            free(path);
+                        }else{
+                            benchFile(&bench, dir, path, names[iter]);
+                        }
+                        free(names[iter]);
+                    }
+                    free(names);
+                    exitCurses();
+                    int status = benchWrite(&bench, stdout);
+                    benchRelease(&bench);
+                    return (0 == status) ? EXIT_SUCCESS : EXIT_FAILURE;
+                }
+            /*////////////////////////////
+                Bench file
+                    opens path, taking ownership of it, and times loading,
+                    painting, moving, typing, searching and saving it
+            */////////////////////////////
+                static void benchFile(bench_t * bench, const char * dir, char * path, const char * name){
+                    //open is the wait for the first screen, index the rest of the load
+                    benchBegin(bench, "open", name);
+                    benchStart(bench);
+                    openFile(path, path);
+                    editorRefreshScreen();
+                    refresh();
+                    benchStop(bench, 0);
+                    benchBegin(bench, "index", name);
+                    benchStart(bench);
+                    if (0 != bufferFinishIndex(program.text)){
+                        die("benchFile - index");
+                    }
+                    benchStop(bench, program.data_size);
+                    program.indexed_lines = bufferLineCount(program.text);
+                    markAllDirty();
+                    //frames
+                    benchBegin(bench, "frame_full", name);
+                    for (u_int64_t iter = 0; iter < BENCH_FRAMES; iter++){
+                        markAllDirty();
+                        benchStart(bench);
+                        editorRefreshScreen();
+                        refresh();
+                        benchStop(bench, 0);
+                    }
+                    benchBegin(bench, "frame_scroll", name);
+                    for (u_int64_t iter = 0; iter < BENCH_FRAMES; iter++){
+                        benchStart(bench);
+                        moveDown();
+                        editorRefreshScreen();
+                        refresh();
+                        benchStop(bench, 0);
+                    }
+                    //cursor movement within and across the first lines, which
+                    //are the long ones in the long line corpus
+                    moveFileStart();
+                    benchBegin(bench, "cursor_right", name);
+                    for (u_int64_t iter = 0; iter < BENCH_MOVES; iter++){
+                        benchStart(bench);
+                        moveRight();
+                        benchStop(bench, 0);
+                    }
+                    benchBegin(bench, "cursor_eol", name);
+                    for (u_int64_t iter = 0; iter < BENCH_LINES; iter++){
+                        moveToLine(iter);
+                        benchStart(bench);
+                        moveEOL();
+                        benchStop(bench, 0);
+                    }
+                    moveFileStart();
+                    moveEOL();
+                    benchBegin(bench, "cursor_down", name);
+                    for (u_int64_t iter = 0; iter < BENCH_MOVES; iter++){
+                        benchStart(bench);
+                        moveDown();
+                        benchStop(bench, 0);
+                    }
+                    //typing repaints incrementally
+                    moveFileStart();
+                    editorRefreshScreen();
+                    benchBegin(bench, "frame_typing", name);
+                    for (u_int64_t iter = 0; iter < BENCH_FRAMES; iter++){
+                        benchStart(bench);
+                        insertChar('x');
+                        editorRefreshScreen();
+                        refresh();
+                        benchStop(bench, 0);
+                    }
+                    //searches scan the whole edited buffer
+                    u_int64_t length = bufferLength(program.text);
+                    benchBegin(bench, "search_literal", name);
+                    benchStart(bench);
+                    searchForward(program.text, BENCH_PATTERN, strlen(BENCH_PATTERN), 0);
+                    benchStop(bench, length);
+                    benchBegin(bench, "search_regex", name);
+                    benchStart(bench);
+                    if (0 != finderStart(&program.finder, program.text, BENCH_REGEX, program.jobs)){
+                        die("benchFile - finderStart");
+                    }
+                    while (finderRunning(&program.finder)){
+                        struct timespec pause = {0, 100000};
+                        nanosleep(&pause, NULL);
+                    }
+                    benchStop(bench, length);
+                    finderStop(&program.finder);
+                    //saves go to a hidden file beside the corpus
+                    u_int64_t size = strlen(dir) + strlen(name) + 16;
+                    char * save_path = malloc(size);
+                    if (NULL == save_path){
+                        die("benchFile - malloc");
+                    }
+                    snprintf(save_path, size, "%s/.%s.saved", dir, name);
+                    benchBegin(bench, "save", name);
+                    benchStart(bench);
+                    if (0 != saveBuffer(program.text, save_path, program.data_fd, SYNC_NONE)){
+                        die("benchFile - saveBuffer");
+                    }
+                    benchStop(bench, length);
+                    unlink(save_path);
+                    free(save_path);
+                    closeFile();
+                }
+            /*////////////////////////////
+                Compare names
+            */////////////////////////////
+                static int compareNames(const void * left, const void * right){
+                    return strcmp(*(char * const *)left, *(char * const *)right);
+                }
+        /*////////////////////////////
+            Recording Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Record keys
+                    appends the drained batch to the recording
+            */////////////////////////////
+                static void recordKeys(){
+                    u_int64_t now = benchNow();
+                    for (u_int64_t iter = 0; iter < program.key_count; iter++){
+                        keypress_t * keypress = &program.keys[iter];
+                        record_t record;
+                        memset(&record, 0, sizeof(record_t));
+                        record.batch = (0 == iter);
+                        if (KEY_MOUSE == keypress->key){
+                            record.kind = RECORD_MOUSE;
+                            record.x = keypress->mouse.x;
+                            record.y = keypress->mouse.y;
+                            record.bstate = keypress->mouse.bstate;
+                        }else{
+                            record.kind = RECORD_KEY;
+                            record.key = keypress->key;
+                        }
+                        if (0 != recordingWrite(&program.recording, &record, now)){
+                            die("recordKeys - recordingWrite");
+                        }
+                    }
+                }
+            /*////////////////////////////
+                Record resize
+                    appends the terminal size to the recording
+            */////////////////////////////
+                static void recordResize(){
+                    record_t record;
+                    memset(&record, 0, sizeof(record_t));
+                    record.kind = RECORD_RESIZE;
+                    record.batch = 1;
+                    record.x = COLS;
+                    record.y = LINES;
+                    if (0 != recordingWrite(&program.recording, &record, benchNow())){
+                        die("recordResize - recordingWrite");
+                    }
+                }
+            /*////////////////////////////
+                Run replay
+                    applies the batches recorded at path as the event loop
+                    would, painting after each, either back to back or at the
+                    recorded pace
+            */////////////////////////////
+                static void runReplay(const char * path, u_int8_t realtime){
+                    recording_t recording;
+                    if (0 != recordingOpen(&recording, path)){
+                        die("runReplay - recordingOpen");
+                    }
+                    //the file is indexed up front so every run starts from the same state
+                    if (NULL != program.file){
+                        if (0 != bufferFinishIndex(program.text)){
+                            die("runReplay - index");
+                        }
+                        program.indexed_lines = bufferLineCount(program.text);
+                        markAllDirty();
+                    }
+                    editorRefreshScreen();
+                    refresh();
+                    terminalBytes();
+                    benchInit(&program.replay.bench);
+                    if (0 != benchBegin(&program.replay.bench, "replay_frame", path)){
+                        die("runReplay - benchBegin");
+                    }
+                    program.replay.path = path;
+                    program.replay.bytes = 0;
+                    program.replay.started = benchNow();
+                    program.replay.active = 1;
+                    record_t record;
+                    int status = recordingRead(&recording, &record);
+                    while (1 == status){
+                        if (realtime){
+                            u_int64_t due = program.replay.started + record.time * 1000;
+                            for (u_int64_t now = benchNow(); now < due; now = benchNow()){
+                                struct timespec pause = {(due - now) / 1000000000, (due - now) % 1000000000};
+                                nanosleep(&pause, NULL);
+                            }
+                        }
+                        u_int64_t started = benchNow();
+                        traceReceive(&program.trace);
+                        //a batch runs up to the next record starting one
+                        program.key_count = 0;
+                        do{
+                            if (RECORD_RESIZE == record.kind){
+                                resizeterm(record.y, record.x);
+                                if (NULL != program.file){
+                                    followCursor();
+                                    placeCursor();
+                                }
+                            }else{
+                                keypress_t * keypress = nextKeypress();
+                                memset(keypress, 0, sizeof(keypress_t));
+                                keypress->key = record.key;
+                                if (RECORD_MOUSE == record.kind){
+                                    keypress->key = KEY_MOUSE;
+                                    keypress->mouse.x = record.x;
+                                    keypress->mouse.y = record.y;
+                                    keypress->mouse.bstate = record.bstate;
+                                }
+                                program.key_count++;
+                            }
+                            status = recordingRead(&recording, &record);
+                        }while ((1 == status) && (!record.batch));
+                        applyKeys();
+                        traceUpdate(&program.trace, program.key_count);
+                        runTimers();
+                        editorRefreshScreen();
+                        traceRender(&program.trace);
+                        refresh();
+                        traceRefresh(&program.trace);
+                        u_int64_t bytes = terminalBytes();
+                        program.replay.bytes += bytes;
+                        benchSample(&program.replay.bench, benchNow() - started, bytes);
+                    }
+                    recordingClose(&recording);
+                    if (0 > status){
+                        errno = EINVAL;
+                        die("runReplay - recordingRead");
+                    }
+                }
+            /*////////////////////////////
+                Report replay
+                    prints the frame costs and the whole replay as JSON, from
+                    exit so replays ending in a quit are reported too
+            */////////////////////////////
+                static void reportReplay(){
+                    bench_t * bench = &program.replay.bench;
+                    u_int64_t elapsed = benchNow() - program.replay.started;
+                    program.replay.active = 0;
+                    if ((0 != benchBegin(bench, "replay_total", program.replay.path))
+                        || (0 != benchSample(bench, elapsed, program.replay.bytes))
+                        || (0 != benchWrite(bench, stdout))){
+                        perror("reportReplay");
+                    }
+                    benchRelease(bench);
+                }
         /*////////////////////////////
             Terminal Functions
         */////////////////////////////
@@ -720,6 +3925,42 @@
                 static void exitCurses(){
                     endwin();
                 }
+            /*////////////////////////////
+                Init headless
+                    drives curses into /dev/null at a fixed size so frames
+                    cost what they would on a terminal without needing one,
+                    or into a temporary file when the bytes are counted
+            */////////////////////////////
+                static void initHeadless(u_int8_t counting){
+                    FILE * output = counting ? tmpfile() : fopen("/dev/null", "w");
+                    FILE * input = fopen("/dev/null", "r");
+                    char * term = getenv("TERM");
+                    if ((NULL == term) || ('\0' == term[0]) || (0 == strcmp(term, "dumb"))){
+                        term = BENCH_TERM;
+                    }
+                    if ((NULL == output) || (NULL == input) || (NULL == newterm(term, output, input))){
+                        die("initHeadless - newterm");
+                    }
+                    terminal_output = output;
+                    start_color();
+                    resizeterm(BENCH_ROWS, BENCH_COLS);
+                }
+            /*////////////////////////////
+                Terminal bytes
+                    returns the bytes curses wrote headless since the last
+                    call, emptying the file they went to
+            */////////////////////////////
+                static u_int64_t terminalBytes(){
+                    stat_t output_stat;
+                    if ((NULL == terminal_output) || (0 != fflush(terminal_output)) || (0 != fstat(fileno(terminal_output), &output_stat))){
+                        return 0;
+                    }
+                    if (0 != ftruncate(fileno(terminal_output), 0)){
+                        die("terminalBytes - ftruncate");
+                    }
+                    rewind(terminal_output);
+                    return output_stat.st_size;
+                }
             /*////////////////////////////
                 Enable Raw Mode for terminal
                     transitions terminal to state used by program
@@ -733,5 +3974,21 @@
                     keypad(stdscr, TRUE);   //enable special keys
                     mousemask(ALL_MOUSE_EVENTS, NULL);
                     mouseinterval(1);
+                    nodelay(stdscr, TRUE);  //input is drained after poll
+                    KEY_CTRL_HOME = findExtendedKey("kHOM5");
+                    KEY_CTRL_END = findExtendedKey("kEND5");
+                    set_escdelay(ESCAPE_DELAY);
+                    //signals are handed to the event loop through a pipe
+                    if (0 != pipe(signal_pipe)){
+                        die("initCurses - pipe");
+                    }
+                    fcntl(signal_pipe[0], F_SETFL, O_NONBLOCK);
+                    fcntl(signal_pipe[1], F_SETFL, O_NONBLOCK);
+                    struct sigaction action;
+                    memset(&action, 0, sizeof(action));
+                    action.sa_handler = onSignal;
+                    sigemptyset(&action.sa_mask);
+                    action.sa_flags = SA_RESTART;
+                    sigaction(SIGWINCH, &action, NULL);
                 }
 //End of file
@@ -0,0 +1,256 @@
+/*////////////////////////////
+    Includes
+*/////////////////////////////
+    #define _GNU_SOURCE             //wcwidth
+    #include <string.h>
+    #include <stdlib.h>
+    #include <wchar.h>
+    #include <langinfo.h>
+    #include <ncurses.h>
+    #include "macros.h"
+    #include "metrics.h"
+    #if defined(__x86_64__) || defined(__i386__)
+        #include <immintrin.h>
+    #endif
+
+/*////////////////////////////
+    Defines
+*/////////////////////////////
+    #define UNPRINTABLE         0xff
+
+/*////////////////////////////
+    Prototypes
+*/////////////////////////////
+    //Measuring
+        static u_int64_t plainScalar(const char * text, u_int64_t offset, u_int64_t length);
+        static u_int64_t decodeChar(const u_int8_t * text, u_int64_t length, u_int32_t * codepoint);
+        static int codepointWidth(metrics_t * metrics, u_int32_t codepoint);
+
+/*////////////////////////////
+    Globals
+*/////////////////////////////
+    const char  TAB_GLYPH[] =               "        ";
+    const char  REPLACEMENT_GLYPH[] =       "\xef\xbf\xbd";
+
+/*////////////////////////////
+    Functions
+*/////////////////////////////
+    /*////////////////////////////
+        Public Functions
+    */////////////////////////////
+        /*////////////////////////////
+            Lifetime Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Metrics init
+                    follows the encoding of the locale, single bytes are drawn
+                    the way curses draws them so control bytes take two cells
+            */////////////////////////////
+                void metricsInit(metrics_t * metrics){
+                    memset(metrics, 0, sizeof(metrics_t));
+                    const char * codeset = nl_langinfo(CODESET);
+                    metrics->utf8 = (NULL != codeset) && ((0 == strcmp(codeset, "UTF-8")) || (0 == strcmp(codeset, "utf8")));
+                    for (int byte = 0; byte < 256; byte++){
+                        const char * glyph = unctrl(byte);
+                        u_int64_t width = (NULL == glyph) ? 0 : strnlen(glyph, METRICS_GLYPH - 1);
+                        if (0 == width){
+                            glyph = "?";
+                            width = 1;
+                        }
+                        memcpy(metrics->glyphs[byte], glyph, width);
+                        metrics->widths[byte] = width;
+                    }
+                }
+            /*////////////////////////////
+                Metrics release
+            */////////////////////////////
+                void metricsRelease(metrics_t * metrics){
+                    free(metrics->table);
+                }
+        /*////////////////////////////
+            Measuring Functions
+        */////////////////////////////
+#if defined(__x86_64__) || defined(__i386__)
+            /*////////////////////////////
+                Plain AVX2
+                    checks 32 bytes per step for any that is not printable
+                    ascii, those from 0x80 on compare below a space as signed
+                    returns the offset of the first, or where the steps stopped
+            */////////////////////////////
+                __attribute__((target("avx2")))
+                static u_int64_t plainAVX2(const char * text, u_int64_t length){
+                    const __m256i space = _mm256_set1_epi8(' ');
+                    const __m256i delete = _mm256_set1_epi8(0x7f);
+                    u_int64_t offset = 0;
+                    for (; offset + 32 <= length; offset += 32){
+                        __m256i chunk = _mm256_loadu_si256((const __m256i *)(text + offset));
+                        u_int32_t mask = _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpgt_epi8(space, chunk), _mm256_cmpeq_epi8(chunk, delete)));
+                        if (0 != mask){
+                            return offset + __builtin_ctz(mask);
+                        }
+                    }
+                    return offset;
+                }
+            /*////////////////////////////
+                Plain SSE2
+                    checks 16 bytes per step, as plainAVX2
+            */////////////////////////////
+                __attribute__((target("sse2")))
+                static u_int64_t plainSSE2(const char * text, u_int64_t length){
+                    const __m128i space = _mm_set1_epi8(' ');
+                    const __m128i delete = _mm_set1_epi8(0x7f);
+                    u_int64_t offset = 0;
+                    for (; offset + 16 <= length; offset += 16){
+                        __m128i chunk = _mm_loadu_si128((const __m128i *)(text + offset));
+                        u_int32_t mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmplt_epi8(chunk, space), _mm_cmpeq_epi8(chunk, delete)));
+                        if (0 != mask){
+                            return offset + __builtin_ctz(mask);
+                        }
+                    }
+                    return offset;
+                }
+#endif
+            /*////////////////////////////
+                Metrics plain
+                    measures the run of printable ascii text starts with,
+                    whose bytes are one cell each, with the widest vector
+                    unit the cpu supports
+                    returns the bytes in the run
+            */////////////////////////////
+                u_int64_t metricsPlain(const char * text, u_int64_t length){
+                    u_int64_t offset = 0;
+#if defined(__x86_64__) || defined(__i386__)
+                    if (__builtin_cpu_supports("avx2")){
+                        offset = plainAVX2(text, length);
+                    }else if (__builtin_cpu_supports("sse2")){
+                        offset = plainSSE2(text, length);
+                    }
+#endif
+                    return plainScalar(text, offset, length);
+                }
+            /*////////////////////////////
+                Metrics char
+                    decodes the character text starts with, drawn from column
+                    on, into the cells it takes and the glyph drawn for it,
+                    bytes that are not valid UTF-8 and unprintable
+                    characters are drawn as a replacement character
+                    returns the bytes it takes
+            */////////////////////////////
+                u_int64_t metricsChar(metrics_t * metrics, const char * text, u_int64_t length, u_int64_t column, u_int64_t * cells, const char ** glyph, u_int64_t * glyph_length){
+                    u_int8_t byte = text[0];
+                    if ('\t' == byte){
+                        *cells = TAB_WIDTH - column % TAB_WIDTH;
+                        *glyph = TAB_GLYPH;
+                        *glyph_length = *cells;
+                        return 1;
+                    }
+                    if ((0x80 > byte) || (!metrics->utf8)){
+                        *cells = metrics->widths[byte];
+                        *glyph = metrics->glyphs[byte];
+                        *glyph_length = *cells;
+                        return 1;
+                    }
+                    u_int32_t codepoint = 0;
+                    u_int64_t size = decodeChar((const u_int8_t *)text, length, &codepoint);
+                    int width = (0 == size) ? -1 : codepointWidth(metrics, codepoint);
+                    if (0 > width){
+                        *cells = 1;
+                        *glyph = REPLACEMENT_GLYPH;
+                        *glyph_length = sizeof(REPLACEMENT_GLYPH) - 1;
+                        return (0 == size) ? 1 : size;
+                    }
+                    *cells = width;
+                    *glyph = text;
+                    *glyph_length = size;
+                    return size;
+                }
+
+    /*////////////////////////////
+        Private Functions
+    */////////////////////////////
+        /*////////////////////////////
+            Measuring Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Plain scalar
+                    continues the run of printable ascii from offset
+                    returns the offset it ends at
+            */////////////////////////////
+                static u_int64_t plainScalar(const char * text, u_int64_t offset, u_int64_t length){
+                    for (; offset < length; offset++){
+                        u_int8_t byte = text[offset];
+                        if ((' ' > byte) || (0x7f <= byte)){
+                            break;
+                        }
+                    }
+                    return offset;
+                }
+            /*////////////////////////////
+                Decode char
+                    reads one UTF-8 sequence, rejecting overlong forms,
+                    surrogates, codepoints past U+10FFFF and sequences cut
+                    short
+                    returns its bytes, 0 when it is not valid
+            */////////////////////////////
+                static u_int64_t decodeChar(const u_int8_t * text, u_int64_t length, u_int32_t * codepoint){
+                    u_int8_t lead = text[0];
+                    u_int8_t low = 0x80;
+                    u_int8_t high = 0xbf;
+                    u_int64_t size = 0;
+                    u_int32_t value = 0;
+                    if (0xc2 > lead){
+                        return 0;
+                    }else if (0xe0 > lead){
+                        size = 2;
+                        value = lead & 0x1f;
+                    }else if (0xf0 > lead){
+                        size = 3;
+                        value = lead & 0x0f;
+                        low = (0xe0 == lead) ? 0xa0 : low;
+                        high = (0xed == lead) ? 0x9f : high;
+                    }else if (0xf5 > lead){
+                        size = 4;
+                        value = lead & 0x07;
+                        low = (0xf0 == lead) ? 0x90 : low;
+                        high = (0xf4 == lead) ? 0x8f : high;
+                    }else{
+                        return 0;
+                    }
+                    if (size > length){
+                        return 0;
+                    }
+                    for (u_int64_t iter = 1; iter < size; iter++){
+                        if ((low > text[iter]) || (high < text[iter])){
+                            return 0;
+                        }
+                        value = (value << 6) | (text[iter] & 0x3f);
+                        low = 0x80;
+                        high = 0xbf;
+                    }
+                    *codepoint = value;
+                    return size;
+                }
+            /*////////////////////////////
+                Codepoint width
+                    looks the cells of a codepoint up in a table filled from
+                    wcwidth, which curses also lays the screen out with
+                    returns -1 for unprintable codepoints
+            */////////////////////////////
+                static int codepointWidth(metrics_t * metrics, u_int32_t codepoint){
+                    if (METRICS_TABLE <= codepoint){
+                        return wcwidth(codepoint);
+                    }
+                    if (NULL == metrics->table){
+                        metrics->table = malloc(METRICS_TABLE);
+                        if (NULL == metrics->table){
+                            return wcwidth(codepoint);
+                        }
+                        for (u_int32_t iter = 0; iter < METRICS_TABLE; iter++){
+                            int width = wcwidth(iter);
+                            metrics->table[iter] = (0 > width) ? UNPRINTABLE : width;
+                        }
+                    }
+                    u_int8_t width = metrics->table[codepoint];
+                    return (UNPRINTABLE == width) ? -1 : width;
+                }
+//End of file
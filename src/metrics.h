@@ -0,0 +1,46 @@
+/*////////////////////////////
+    Guard
+*/////////////////////////////
+    #ifndef METRICS_H
+    #define METRICS_H
+
+/*////////////////////////////
+    Includes
+*/////////////////////////////
+    #include <sys/types.h>
+
+/*////////////////////////////
+    Defines
+*/////////////////////////////
+    #define METRICS_GLYPH       8
+    #define METRICS_TABLE       65536
+    #define MAX_CHAR_SIZE       4
+    #define TAB_WIDTH           8
+
+/*////////////////////////////
+    Structs
+*/////////////////////////////
+    struct metrics{
+        u_int8_t                utf8;       //text is decoded as UTF-8, otherwise every byte is a character
+        u_int8_t                widths[256];//cells each single byte character takes, tabs aside
+        char                    glyphs[256][METRICS_GLYPH];//text each single byte character is drawn as, tabs aside
+        u_int8_t *              table;      //cells of each codepoint below METRICS_TABLE, built when first needed
+    };
+
+/*////////////////////////////
+    Typedefs
+*/////////////////////////////
+    typedef struct metrics      metrics_t;
+
+/*////////////////////////////
+    Prototypes
+*/////////////////////////////
+    //Lifetime
+        void metricsInit(metrics_t * metrics);
+        void metricsRelease(metrics_t * metrics);
+    //Measuring
+        u_int64_t metricsPlain(const char * text, u_int64_t length);
+        u_int64_t metricsChar(metrics_t * metrics, const char * text, u_int64_t length, u_int64_t column, u_int64_t * cells, const char ** glyph, u_int64_t * glyph_length);
+
+    #endif
+//End of file
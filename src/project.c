@@ -0,0 +1,927 @@
+/*////////////////////////////
+    Includes
+*/////////////////////////////
+    #include <fcntl.h>
+    #include <dirent.h>
+    #include <stdio.h>
+    #include <string.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include "macros.h"
+    #include "project.h"
+
+/*////////////////////////////
+    Defines
+*/////////////////////////////
+    #define PROJECT_MAGIC       "PRJIDX01"
+    #define MAX_RECORD_PATH     65535
+    #define DIR_SAME            0
+    #define DIR_CHANGED         1
+    #define DIR_MISSING         2
+    #define MAX_SCORED_LENGTH   4096
+    #define MIN_MATCH_SLICE     65536
+
+/*////////////////////////////
+    Structs
+*/////////////////////////////
+    struct walk{
+        project_t *             project;    //receives every path found
+        int                     root_fd;    //directory the paths are relative to
+        directory_t *           known;      //directories not to descend into, sorted
+        u_int64_t               known_count;//directories in known
+        pthread_mutex_t         lock;       //guards the queue and the project
+        pthread_cond_t          wake;       //signalled when the queue changes
+        char **                 queue;      //directories waiting to be listed
+        u_int64_t               queue_count;//directories in the queue
+        u_int64_t               queue_capacity;//directories allocated
+        u_int64_t               pending;    //directories queued or being listed
+        int                     status;     //0 unless memory ran out
+    };
+    struct matcher{
+        project_t *             project;    //paths being ranked
+        const u_int8_t *        query;      //folded query
+        u_int64_t               length;     //bytes in query
+        u_int64_t               mask;       //characters every match contains
+        u_int8_t                narrow;     //scan the candidates rather than every path
+        u_int64_t               begin;      //first path or candidate in this slice
+        u_int64_t               end;        //one past the last
+        u_int64_t               kept;       //matches written back over the slice's candidates
+        int64_t *               scores;     //best scores in this slice, best first
+        u_int64_t *             results;    //paths holding those scores
+        u_int64_t               found;      //results in use
+        u_int64_t               limit;      //results allocated
+    };
+    struct header{
+        char                    magic[8];   //PROJECT_MAGIC
+        u_int64_t               dir_count;  //directory records that follow
+        u_int64_t               file_count; //file records after the directories
+    };
+    struct record{
+        u_int16_t               shared;     //bytes shared with the previous path
+        u_int16_t               suffix;     //bytes stored after this record
+    };
+
+/*////////////////////////////
+    Typedefs
+*/////////////////////////////
+    typedef struct walk         walk_t;
+    typedef struct matcher      matcher_t;
+    typedef struct header       header_t;
+    typedef struct record       record_t;
+
+/*////////////////////////////
+    Prototypes
+*/////////////////////////////
+    //Building
+        static void * projectWorker(void * argument);
+        static int projectRefresh(project_t * project, int root_fd);
+        static int projectWalk(project_t * project, int root_fd, char ** starts, u_int64_t start_count, directory_t * known, u_int64_t known_count);
+        static void * walkWorker(void * argument);
+        static int walkList(walk_t * walk, char * dir);
+        static int walkPush(walk_t * walk, char * dir);
+        static char * projectCopy(project_t * project, const char * path, u_int64_t length);
+        static int projectAddFile(project_t * project, char * path);
+        static int projectAddDir(project_t * project, char * path, struct timespec mtime);
+    //Storage
+        static int projectRead(project_t * project, int root_fd, struct timespec * written);
+        static int projectWrite(project_t * project, int root_fd);
+        static u_int64_t sharedPrefix(const char * left, const char * right);
+    //Matching
+        static void * matchRange(void * argument);
+        static u_int64_t keepBest(int64_t * scores, u_int64_t * results, u_int64_t found, u_int64_t limit, int64_t score, u_int64_t index);
+        static u_int64_t pathMask(const char * path);
+        static inline u_int8_t fold(u_int8_t input);
+        static int64_t fuzzyScore(const char * path, u_int64_t total, u_int64_t base, const u_int8_t * query, u_int64_t length);
+    //Sorting
+        static int comparePaths(const void * left, const void * right);
+        static int compareDirs(const void * left, const void * right);
+        static directory_t * findDir(directory_t * dirs, u_int64_t count, const char * path);
+
+/*////////////////////////////
+    Globals
+*/////////////////////////////
+    u_int64_t   MIN_PATH_CAPACITY =     1024;
+    u_int64_t   MIN_QUEUE_CAPACITY =    64;
+    u_int64_t   PROJECT_SIZE_HINT =     16777216;
+
+/*////////////////////////////
+    Functions
+*/////////////////////////////
+    /*////////////////////////////
+        Public Functions
+    */////////////////////////////
+        /*////////////////////////////
+            Lifetime Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Project load
+                    loads the index saved under root in the background, refreshing
+                    directories whose mtime changed, or walks the whole tree with
+                    jobs threads when there is no index yet
+                    returns 0 when loading started
+            */////////////////////////////
+                int projectLoad(project_t * project, const char * root, u_int64_t jobs){
+                    memset(project, 0, sizeof(project_t));
+                    project->root = strdup(root);
+                    if (NULL == project->root){
+                        return -1;
+                    }
+                    project->jobs = jobs;
+                    arenaInit(&project->names, PROJECT_SIZE_HINT);
+                    if (0 != pthread_create(&project->thread, NULL, projectWorker, project)){
+                        return -1;
+                    }
+                    project->started = 1;
+                    return 0;
+                }
+            /*////////////////////////////
+                Project ready
+                    returns 1 once the paths can be matched, 0 while loading
+                    and -1 when loading failed
+            */////////////////////////////
+                int projectReady(project_t * project){
+                    if (!project->started){
+                        return -1;
+                    }
+                    return __atomic_load_n(&project->state, __ATOMIC_ACQUIRE);
+                }
+            /*////////////////////////////
+                Project release
+                    waits for loading to finish and frees every path
+            */////////////////////////////
+                void projectRelease(project_t * project){
+                    if (project->started){
+                        pthread_join(project->thread, NULL);
+                    }
+                    arenaRelease(&project->names);
+                    free(project->paths);
+                    free(project->masks);
+                    free(project->lengths);
+                    free(project->bases);
+                    free(project->dirs);
+                    free(project->candidates);
+                    free(project->query);
+                    free(project->root);
+                    memset(project, 0, sizeof(project_t));
+                }
+        /*////////////////////////////
+            Matching Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Project match
+                    ranks the paths holding query as a subsequence and writes the
+                    best limit of them to results, best first
+                    a query extending the previous one only rescans its matches
+                    returns the number of results written
+            */////////////////////////////
+                u_int64_t projectMatch(project_t * project, const char * query, u_int64_t * results, u_int64_t limit){
+                    if ((1 != projectReady(project)) || (0 == limit)){
+                        return 0;
+                    }
+                    u_int64_t length = strlen(query);
+                    //nothing typed lists the paths in order
+                    if (0 == length){
+                        free(project->query);
+                        project->query = NULL;
+                        u_int64_t found = (project->count < limit) ? project->count : limit;
+                        for (u_int64_t iter = 0; iter < found; iter++){
+                            results[iter] = iter;
+                        }
+                        return found;
+                    }
+                    if (NULL == project->candidates){
+                        project->candidates = malloc((project->count + 1) * sizeof(u_int32_t));
+                        if (NULL == project->candidates){
+                            return 0;
+                        }
+                    }
+                    u_int8_t folded[length + 1];
+                    for (u_int64_t iter = 0; iter <= length; iter++){
+                        folded[iter] = fold(query[iter]);
+                    }
+                    //narrow the previous matches when the query only grew
+                    u_int8_t narrow = (NULL != project->query) && (0 == strncmp(query, project->query, strlen(project->query)));
+                    u_int64_t total = narrow ? project->candidate_count : project->count;
+                    //split the paths between the caller and jobs - 1 threads
+                    u_int64_t jobs = project->jobs;
+                    if (0 == jobs){
+                        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+                        jobs = (0 < cores) ? cores : 1;
+                    }
+                    if (jobs > total / MIN_MATCH_SLICE){
+                        jobs = (total / MIN_MATCH_SLICE) + 1;
+                    }
+                    matcher_t matchers[jobs];
+                    int64_t scores[jobs][limit];
+                    u_int64_t ranked[jobs][limit];
+                    pthread_t threads[jobs];
+                    u_int8_t started[jobs];
+                    for (u_int64_t iter = 0; iter < jobs; iter++){
+                        matchers[iter].project = project;
+                        matchers[iter].query = folded;
+                        matchers[iter].length = length;
+                        matchers[iter].mask = pathMask(query);
+                        matchers[iter].narrow = narrow;
+                        matchers[iter].begin = total * iter / jobs;
+                        matchers[iter].end = total * (iter + 1) / jobs;
+                        matchers[iter].scores = scores[iter];
+                        matchers[iter].results = ranked[iter];
+                        matchers[iter].limit = limit;
+                        started[iter] = (0 < iter) && (0 == pthread_create(&threads[iter], NULL, matchRange, &matchers[iter]));
+                    }
+                    for (u_int64_t iter = 0; iter < jobs; iter++){
+                        if (!started[iter]){
+                            matchRange(&matchers[iter]);
+                        }
+                    }
+                    //slices kept their candidates in place, close the gaps and merge the best
+                    u_int64_t kept = 0;
+                    u_int64_t found = 0;
+                    int64_t best[limit];
+                    for (u_int64_t iter = 0; iter < jobs; iter++){
+                        if (started[iter]){
+                            pthread_join(threads[iter], NULL);
+                        }
+                        memmove(project->candidates + kept, project->candidates + matchers[iter].begin, matchers[iter].kept * sizeof(u_int32_t));
+                        kept += matchers[iter].kept;
+                        for (u_int64_t rank = 0; rank < matchers[iter].found; rank++){
+                            found = keepBest(best, results, found, limit, scores[iter][rank], ranked[iter][rank]);
+                        }
+                    }
+                    project->candidate_count = kept;
+                    free(project->query);
+                    project->query = strdup(query);
+                    return found;
+                }
+            /*////////////////////////////
+                Project path
+                    returns a heap copy of a path joined to the root
+            */////////////////////////////
+                char * projectPath(project_t * project, u_int64_t index){
+                    if ((1 != projectReady(project)) || (index >= project->count)){
+                        return NULL;
+                    }
+                    u_int64_t size = strlen(project->root) + strlen(project->paths[index]) + 2;
+                    char * path = malloc(size);
+                    if (NULL != path){
+                        snprintf(path, size, "%s/%s", project->root, project->paths[index]);
+                    }
+                    return path;
+                }
+
+    /*////////////////////////////
+        Private Functions
+    */////////////////////////////
+        /*////////////////////////////
+            Building Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Project worker
+                    brings the index up to date and saves it when it changed
+            */////////////////////////////
+                static void * projectWorker(void * argument){
+                    project_t * project = argument;
+                    int state = -1;
+                    int root_fd = open(project->root, O_RDONLY | O_DIRECTORY);
+                    if (-1 != root_fd){
+                        int changed = projectRefresh(project, root_fd);
+                        if (0 <= changed){
+                            qsort(project->paths, project->count, sizeof(char *), comparePaths);
+                            qsort(project->dirs, project->dir_count, sizeof(directory_t), compareDirs);
+                            project->masks = malloc((project->count + 1) * sizeof(u_int64_t));
+                            project->lengths = malloc((project->count + 1) * sizeof(u_int16_t));
+                            project->bases = malloc((project->count + 1) * sizeof(u_int16_t));
+                            if ((NULL != project->masks) && (NULL != project->lengths) && (NULL != project->bases)){
+                                for (u_int64_t iter = 0; iter < project->count; iter++){
+                                    const char * path = project->paths[iter];
+                                    const char * slash = strrchr(path, '/');
+                                    project->masks[iter] = pathMask(path);
+                                    project->lengths[iter] = strnlen(path, MAX_RECORD_PATH);
+                                    project->bases[iter] = (NULL == slash) ? 0 : slash + 1 - path;
+                                }
+                                //a failed save only costs a walk next time
+                                if (0 < changed){
+                                    projectWrite(project, root_fd);
+                                }
+                                state = 1;
+                            }
+                        }
+                        close(root_fd);
+                    }
+                    __atomic_store_n(&project->state, state, __ATOMIC_RELEASE);
+                    return NULL;
+                }
+            /*////////////////////////////
+                Project refresh
+                    keeps saved paths under unchanged directories and relists
+                    only the directories whose mtime moved
+                    returns 1 when anything changed, 0 when nothing did and -1 on failure
+            */////////////////////////////
+                static int projectRefresh(project_t * project, int root_fd){
+                    struct timespec written;
+                    if (0 != projectRead(project, root_fd, &written)){
+                        //nothing saved, walk everything
+                        project->count = 0;
+                        project->dir_count = 0;
+                        char * root = projectCopy(project, "", 0);
+                        return ((NULL != root) && (0 == projectWalk(project, root_fd, &root, 1, NULL, 0))) ? 1 : -1;
+                    }
+                    directory_t * saved = project->dirs;
+                    u_int64_t saved_count = project->dir_count;
+                    u_int8_t * states = calloc(saved_count + 1, sizeof(u_int8_t));
+                    char ** starts = calloc(saved_count + 1, sizeof(char *));
+                    if ((NULL == states) || (NULL == starts)){
+                        free(states);
+                        free(starts);
+                        return -1;
+                    }
+                    u_int64_t start_count = 0;
+                    for (u_int64_t iter = 0; iter < saved_count; iter++){
+                        struct stat dir_stat;
+                        const char * path = ('\0' == saved[iter].path[0]) ? "." : saved[iter].path;
+                        if ((0 != fstatat(root_fd, path, &dir_stat, 0)) || (!S_ISDIR(dir_stat.st_mode))){
+                            states[iter] = DIR_MISSING;
+                        }else if ((dir_stat.st_mtim.tv_sec != saved[iter].mtime.tv_sec) || (dir_stat.st_mtim.tv_nsec != saved[iter].mtime.tv_nsec)){
+                            //saving the index touches the root, only later changes count
+                            if (('\0' == saved[iter].path[0]) && ((dir_stat.st_mtim.tv_sec < written.tv_sec) || ((dir_stat.st_mtim.tv_sec == written.tv_sec) && (dir_stat.st_mtim.tv_nsec <= written.tv_nsec)))){
+                                continue;
+                            }
+                            states[iter] = DIR_CHANGED;
+                            starts[start_count++] = saved[iter].path;
+                        }
+                    }
+                    u_int8_t missing = 0;
+                    for (u_int64_t iter = 0; iter < saved_count; iter++){
+                        missing |= (DIR_MISSING == states[iter]);
+                    }
+                    if ((0 == start_count) && (!missing)){
+                        free(states);
+                        free(starts);
+                        return 0;
+                    }
+                    //keep files whose directory is unchanged
+                    u_int64_t kept = 0;
+                    for (u_int64_t iter = 0; iter < project->count; iter++){
+                        char * path = project->paths[iter];
+                        char * slash = strrchr(path, '/');
+                        u_int64_t length = (NULL == slash) ? 0 : (u_int64_t)(slash - path);
+                        char parent[length + 1];
+                        memcpy(parent, path, length);
+                        parent[length] = '\0';
+                        directory_t * dir = findDir(saved, saved_count, parent);
+                        if ((NULL != dir) && (DIR_SAME == states[dir - saved])){
+                            project->paths[kept++] = path;
+                        }
+                    }
+                    project->count = kept;
+                    //keep unchanged directories, changed ones are listed again
+                    project->dirs = NULL;
+                    project->dir_count = 0;
+                    project->dir_capacity = 0;
+                    int status = 0;
+                    for (u_int64_t iter = 0; (0 == status) && (iter < saved_count); iter++){
+                        if (DIR_SAME == states[iter]){
+                            status = projectAddDir(project, saved[iter].path, saved[iter].mtime);
+                        }
+                    }
+                    //saved directories are not descended into again, they were checked above
+                    if (0 == status){
+                        status = projectWalk(project, root_fd, starts, start_count, saved, saved_count);
+                    }
+                    free(saved);
+                    free(states);
+                    free(starts);
+                    return (0 == status) ? 1 : -1;
+                }
+            /*////////////////////////////
+                Project walk
+                    lists the start directories in parallel, descending into
+                    every subdirectory that is not in known
+                    returns 0 on success
+            */////////////////////////////
+                static int projectWalk(project_t * project, int root_fd, char ** starts, u_int64_t start_count, directory_t * known, u_int64_t known_count){
+                    walk_t walk;
+                    memset(&walk, 0, sizeof(walk_t));
+                    walk.project = project;
+                    walk.root_fd = root_fd;
+                    walk.known = known;
+                    walk.known_count = known_count;
+                    for (u_int64_t iter = 0; iter < start_count; iter++){
+                        if (0 != walkPush(&walk, starts[iter])){
+                            free(walk.queue);
+                            return -1;
+                        }
+                    }
+                    u_int64_t jobs = project->jobs;
+                    if (0 == jobs){
+                        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+                        jobs = (0 < cores) ? cores : 1;
+                    }
+                    pthread_t threads[jobs];
+                    pthread_mutex_init(&walk.lock, NULL);
+                    pthread_cond_init(&walk.wake, NULL);
+                    u_int64_t started = 0;
+                    for (; started < jobs; started++){
+                        if (0 != pthread_create(&threads[started], NULL, walkWorker, &walk)){
+                            break;
+                        }
+                    }
+                    //the calling thread walks too, so the walk finishes even if no thread started
+                    walkWorker(&walk);
+                    for (u_int64_t iter = 0; iter < started; iter++){
+                        pthread_join(threads[iter], NULL);
+                    }
+                    pthread_mutex_destroy(&walk.lock);
+                    pthread_cond_destroy(&walk.wake);
+                    free(walk.queue);
+                    return walk.status;
+                }
+            /*////////////////////////////
+                Walk worker
+                    lists queued directories until the queue is empty and no
+                    other worker can add to it
+            */////////////////////////////
+                static void * walkWorker(void * argument){
+                    walk_t * walk = argument;
+                    pthread_mutex_lock(&walk->lock);
+                    for(;;){
+                        while ((0 == walk->queue_count) && (0 < walk->pending)){
+                            pthread_cond_wait(&walk->wake, &walk->lock);
+                        }
+                        if (0 == walk->queue_count){
+                            break;
+                        }
+                        char * dir = walk->queue[--walk->queue_count];
+                        pthread_mutex_unlock(&walk->lock);
+                        int status = walkList(walk, dir);
+                        pthread_mutex_lock(&walk->lock);
+                        if (0 != status){
+                            walk->status = -1;
+                        }
+                        walk->pending--;
+                        pthread_cond_broadcast(&walk->wake);
+                    }
+                    pthread_mutex_unlock(&walk->lock);
+                    return NULL;
+                }
+            /*////////////////////////////
+                Walk list
+                    reads one directory without the lock, then records its files
+                    and queues its subdirectories in one locked step
+                    hidden directories and the index file are skipped
+                    returns 0 on success
+            */////////////////////////////
+                static int walkList(walk_t * walk, char * dir){
+                    int fd = openat(walk->root_fd, ('\0' == dir[0]) ? "." : dir, O_RDONLY | O_DIRECTORY);
+                    if (-1 == fd){
+                        return 0;
+                    }
+                    struct stat dir_stat;
+                    DIR * stream = fdopendir(fd);
+                    if ((NULL == stream) || (0 != fstat(fd, &dir_stat))){
+                        if (NULL != stream){
+                            closedir(stream);
+                        }else{
+                            close(fd);
+                        }
+                        return 0;
+                    }
+                    //children are gathered locally so the lock is taken once
+                    arena_t local;
+                    arenaInit(&local, 0);
+                    char ** files = NULL;
+                    char ** dirs = NULL;
+                    u_int64_t file_count = 0;
+                    u_int64_t dir_count = 0;
+                    u_int64_t file_capacity = 0;
+                    u_int64_t dir_capacity = 0;
+                    u_int64_t dir_length = strlen(dir);
+                    int status = 0;
+                    struct dirent * entry;
+                    while ((0 == status) && (NULL != (entry = readdir(stream)))){
+                        const char * name = entry->d_name;
+                        //the index and the temporary copies being written of it
+                        if ((0 == strcmp(name, ".")) || (0 == strcmp(name, "..")) || (0 == strncmp(name, PROJECT_INDEX_FILE, sizeof(PROJECT_INDEX_FILE) - 1))){
+                            continue;
+                        }
+                        u_int8_t is_dir = (DT_DIR == entry->d_type);
+                        u_int8_t is_file = (DT_REG == entry->d_type);
+                        //links to directories are not followed so the walk cannot loop
+                        if ((DT_UNKNOWN == entry->d_type) || (DT_LNK == entry->d_type)){
+                            struct stat entry_stat;
+                            if (0 == fstatat(fd, name, &entry_stat, 0)){
+                                is_file = S_ISREG(entry_stat.st_mode);
+                                is_dir = (DT_UNKNOWN == entry->d_type) && S_ISDIR(entry_stat.st_mode);
+                            }
+                        }
+                        if ((!is_file) && ((!is_dir) || ('.' == name[0]))){
+                            continue;
+                        }
+                        u_int64_t name_length = strlen(name);
+                        u_int64_t length = (0 == dir_length) ? name_length : dir_length + 1 + name_length;
+                        char * path = arenaAlloc(&local, length + 1);
+                        char *** list = is_dir ? &dirs : &files;
+                        u_int64_t * count = is_dir ? &dir_count : &file_count;
+                        u_int64_t * capacity = is_dir ? &dir_capacity : &file_capacity;
+                        if (*count == *capacity){
+                            *capacity = growCapacity(*capacity, *count + 1, MIN_QUEUE_CAPACITY);
+                            char ** grown = realloc(*list, *capacity * sizeof(char *));
+                            if (NULL == grown){
+                                status = -1;
+                                break;
+                            }
+                            *list = grown;
+                        }
+                        if (NULL == path){
+                            status = -1;
+                            break;
+                        }
+                        if (0 == dir_length){
+                            memcpy(path, name, name_length + 1);
+                        }else{
+                            memcpy(path, dir, dir_length);
+                            path[dir_length] = '/';
+                            memcpy(path + dir_length + 1, name, name_length + 1);
+                        }
+                        (*list)[(*count)++] = path;
+                    }
+                    closedir(stream);
+                    pthread_mutex_lock(&walk->lock);
+                    project_t * project = walk->project;
+                    for (u_int64_t iter = 0; (0 == status) && (iter < file_count); iter++){
+                        char * path = projectCopy(project, files[iter], strlen(files[iter]));
+                        status = (NULL == path) ? -1 : projectAddFile(project, path);
+                    }
+                    if (0 == status){
+                        status = projectAddDir(project, dir, dir_stat.st_mtim);
+                    }
+                    for (u_int64_t iter = 0; (0 == status) && (iter < dir_count); iter++){
+                        if (NULL != findDir(walk->known, walk->known_count, dirs[iter])){
+                            continue;
+                        }
+                        char * path = projectCopy(project, dirs[iter], strlen(dirs[iter]));
+                        status = (NULL == path) ? -1 : walkPush(walk, path);
+                    }
+                    pthread_cond_broadcast(&walk->wake);
+                    pthread_mutex_unlock(&walk->lock);
+                    arenaRelease(&local);
+                    free(files);
+                    free(dirs);
+                    return status;
+                }
+            /*////////////////////////////
+                Walk push
+                    queues a directory, the lock must be held once workers run
+                    returns 0 on success
+            */////////////////////////////
+                static int walkPush(walk_t * walk, char * dir){
+                    if (walk->queue_count == walk->queue_capacity){
+                        u_int64_t capacity = growCapacity(walk->queue_capacity, walk->queue_count + 1, MIN_QUEUE_CAPACITY);
+                        char ** queue = realloc(walk->queue, capacity * sizeof(char *));
+                        if (NULL == queue){
+                            return -1;
+                        }
+                        walk->queue = queue;
+                        walk->queue_capacity = capacity;
+                    }
+                    walk->queue[walk->queue_count++] = dir;
+                    walk->pending++;
+                    return 0;
+                }
+            /*////////////////////////////
+                Project copy
+                    copies a path into the project's name storage, followed
+                    by a case folded copy for matching
+            */////////////////////////////
+                static char * projectCopy(project_t * project, const char * path, u_int64_t length){
+                    char * copy = arenaAlloc(&project->names, 2 * (length + 1));
+                    if (NULL != copy){
+                        memcpy(copy, path, length);
+                        copy[length] = '\0';
+                        for (u_int64_t iter = 0; iter < length; iter++){
+                            copy[length + 1 + iter] = fold(path[iter]);
+                        }
+                        copy[2 * length + 1] = '\0';
+                    }
+                    return copy;
+                }
+            /*////////////////////////////
+                Project add file
+                    returns 0 on success
+            */////////////////////////////
+                static int projectAddFile(project_t * project, char * path){
+                    if (project->count == project->capacity){
+                        u_int64_t capacity = growCapacity(project->capacity, project->count + 1, MIN_PATH_CAPACITY);
+                        char ** paths = realloc(project->paths, capacity * sizeof(char *));
+                        if (NULL == paths){
+                            return -1;
+                        }
+                        project->paths = paths;
+                        project->capacity = capacity;
+                    }
+                    project->paths[project->count++] = path;
+                    return 0;
+                }
+            /*////////////////////////////
+                Project add dir
+                    returns 0 on success
+            */////////////////////////////
+                static int projectAddDir(project_t * project, char * path, struct timespec mtime){
+                    if (project->dir_count == project->dir_capacity){
+                        u_int64_t capacity = growCapacity(project->dir_capacity, project->dir_count + 1, MIN_PATH_CAPACITY);
+                        directory_t * dirs = realloc(project->dirs, capacity * sizeof(directory_t));
+                        if (NULL == dirs){
+                            return -1;
+                        }
+                        project->dirs = dirs;
+                        project->dir_capacity = capacity;
+                    }
+                    project->dirs[project->dir_count].path = path;
+                    project->dirs[project->dir_count].mtime = mtime;
+                    project->dir_count++;
+                    return 0;
+                }
+        /*////////////////////////////
+            Storage Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Project read
+                    maps the saved index and decodes its prefix compressed
+                    records, directories first and then files, both sorted
+                    written receives when the index was renamed into place
+                    returns 0 on success
+            */////////////////////////////
+                static int projectRead(project_t * project, int root_fd, struct timespec * written){
+                    int fd = openat(root_fd, PROJECT_INDEX_FILE, O_RDONLY);
+                    if (-1 == fd){
+                        return -1;
+                    }
+                    struct stat file_stat;
+                    if ((0 != fstat(fd, &file_stat)) || ((u_int64_t)file_stat.st_size < sizeof(header_t))){
+                        close(fd);
+                        return -1;
+                    }
+                    u_int64_t size = file_stat.st_size;
+                    *written = file_stat.st_ctim;
+                    char * data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+                    close(fd);
+                    if (MAP_FAILED == data){
+                        return -1;
+                    }
+                    madvise(data, size, MADV_SEQUENTIAL);
+                    header_t header;
+                    memcpy(&header, data, sizeof(header_t));
+                    int status = (0 == memcmp(header.magic, PROJECT_MAGIC, sizeof(header.magic))) ? 0 : -1;
+                    char previous[MAX_RECORD_PATH + 1];
+                    u_int64_t previous_length = 0;
+                    u_int64_t offset = sizeof(header_t);
+                    u_int64_t records = header.dir_count + header.file_count;
+                    for (u_int64_t iter = 0; (0 == status) && (iter < records); iter++){
+                        if (iter == header.dir_count){
+                            previous_length = 0;
+                        }
+                        record_t record;
+                        struct timespec mtime = {0, 0};
+                        u_int64_t fixed = sizeof(record_t) + ((iter < header.dir_count) ? 2 * sizeof(int64_t) : 0);
+                        if (offset + fixed > size){
+                            status = -1;
+                            break;
+                        }
+                        memcpy(&record, data + offset, sizeof(record_t));
+                        if (iter < header.dir_count){
+                            int64_t times[2];
+                            memcpy(times, data + offset + sizeof(record_t), sizeof(times));
+                            mtime.tv_sec = times[0];
+                            mtime.tv_nsec = times[1];
+                        }
+                        offset += fixed;
+                        if ((record.shared > previous_length) || (offset + record.suffix > size) || ((u_int64_t)record.shared + record.suffix > MAX_RECORD_PATH)){
+                            status = -1;
+                            break;
+                        }
+                        memcpy(previous + record.shared, data + offset, record.suffix);
+                        offset += record.suffix;
+                        previous_length = record.shared + record.suffix;
+                        char * path = projectCopy(project, previous, previous_length);
+                        if (NULL == path){
+                            status = -1;
+                        }else if (iter < header.dir_count){
+                            status = projectAddDir(project, path, mtime);
+                        }else{
+                            status = projectAddFile(project, path);
+                        }
+                    }
+                    munmap(data, size);
+                    return status;
+                }
+            /*////////////////////////////
+                Project write
+                    saves the sorted index under a unique temporary name and
+                    renames it into place so readers never see half an index,
+                    and editors saving the same tree at once never share one
+                    returns 0 on success
+            */////////////////////////////
+                static int projectWrite(project_t * project, int root_fd){
+                    u_int64_t size = strlen(project->root) + sizeof(PROJECT_INDEX_FILE) + 8;
+                    char temporary[size];
+                    snprintf(temporary, size, "%s/%s.XXXXXX", project->root, PROJECT_INDEX_FILE);
+                    int fd = mkstemp(temporary);
+                    if (-1 == fd){
+                        return -1;
+                    }
+                    fchmod(fd, 0644);
+                    FILE * file = fdopen(fd, "wb");
+                    if (NULL == file){
+                        close(fd);
+                        unlink(temporary);
+                        return -1;
+                    }
+                    header_t header;
+                    memcpy(header.magic, PROJECT_MAGIC, sizeof(header.magic));
+                    header.dir_count = project->dir_count;
+                    header.file_count = project->count;
+                    int status = (1 == fwrite(&header, sizeof(header_t), 1, file)) ? 0 : -1;
+                    const char * previous = "";
+                    for (u_int64_t iter = 0; (0 == status) && (iter < project->dir_count + project->count); iter++){
+                        u_int8_t is_dir = (iter < project->dir_count);
+                        const char * path = is_dir ? project->dirs[iter].path : project->paths[iter - project->dir_count];
+                        if (iter == project->dir_count){
+                            previous = "";
+                        }
+                        u_int64_t length = strlen(path);
+                        if (MAX_RECORD_PATH < length){
+                            continue;
+                        }
+                        record_t record;
+                        record.shared = sharedPrefix(previous, path);
+                        record.suffix = length - record.shared;
+                        status = (1 == fwrite(&record, sizeof(record_t), 1, file)) ? 0 : -1;
+                        if ((0 == status) && (is_dir)){
+                            int64_t times[2] = {project->dirs[iter].mtime.tv_sec, project->dirs[iter].mtime.tv_nsec};
+                            status = (1 == fwrite(times, sizeof(times), 1, file)) ? 0 : -1;
+                        }
+                        if ((0 == status) && (0 < record.suffix)){
+                            status = (1 == fwrite(path + record.shared, record.suffix, 1, file)) ? 0 : -1;
+                        }
+                        previous = path;
+                    }
+                    if (0 != fclose(file)){
+                        status = -1;
+                    }
+                    if ((0 != status) || (0 != renameat(AT_FDCWD, temporary, root_fd, PROJECT_INDEX_FILE))){
+                        unlink(temporary);
+                        return -1;
+                    }
+                    return 0;
+                }
+            /*////////////////////////////
+                Shared prefix
+                    returns the bytes two paths start with in common
+            */////////////////////////////
+                static u_int64_t sharedPrefix(const char * left, const char * right){
+                    u_int64_t length = 0;
+                    while (('\0' != left[length]) && (left[length] == right[length])){
+                        length++;
+                    }
+                    return length;
+                }
+        /*////////////////////////////
+            Matching Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Match range
+                    scores one slice of the paths, keeping its best results and
+                    writing its matches over the start of its candidates
+            */////////////////////////////
+                static void * matchRange(void * argument){
+                    matcher_t * matcher = argument;
+                    project_t * project = matcher->project;
+                    u_int32_t * candidates = project->candidates;
+                    u_int64_t kept = matcher->begin;
+                    matcher->found = 0;
+                    for (u_int64_t iter = matcher->begin; iter < matcher->end; iter++){
+                        u_int64_t index = matcher->narrow ? candidates[iter] : iter;
+                        if ((project->masks[index] & matcher->mask) != matcher->mask){
+                            continue;
+                        }
+                        const char * folded = project->paths[index] + project->lengths[index] + 1;
+                        int64_t score = fuzzyScore(folded, project->lengths[index], project->bases[index], matcher->query, matcher->length);
+                        if (0 > score){
+                            continue;
+                        }
+                        candidates[kept++] = index;
+                        matcher->found = keepBest(matcher->scores, matcher->results, matcher->found, matcher->limit, score, index);
+                    }
+                    matcher->kept = kept - matcher->begin;
+                    return NULL;
+                }
+            /*////////////////////////////
+                Keep best
+                    inserts a result into a list sorted best first, earlier
+                    results winning ties
+                    returns the results now in the list
+            */////////////////////////////
+                static u_int64_t keepBest(int64_t * scores, u_int64_t * results, u_int64_t found, u_int64_t limit, int64_t score, u_int64_t index){
+                    if ((found == limit) && (score <= scores[found - 1])){
+                        return found;
+                    }
+                    u_int64_t slot = (found < limit) ? found++ : found - 1;
+                    while ((0 < slot) && (scores[slot - 1] < score)){
+                        scores[slot] = scores[slot - 1];
+                        results[slot] = results[slot - 1];
+                        slot--;
+                    }
+                    scores[slot] = score;
+                    results[slot] = index;
+                    return found;
+                }
+            /*////////////////////////////
+                Fold
+                    lower cases ascii letters, leaving other bytes alone
+            */////////////////////////////
+                static inline u_int8_t fold(u_int8_t input){
+                    return input | (((u_int8_t)(input - 'A') < 26) << 5);
+                }
+            /*////////////////////////////
+                Path mask
+                    one bit per letter and digit, the rest sharing the high
+                    bits, so most paths are rejected before they are scored
+            */////////////////////////////
+                static u_int64_t pathMask(const char * path){
+                    u_int64_t mask = 0;
+                    for (; '\0' != *path; path++){
+                        u_int8_t input = fold(*path);
+                        u_int64_t bit = ((u_int8_t)(input - 'a') < 26) ? input - 'a' : ((u_int8_t)(input - '0') < 10) ? 26 + input - '0' : 36 + input % 28;
+                        mask |= (u_int64_t)1 << bit;
+                    }
+                    return mask;
+                }
+            /*////////////////////////////
+                Fuzzy score
+                    matches a folded query as a subsequence of a folded path, rewarding
+                    runs, word starts and the file name over the directories
+                    total and base are the path's length and where its file name starts
+                    returns -1 when query is not a subsequence
+            */////////////////////////////
+                static int64_t fuzzyScore(const char * path, u_int64_t total, u_int64_t base, const u_int8_t * query, u_int64_t length){
+                    const char * hits[length + 1];
+                    const char * curr = path;
+                    int64_t score = 0;
+                    for (u_int64_t iter = 0; iter < length; iter++){
+                        curr = strchr(curr, query[iter]);
+                        if (NULL == curr){
+                            return -1;
+                        }
+                        score += 1;
+                        if ((0 < iter) && (curr == hits[iter - 1] + 1)){
+                            score += 4;
+                        }
+                        if ((curr == path) || ('/' == curr[-1]) || ('_' == curr[-1]) || ('-' == curr[-1]) || ('.' == curr[-1]) || (' ' == curr[-1])){
+                            score += 6;
+                        }
+                        hits[iter] = curr++;
+                    }
+                    for (u_int64_t iter = length; (0 < iter) && (hits[iter - 1] >= path + base); iter--){
+                        score += 2;
+                    }
+                    //shorter paths win ties
+                    return score * MAX_SCORED_LENGTH + MAX_SCORED_LENGTH - 1 - ((total < MAX_SCORED_LENGTH) ? total : MAX_SCORED_LENGTH - 1);
+                }
+        /*////////////////////////////
+            Sorting Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Compare paths
+            */////////////////////////////
+                static int comparePaths(const void * left, const void * right){
+                    return strcmp(*(char * const *)left, *(char * const *)right);
+                }
+            /*////////////////////////////
+                Compare dirs
+            */////////////////////////////
+                static int compareDirs(const void * left, const void * right){
+                    return strcmp(((const directory_t *)left)->path, ((const directory_t *)right)->path);
+                }
+            /*////////////////////////////
+                Find dir
+                    binary search of a sorted directory list
+            */////////////////////////////
+                static directory_t * findDir(directory_t * dirs, u_int64_t count, const char * path){
+                    u_int64_t low = 0;
+                    u_int64_t high = count;
+                    while (low < high){
+                        u_int64_t mid = low + (high - low) / 2;
+                        int order = strcmp(dirs[mid].path, path);
+                        if (0 == order){
+                            return &dirs[mid];
+                        }
+                        if (0 > order){
+                            low = mid + 1;
+                        }else{
+                            high = mid;
+                        }
+                    }
+                    return NULL;
+                }
+//End of file
@@ -0,0 +1,66 @@
+/*////////////////////////////
+    Guard
+*/////////////////////////////
+    #ifndef PROJECT_H
+    #define PROJECT_H
+
+/*////////////////////////////
+    Includes
+*/////////////////////////////
+    #include <time.h>
+    #include <pthread.h>
+    #include <sys/types.h>
+    #include "arena.h"
+
+/*////////////////////////////
+    Defines
+*/////////////////////////////
+    #define PROJECT_INDEX_FILE  ".projectindex"
+
+/*////////////////////////////
+    Structs
+*/////////////////////////////
+    struct directory{
+        char *                  path;       //relative to the root, empty for the root
+        struct timespec         mtime;      //mtime when it was listed
+    };
+    struct project{
+        char *                  root;       //directory the paths are relative to
+        char **                 paths;      //sorted relative file paths
+        u_int64_t *             masks;      //characters present in each path
+        u_int16_t *             lengths;    //bytes in each path
+        u_int16_t *             bases;      //where each path's file name starts
+        u_int64_t               count;      //paths in use
+        u_int64_t               capacity;   //paths allocated
+        struct directory *      dirs;       //sorted directories with their mtimes
+        u_int64_t               dir_count;  //directories in use
+        u_int64_t               dir_capacity;//directories allocated
+        struct arena            names;      //storage for every path
+        u_int64_t               jobs;       //walker threads, 0 for one per core
+        pthread_t               thread;     //loads, refreshes and saves the index
+        u_int8_t                started;    //thread was started
+        int                     state;      //0 while loading, 1 when ready, -1 on failure, set atomically
+        u_int32_t *             candidates; //paths matching the last query
+        u_int64_t               candidate_count;//candidates in use
+        char *                  query;      //last query, candidates narrow while it is extended
+    };
+
+/*////////////////////////////
+    Typedefs
+*/////////////////////////////
+    typedef struct directory    directory_t;
+    typedef struct project      project_t;
+
+/*////////////////////////////
+    Prototypes
+*/////////////////////////////
+    //Lifetime
+        int projectLoad(project_t * project, const char * root, u_int64_t jobs);
+        int projectReady(project_t * project);
+        void projectRelease(project_t * project);
+    //Matching
+        u_int64_t projectMatch(project_t * project, const char * query, u_int64_t * results, u_int64_t limit);
+        char * projectPath(project_t * project, u_int64_t index);
+
+    #endif
+//End of file
@@ -0,0 +1,219 @@
+/*////////////////////////////
+    Includes
+*/////////////////////////////
+    #include <string.h>
+    #include <stdlib.h>
+    #include "macros.h"
+    #include "recording.h"
+
+/*////////////////////////////
+    Defines
+*/////////////////////////////
+    #define RECORD_BATCH        0x80
+
+/*////////////////////////////
+    Prototypes
+*/////////////////////////////
+    //Encoding
+        static void writeNumber(FILE * file, u_int64_t value);
+        static void writeSigned(FILE * file, int64_t value);
+        static int readNumber(FILE * file, u_int64_t * value);
+        static int readSigned(FILE * file, int64_t * value);
+
+/*////////////////////////////
+    Functions
+*/////////////////////////////
+    /*////////////////////////////
+        Public Functions
+    */////////////////////////////
+        /*////////////////////////////
+            Lifetime Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Recording create
+                    starts a new recording at path, now being monotonic ns
+                    returns 0 on success
+            */////////////////////////////
+                int recordingCreate(recording_t * recording, const char * path, u_int64_t now){
+                    memset(recording, 0, sizeof(recording_t));
+                    recording->file = fopen(path, "wb");
+                    if (NULL == recording->file){
+                        return -1;
+                    }
+                    recording->started = now;
+                    if (1 != fwrite(RECORDING_MAGIC, RECORDING_MAGIC_SIZE, 1, recording->file)){
+                        recordingClose(recording);
+                        return -1;
+                    }
+                    return 0;
+                }
+            /*////////////////////////////
+                Recording open
+                    opens a recording at path for reading
+                    returns 0 on success
+            */////////////////////////////
+                int recordingOpen(recording_t * recording, const char * path){
+                    memset(recording, 0, sizeof(recording_t));
+                    recording->file = fopen(path, "rb");
+                    if (NULL == recording->file){
+                        return -1;
+                    }
+                    char magic[RECORDING_MAGIC_SIZE];
+                    if ((1 != fread(magic, RECORDING_MAGIC_SIZE, 1, recording->file)) || (0 != memcmp(magic, RECORDING_MAGIC, RECORDING_MAGIC_SIZE))){
+                        recordingClose(recording);
+                        return -1;
+                    }
+                    return 0;
+                }
+            /*////////////////////////////
+                Recording close
+                    returns 0 when everything written reached the file
+            */////////////////////////////
+                int recordingClose(recording_t * recording){
+                    int status = 0;
+                    if (NULL != recording->file){
+                        status = ferror(recording->file) ? -1 : 0;
+                        if (0 != fclose(recording->file)){
+                            status = -1;
+                        }
+                        recording->file = NULL;
+                    }
+                    return status;
+                }
+        /*////////////////////////////
+            Event Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Recording write
+                    appends record stamped with now, monotonic ns, as a kind
+                    byte, the microseconds since the previous event and the
+                    fields of its kind, all variable length
+                    returns 0 on success
+            */////////////////////////////
+                int recordingWrite(recording_t * recording, record_t * record, u_int64_t now){
+                    u_int64_t time = (now - recording->started) / 1000;
+                    if (time < recording->time){
+                        time = recording->time;
+                    }
+                    record->time = time;
+                    fputc(record->kind | (record->batch ? RECORD_BATCH : 0), recording->file);
+                    writeNumber(recording->file, time - recording->time);
+                    switch (record->kind){
+                        case RECORD_KEY:
+                            writeSigned(recording->file, record->key);
+                        break;
+                        case RECORD_MOUSE:
+                            writeSigned(recording->file, record->x);
+                            writeSigned(recording->file, record->y);
+                            writeNumber(recording->file, record->bstate);
+                        break;
+                        case RECORD_RESIZE:
+                            writeSigned(recording->file, record->x);
+                            writeSigned(recording->file, record->y);
+                        break;
+                    }
+                    recording->time = time;
+                    recording->events++;
+                    return ferror(recording->file) ? -1 : 0;
+                }
+            /*////////////////////////////
+                Recording read
+                    reads the next record
+                    returns 1 when one was read, 0 at the end, -1 when the
+                    recording is malformed
+            */////////////////////////////
+                int recordingRead(recording_t * recording, record_t * record){
+                    int head = fgetc(recording->file);
+                    if (EOF == head){
+                        return 0;
+                    }
+                    memset(record, 0, sizeof(record_t));
+                    record->kind = head & ~RECORD_BATCH;
+                    record->batch = (0 != (head & RECORD_BATCH));
+                    u_int64_t delta = 0;
+                    if (0 != readNumber(recording->file, &delta)){
+                        return -1;
+                    }
+                    int status = 0;
+                    switch (record->kind){
+                        case RECORD_KEY:
+                            status = readSigned(recording->file, &record->key);
+                        break;
+                        case RECORD_MOUSE:
+                            status |= readSigned(recording->file, &record->x);
+                            status |= readSigned(recording->file, &record->y);
+                            status |= readNumber(recording->file, &record->bstate);
+                        break;
+                        case RECORD_RESIZE:
+                            status |= readSigned(recording->file, &record->x);
+                            status |= readSigned(recording->file, &record->y);
+                        break;
+                        default:
+                            return -1;
+                        break;
+                    }
+                    if (0 != status){
+                        return -1;
+                    }
+                    recording->time += delta;
+                    record->time = recording->time;
+                    recording->events++;
+                    return 1;
+                }
+
+    /*////////////////////////////
+        Private Functions
+    */////////////////////////////
+        /*////////////////////////////
+            Encoding Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Write number
+                    seven bits per byte, low bits first, the high bit set on
+                    every byte but the last
+            */////////////////////////////
+                static void writeNumber(FILE * file, u_int64_t value){
+                    while (0x80 <= value){
+                        fputc((value & 0x7f) | 0x80, file);
+                        value >>= 7;
+                    }
+                    fputc(value, file);
+                }
+            /*////////////////////////////
+                Write signed
+                    zigzag encodes value so small negatives stay short
+            */////////////////////////////
+                static void writeSigned(FILE * file, int64_t value){
+                    writeNumber(file, ((u_int64_t)value << 1) ^ (u_int64_t)(value >> 63));
+                }
+            /*////////////////////////////
+                Read number
+                    returns 0 on success
+            */////////////////////////////
+                static int readNumber(FILE * file, u_int64_t * value){
+                    *value = 0;
+                    for (u_int64_t shift = 0; shift < 64; shift += 7){
+                        int byte = fgetc(file);
+                        if (EOF == byte){
+                            return -1;
+                        }
+                        *value |= (u_int64_t)(byte & 0x7f) << shift;
+                        if (0 == (byte & 0x80)){
+                            return 0;
+                        }
+                    }
+                    return -1;
+                }
+            /*////////////////////////////
+                Read signed
+                    returns 0 on success
+            */////////////////////////////
+                static int readSigned(FILE * file, int64_t * value){
+                    u_int64_t encoded = 0;
+                    if (0 != readNumber(file, &encoded)){
+                        return -1;
+                    }
+                    *value = (int64_t)(encoded >> 1) ^ -(int64_t)(encoded & 1);
+                    return 0;
+                }
+//End of file
@@ -0,0 +1,59 @@
+/*////////////////////////////
+    Guard
+*/////////////////////////////
+    #ifndef RECORDING_H
+    #define RECORDING_H
+
+/*////////////////////////////
+    Includes
+*/////////////////////////////
+    #include <stdio.h>
+    #include <sys/types.h>
+
+/*////////////////////////////
+    Defines
+*/////////////////////////////
+    #define RECORD_KEY          0
+    #define RECORD_MOUSE        1
+    #define RECORD_RESIZE       2
+    #define RECORDING_MAGIC     "CLIEREC1"
+    #define RECORDING_MAGIC_SIZE 8
+
+/*////////////////////////////
+    Structs
+*/////////////////////////////
+    struct record{
+        u_int8_t                kind;       //RECORD_KEY, RECORD_MOUSE or RECORD_RESIZE
+        u_int8_t                batch;      //first event of an input batch
+        u_int64_t               time;       //microseconds since the recording began
+        int64_t                 key;        //key code of keys and mouse events
+        int64_t                 x;          //mouse column, or terminal columns of a resize
+        int64_t                 y;          //mouse row, or terminal rows of a resize
+        u_int64_t               bstate;     //mouse buttons
+    };
+    struct recording{
+        FILE *                  file;       //recording being written or read, NULL when closed
+        u_int64_t               started;    //monotonic ns the recording began, when writing
+        u_int64_t               time;       //microseconds of the newest event
+        u_int64_t               events;     //events written or read
+    };
+
+/*////////////////////////////
+    Typedefs
+*/////////////////////////////
+    typedef struct record       record_t;
+    typedef struct recording    recording_t;
+
+/*////////////////////////////
+    Prototypes
+*/////////////////////////////
+    //Lifetime
+        int recordingCreate(recording_t * recording, const char * path, u_int64_t now);
+        int recordingOpen(recording_t * recording, const char * path);
+        int recordingClose(recording_t * recording);
+    //Events
+        int recordingWrite(recording_t * recording, record_t * record, u_int64_t now);
+        int recordingRead(recording_t * recording, record_t * record);
+
+    #endif
+//End of file
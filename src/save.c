@@ -0,0 +1,289 @@
+/*////////////////////////////
+    Includes
+*/////////////////////////////
+    #include <errno.h>
+    #include <fcntl.h>
+    #include <limits.h>
+    #include <stdio.h>
+    #include <string.h>
+    #include <unistd.h>
+    #include <sys/stat.h>
+    #include <sys/uio.h>
+    #ifdef __linux__
+        #include <sys/syscall.h>
+    #endif
+    #include "macros.h"
+    #include "save.h"
+
+/*////////////////////////////
+    Defines
+*/////////////////////////////
+    #define MAX_IOVECS          1024
+
+/*////////////////////////////
+    Structs
+*/////////////////////////////
+    struct writer{
+        int                     fd;         //temporary file being written
+        int                     source_fd;  //file the original was mapped from, -1 when there is none
+        u_int8_t                copy;       //copy_file_range still works between the two
+        struct iovec            iov[MAX_IOVECS];//pieces waiting for writev
+        u_int64_t               iov_count;  //iovecs in use
+    };
+
+/*////////////////////////////
+    Typedefs
+*/////////////////////////////
+    typedef struct writer       writer_t;
+
+/*////////////////////////////
+    Prototypes
+*/////////////////////////////
+    //Writing
+        static int saveVisit(void * context, u_int8_t source, const char * data, u_int64_t start, u_int64_t length);
+        static int writerFlush(writer_t * writer);
+        static u_int64_t writerCopy(writer_t * writer, u_int64_t start, u_int64_t length);
+    //Paths
+        static char * temporaryPath(const char * path);
+        static int syncDirectory(const char * path);
+
+/*////////////////////////////
+    Globals
+*/////////////////////////////
+    u_int64_t   MIN_COPY_SIZE =         65536;
+
+/*////////////////////////////
+    Functions
+*/////////////////////////////
+    /*////////////////////////////
+        Public Functions
+    */////////////////////////////
+        /*////////////////////////////
+            Saving Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Save buffer
+                    writes the buffer to a temporary file beside path and renames
+                    it over path, so a crash leaves either the old or new file
+                    added text is gathered with writev straight from the pieces and
+                    large unchanged runs are copied from source_fd inside the kernel
+                    sync is SYNC_NONE, SYNC_DATA to flush the file or SYNC_FULL to
+                    also flush the rename
+                    returns 0 on success
+            */////////////////////////////
+                int saveBuffer(buffer_t * buffer, const char * path, int source_fd, int sync){
+                    //save through symlinks rather than replacing them
+                    char * target = realpath(path, NULL);
+                    if (NULL == target){
+                        target = strdup(path);
+                        if (NULL == target){
+                            return -1;
+                        }
+                    }
+                    char * temporary = temporaryPath(target);
+                    int fd = (NULL == temporary) ? -1 : mkstemp(temporary);
+                    if (-1 == fd){
+                        free(temporary);
+                        free(target);
+                        return -1;
+                    }
+                    //keep the permissions of the file being replaced
+                    struct stat file_stat;
+                    fchmod(fd, (0 == stat(target, &file_stat)) ? (file_stat.st_mode & 07777) : 0644);
+                    writer_t writer;
+                    writer.fd = fd;
+                    writer.source_fd = source_fd;
+                    writer.copy = (-1 != source_fd);
+                    writer.iov_count = 0;
+                    int status = bufferWalk(buffer, saveVisit, &writer);
+                    if (0 == status){
+                        status = writerFlush(&writer);
+                    }
+                    if ((0 == status) && (SYNC_DATA == sync)){
+                        status = fdatasync(fd);
+                    }else if ((0 == status) && (SYNC_FULL == sync)){
+                        status = fsync(fd);
+                    }
+                    if (0 != close(fd)){
+                        status = -1;
+                    }
+                    if ((0 != status) || (0 != rename(temporary, target))){
+                        unlink(temporary);
+                        status = -1;
+                    }
+                    //the rename is only durable once the directory is flushed
+                    if ((0 == status) && (SYNC_FULL == sync)){
+                        status = syncDirectory(target);
+                    }
+                    free(temporary);
+                    free(target);
+                    return status;
+                }
+        /*////////////////////////////
+            Scratch Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Save scratch
+                    opens an unlinked temporary file named after prefix in
+                    TMPDIR, or /tmp when it is not set, for data that never
+                    outlives the editor
+                    returns its descriptor, -1 on failure
+            */////////////////////////////
+                int saveScratch(const char * prefix){
+                    const char * dir = getenv("TMPDIR");
+                    if ((NULL == dir) || ('\0' == dir[0])){
+                        dir = "/tmp";
+                    }
+                    u_int64_t size = strlen(dir) + strlen(prefix) + 8;
+                    char path[size];
+                    snprintf(path, size, "%s/%sXXXXXX", dir, prefix);
+                    int fd = mkstemp(path);
+                    if (-1 != fd){
+                        unlink(path);
+                    }
+                    return fd;
+                }
+
+    /*////////////////////////////
+        Private Functions
+    */////////////////////////////
+        /*////////////////////////////
+            Writing Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Save visit
+                    queues one piece, copying large runs of the original file
+                    between descriptors when the kernel supports it
+                    returns 0 on success
+            */////////////////////////////
+                static int saveVisit(void * context, u_int8_t source, const char * data, u_int64_t start, u_int64_t length){
+                    writer_t * writer = context;
+                    if ((SOURCE_ORIGINAL == source) && (writer->copy) && (MIN_COPY_SIZE <= length)){
+                        if (0 != writerFlush(writer)){
+                            return -1;
+                        }
+                        u_int64_t copied = writerCopy(writer, start, length);
+                        if (copied == length){
+                            return 0;
+                        }
+                        //the rest goes through writev once copying is ruled out
+                        if (writer->copy){
+                            return -1;
+                        }
+                        data += copied;
+                        length -= copied;
+                    }
+                    while (0 < length){
+                        if (MAX_IOVECS == writer->iov_count){
+                            if (0 != writerFlush(writer)){
+                                return -1;
+                            }
+                        }
+                        u_int64_t count = (length > SSIZE_MAX) ? SSIZE_MAX : length;
+                        writer->iov[writer->iov_count].iov_base = (void *)data;
+                        writer->iov[writer->iov_count].iov_len = count;
+                        writer->iov_count++;
+                        data += count;
+                        length -= count;
+                    }
+                    return 0;
+                }
+            /*////////////////////////////
+                Writer flush
+                    writes every queued piece, resuming after short writes
+                    returns 0 on success
+            */////////////////////////////
+                static int writerFlush(writer_t * writer){
+                    struct iovec * iov = writer->iov;
+                    u_int64_t count = writer->iov_count;
+                    while (0 < count){
+                        ssize_t written = writev(writer->fd, iov, count);
+                        if (0 > written){
+                            if (EINTR == errno){
+                                continue;
+                            }
+                            return -1;
+                        }
+                        //skip what was written, trimming a partly written iovec
+                        while ((0 < count) && ((size_t)written >= iov->iov_len)){
+                            written -= iov->iov_len;
+                            iov++;
+                            count--;
+                        }
+                        if (0 < count){
+                            iov->iov_base = (char *)iov->iov_base + written;
+                            iov->iov_len -= written;
+                        }
+                    }
+                    writer->iov_count = 0;
+                    return 0;
+                }
+            /*////////////////////////////
+                Writer copy
+                    copies length bytes of the source file from start to the end
+                    of the temporary file without passing through user space
+                    clears copy when the kernel or filesystem cannot do it
+                    returns the bytes copied
+            */////////////////////////////
+                static u_int64_t writerCopy(writer_t * writer, u_int64_t start, u_int64_t length){
+                    u_int64_t copied = 0;
+#if defined(__linux__) && defined(SYS_copy_file_range)
+                    int64_t offset = start;
+                    while (copied < length){
+                        long count = syscall(SYS_copy_file_range, writer->source_fd, &offset, writer->fd, NULL, length - copied, 0);
+                        if (0 < count){
+                            copied += count;
+                            continue;
+                        }
+                        if ((0 > count) && (EINTR == errno)){
+                            continue;
+                        }
+                        //unsupported pairs fall back, real write errors do not
+                        if ((0 == count) || (EXDEV == errno) || (ENOSYS == errno) || (EINVAL == errno) || (EOPNOTSUPP == errno) || (EBADF == errno)){
+                            writer->copy = 0;
+                        }
+                        break;
+                    }
+#else
+                    writer->copy = 0;
+#endif
+                    return copied;
+                }
+        /*////////////////////////////
+            Path Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Temporary path
+                    returns a heap mkstemp template hidden beside path
+            */////////////////////////////
+                static char * temporaryPath(const char * path){
+                    const char * slash = strrchr(path, '/');
+                    int dir_length = (NULL == slash) ? 0 : (int)(slash - path + 1);
+                    const char * name = path + dir_length;
+                    u_int64_t size = strlen(path) + 16;
+                    char * temporary = malloc(size);
+                    if (NULL != temporary){
+                        snprintf(temporary, size, "%.*s.%s.XXXXXX", dir_length, path, name);
+                    }
+                    return temporary;
+                }
+            /*////////////////////////////
+                Sync directory
+                    flushes the directory holding path
+                    returns 0 on success
+            */////////////////////////////
+                static int syncDirectory(const char * path){
+                    const char * slash = strrchr(path, '/');
+                    u_int64_t length = (NULL == slash) ? 1 : ((slash == path) ? 1 : (u_int64_t)(slash - path));
+                    char dir[length + 1];
+                    memcpy(dir, (NULL == slash) ? "." : path, length);
+                    dir[length] = '\0';
+                    int fd = open(dir, O_RDONLY | O_DIRECTORY);
+                    if (-1 == fd){
+                        return -1;
+                    }
+                    int status = fsync(fd);
+                    close(fd);
+                    return status;
+                }
+//End of file
@@ -0,0 +1,29 @@
+/*////////////////////////////
+    Guard
+*/////////////////////////////
+    #ifndef SAVE_H
+    #define SAVE_H
+
+/*////////////////////////////
+    Includes
+*/////////////////////////////
+    #include <sys/types.h>
+    #include "buffer.h"
+
+/*////////////////////////////
+    Defines
+*/////////////////////////////
+    #define SYNC_NONE           0
+    #define SYNC_DATA           1
+    #define SYNC_FULL           2
+
+/*////////////////////////////
+    Prototypes
+*/////////////////////////////
+    //Saving
+        int saveBuffer(buffer_t * buffer, const char * path, int source_fd, int sync);
+    //Scratch
+        int saveScratch(const char * prefix);
+
+    #endif
+//End of file
@@ -0,0 +1,221 @@
+/*////////////////////////////
+    Includes
+*/////////////////////////////
+    #include <string.h>
+    #include "macros.h"
+    #include "search.h"
+    #if defined(__x86_64__) || defined(__i386__)
+        #include <immintrin.h>
+    #endif
+
+/*////////////////////////////
+    Prototypes
+*/////////////////////////////
+    //Scanning
+        static u_int64_t scanScalar(const char * data, u_int64_t size, const char * pattern, u_int64_t length, u_int64_t offset);
+
+/*////////////////////////////
+    Functions
+*/////////////////////////////
+    /*////////////////////////////
+        Public Functions
+    */////////////////////////////
+        /*////////////////////////////
+            Memory Functions
+        */////////////////////////////
+#if defined(__x86_64__) || defined(__i386__)
+            /*////////////////////////////
+                Scan AVX2
+                    filters 32 candidate positions per step on the first and
+                    last pattern byte, verifying only positions that pass both
+                    returns the first match or where the vector loop stopped
+            */////////////////////////////
+                __attribute__((target("avx2")))
+                static u_int64_t scanAVX2(const char * data, u_int64_t size, const char * pattern, u_int64_t length, u_int64_t * stop){
+                    const __m256i first = _mm256_set1_epi8(pattern[0]);
+                    const __m256i last = _mm256_set1_epi8(pattern[length - 1]);
+                    u_int64_t offset = 0;
+                    for (; offset + length - 1 + 32 <= size; offset += 32){
+                        __m256i head = _mm256_loadu_si256((const __m256i *)(data + offset));
+                        __m256i tail = _mm256_loadu_si256((const __m256i *)(data + offset + length - 1));
+                        u_int32_t mask = _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(head, first), _mm256_cmpeq_epi8(tail, last)));
+                        while (mask){
+                            u_int64_t candidate = offset + __builtin_ctz(mask);
+                            if (0 == memcmp(data + candidate + 1, pattern + 1, length - 2)){
+                                return candidate;
+                            }
+                            mask &= mask - 1;
+                        }
+                    }
+                    *stop = offset;
+                    return SEARCH_NONE;
+                }
+            /*////////////////////////////
+                Scan SSE2
+                    filters 16 candidate positions per step
+            */////////////////////////////
+                __attribute__((target("sse2")))
+                static u_int64_t scanSSE2(const char * data, u_int64_t size, const char * pattern, u_int64_t length, u_int64_t * stop){
+                    const __m128i first = _mm_set1_epi8(pattern[0]);
+                    const __m128i last = _mm_set1_epi8(pattern[length - 1]);
+                    u_int64_t offset = 0;
+                    for (; offset + length - 1 + 16 <= size; offset += 16){
+                        __m128i head = _mm_loadu_si128((const __m128i *)(data + offset));
+                        __m128i tail = _mm_loadu_si128((const __m128i *)(data + offset + length - 1));
+                        u_int32_t mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(head, first), _mm_cmpeq_epi8(tail, last)));
+                        while (mask){
+                            u_int64_t candidate = offset + __builtin_ctz(mask);
+                            if (0 == memcmp(data + candidate + 1, pattern + 1, length - 2)){
+                                return candidate;
+                            }
+                            mask &= mask - 1;
+                        }
+                    }
+                    *stop = offset;
+                    return SEARCH_NONE;
+                }
+#endif
+            /*////////////////////////////
+                Search memory
+                    finds the first occurrence of pattern in data
+                    returns its offset or SEARCH_NONE
+            */////////////////////////////
+                u_int64_t searchMemory(const char * data, u_int64_t size, const char * pattern, u_int64_t length){
+                    if ((0 == length) || (length > size)){
+                        return SEARCH_NONE;
+                    }
+                    if (1 == length){
+                        const char * match = memchr(data, pattern[0], size);
+                        return (NULL == match) ? SEARCH_NONE : (u_int64_t)(match - data);
+                    }
+                    u_int64_t offset = 0;
+#if defined(__x86_64__) || defined(__i386__)
+                    __builtin_cpu_init();
+                    u_int64_t match = SEARCH_NONE;
+                    if (__builtin_cpu_supports("avx2")){
+                        match = scanAVX2(data, size, pattern, length, &offset);
+                    }else if (__builtin_cpu_supports("sse2")){
+                        match = scanSSE2(data, size, pattern, length, &offset);
+                    }
+                    if (SEARCH_NONE != match){
+                        return match;
+                    }
+#endif
+                    return scanScalar(data, size, pattern, length, offset);
+                }
+            /*////////////////////////////
+                Search memory last
+                    finds the last occurrence of pattern in data
+                    returns its offset or SEARCH_NONE
+            */////////////////////////////
+                u_int64_t searchMemoryLast(const char * data, u_int64_t size, const char * pattern, u_int64_t length){
+                    if ((0 == length) || (length > size)){
+                        return SEARCH_NONE;
+                    }
+                    for (u_int64_t offset = size - length + 1; 0 < offset; offset--){
+                        if ((data[offset - 1] == pattern[0]) && (data[offset + length - 2] == pattern[length - 1]) && (0 == memcmp(data + offset - 1, pattern, length))){
+                            return offset - 1;
+                        }
+                    }
+                    return SEARCH_NONE;
+                }
+        /*////////////////////////////
+            Buffer Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Search forward
+                    finds the first match starting at or after from, scanning
+                    pieces in place and reading only across piece boundaries
+                    returns its document offset or SEARCH_NONE
+            */////////////////////////////
+                u_int64_t searchForward(buffer_t * buffer, const char * pattern, u_int64_t length, u_int64_t from){
+                    if ((0 == length) || (MAX_PATTERN_SIZE < length)){
+                        return SEARCH_NONE;
+                    }
+                    char window[2 * MAX_PATTERN_SIZE];
+                    u_int64_t start;
+                    u_int64_t size;
+                    const char * span;
+                    while (NULL != (span = bufferSpan(buffer, from, &start, &size))){
+                        u_int64_t end = start + size;
+                        u_int64_t match = searchMemory(span + (from - start), end - from, pattern, length);
+                        if (SEARCH_NONE != match){
+                            return from + match;
+                        }
+                        //matches straddling the end of this piece
+                        u_int64_t edge = (end - from > length - 1) ? end - (length - 1) : from;
+                        u_int64_t read = bufferRead(buffer, edge, window, (end - edge) + (length - 1));
+                        match = searchMemory(window, read, pattern, length);
+                        if (SEARCH_NONE != match){
+                            return edge + match;
+                        }
+                        from = end;
+                    }
+                    return SEARCH_NONE;
+                }
+            /*////////////////////////////
+                Search backward
+                    finds the last match starting before before
+                    returns its document offset or SEARCH_NONE
+            */////////////////////////////
+                u_int64_t searchBackward(buffer_t * buffer, const char * pattern, u_int64_t length, u_int64_t before){
+                    if ((0 == length) || (MAX_PATTERN_SIZE < length) || (0 == before)){
+                        return SEARCH_NONE;
+                    }
+                    char window[2 * MAX_PATTERN_SIZE];
+                    u_int64_t total = bufferLength(buffer);
+                    if (length > total){
+                        return SEARCH_NONE;
+                    }
+                    //a match starting before before ends by before + length - 1
+                    u_int64_t end = (before - 1 > total - length) ? total : before - 1 + length;
+                    u_int64_t start;
+                    u_int64_t size;
+                    const char * span;
+                    while ((0 < end) && (NULL != (span = bufferSpan(buffer, end - 1, &start, &size)))){
+                        u_int64_t match = searchMemoryLast(span, end - start, pattern, length);
+                        if (SEARCH_NONE != match){
+                            return start + match;
+                        }
+                        //matches straddling the start of this piece
+                        if (0 == start){
+                            break;
+                        }
+                        u_int64_t edge = (start > length - 1) ? start - (length - 1) : 0;
+                        u_int64_t limit = (end - start > length - 1) ? start + length - 1 : end;
+                        u_int64_t read = bufferRead(buffer, edge, window, limit - edge);
+                        match = searchMemoryLast(window, read, pattern, length);
+                        if (SEARCH_NONE != match){
+                            return edge + match;
+                        }
+                        end = start;
+                    }
+                    return SEARCH_NONE;
+                }
+
+    /*////////////////////////////
+        Private Functions
+    */////////////////////////////
+        /*////////////////////////////
+            Scanning Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Scan scalar
+                    finishes a search from offset, hopping between first byte
+                    candidates with memchr
+            */////////////////////////////
+                static u_int64_t scanScalar(const char * data, u_int64_t size, const char * pattern, u_int64_t length, u_int64_t offset){
+                    while (offset + length <= size){
+                        const char * candidate = memchr(data + offset, pattern[0], size - length + 1 - offset);
+                        if (NULL == candidate){
+                            break;
+                        }
+                        offset = candidate - data;
+                        if (0 == memcmp(candidate, pattern, length)){
+                            return offset;
+                        }
+                        offset++;
+                    }
+                    return SEARCH_NONE;
+                }
+//End of file
@@ -0,0 +1,31 @@
+/*////////////////////////////
+    Guard
+*/////////////////////////////
+    #ifndef SEARCH_H
+    #define SEARCH_H
+
+/*////////////////////////////
+    Includes
+*/////////////////////////////
+    #include <stdint.h>
+    #include <sys/types.h>
+    #include "buffer.h"
+
+/*////////////////////////////
+    Defines
+*/////////////////////////////
+    #define SEARCH_NONE         UINT64_MAX
+    #define MAX_PATTERN_SIZE    256
+
+/*////////////////////////////
+    Prototypes
+*/////////////////////////////
+    //Memory
+        u_int64_t searchMemory(const char * data, u_int64_t size, const char * pattern, u_int64_t length);
+        u_int64_t searchMemoryLast(const char * data, u_int64_t size, const char * pattern, u_int64_t length);
+    //Buffer
+        u_int64_t searchForward(buffer_t * buffer, const char * pattern, u_int64_t length, u_int64_t from);
+        u_int64_t searchBackward(buffer_t * buffer, const char * pattern, u_int64_t length, u_int64_t before);
+
+    #endif
+//End of file
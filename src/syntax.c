@@ -0,0 +1,629 @@
+/*////////////////////////////
+    Includes
+*/////////////////////////////
+    #include <string.h>
+    #include "macros.h"
+    #include "arena.h"
+    #include "search.h"
+    #include "syntax.h"
+
+/*////////////////////////////
+    Defines
+*/////////////////////////////
+    #define LEX_NORMAL          0
+    #define LEX_COMMENT         1
+    #define LEX_STRING          2
+    #define LEX_PREPROCESSOR    3
+    #define CHAR_SPACE          1
+    #define CHAR_WORD           2
+    #define CHAR_WORD_START     4
+    #define CHAR_DIGIT          8
+    #define CHAR_QUOTE          16
+    #define CHAR_COMMENT        32
+    #define LANG_PREPROCESSOR   1
+    #define LANG_SECTIONS       2
+    #define LANG_STRING_KEYS    4
+    #define LANG_TYPE_SUFFIX    8
+    #define LANG_START_COMMENTS 16
+    #define LANG_CONTINUATION   32
+    #define WORD_COUNT(words)   (sizeof(words) / sizeof(words[0]))
+    #define SYNTAX_WHOLE        ((u_int64_t)-1)
+    #define SYNTAX_LOOKAHEAD    256
+
+/*////////////////////////////
+    Structs
+*/////////////////////////////
+    struct language{
+        const char *            name;       //shown nowhere yet, kept for debugging
+        const char *            extensions; //space separated suffixes and whole names, padded with spaces
+        const char * const *    keywords;   //sorted keywords
+        u_int64_t               keyword_count;//keywords in the list
+        const char * const *    types;      //sorted type names
+        u_int64_t               type_count; //types in the list
+        const char *            line_comment;//multi byte line comment start, NULL for none
+        const char *            comment_chars;//single bytes starting a line comment
+        const char *            block_open; //block comment start, NULL for none
+        const char *            block_close;//block comment end
+        const char *            quotes;     //bytes opening a string
+        char                    key_separator;//first one on a line ends a key, 0 for none
+        u_int8_t                flags;      //LANG_* rules
+        u_int8_t                table[256]; //CHAR_* classes of every byte
+        u_int8_t                built;      //table has been filled in
+    };
+
+/*////////////////////////////
+    Prototypes
+*/////////////////////////////
+    //Languages
+        static language_t * languageFind(const char * path);
+        static void languageBuild(language_t * language);
+        static u_int8_t wordFind(const char * const * words, u_int64_t count, const char * text, u_int64_t length);
+    //Lexing
+        static u_int8_t lexLine(const language_t * language, u_int8_t state, const char * text, u_int64_t length, u_int8_t * tokens);
+        static u_int64_t scanString(const char * text, u_int64_t from, u_int64_t length, char quote);
+        static u_int8_t startsWith(const char * text, u_int64_t length, const char * prefix);
+        static void markTokens(u_int8_t * tokens, u_int64_t from, u_int64_t to, u_int8_t token);
+    //Cache
+        static u_int64_t syntaxPrepare(syntax_t * syntax, buffer_t * buffer, u_int64_t through);
+        static u_int8_t syntaxLex(syntax_t * syntax, buffer_t * buffer, u_int64_t line, u_int8_t state, u_int8_t * tokens, u_int64_t limit);
+        static const char * syntaxText(syntax_t * syntax, buffer_t * buffer, u_int64_t start, u_int64_t length);
+        static int syntaxReserve(syntax_t * syntax, u_int64_t count);
+
+/*////////////////////////////
+    Globals
+*/////////////////////////////
+    u_int64_t   MIN_STATE_CAPACITY =    4096;
+    const char * const C_KEYWORDS[] = {
+        "NULL", "_Alignas", "_Alignof", "_Atomic", "_Generic", "_Noreturn", "_Static_assert", "_Thread_local",
+        "auto", "break", "case", "const", "continue", "default", "do", "else", "enum", "extern", "false",
+        "for", "goto", "if", "inline", "register", "restrict", "return", "sizeof", "static", "struct",
+        "switch", "true", "typedef", "typeof", "union", "volatile", "while"
+    };
+    const char * const C_TYPES[] = {
+        "FILE", "_Bool", "bool", "char", "double", "float", "int", "long", "short", "signed", "unsigned", "void"
+    };
+    const char * const CONFIG_KEYWORDS[] = {
+        "false", "no", "null", "off", "on", "true", "yes"
+    };
+    language_t  LANGUAGES[] = {
+        {"c",       " c h cc cpp cxx hh hpp hxx ",  C_KEYWORDS, WORD_COUNT(C_KEYWORDS), C_TYPES, WORD_COUNT(C_TYPES),
+                    "//", "", "/*", "*/", "\"'", 0, LANG_PREPROCESSOR | LANG_TYPE_SUFFIX | LANG_CONTINUATION, {0}, 0},
+        {"ini",     " ini conf cfg toml desktop service properties gitconfig editorconfig ", CONFIG_KEYWORDS, WORD_COUNT(CONFIG_KEYWORDS), NULL, 0,
+                    NULL, "#;", NULL, NULL, "\"", '=', LANG_SECTIONS | LANG_START_COMMENTS, {0}, 0},
+        {"yaml",    " yml yaml ",                   CONFIG_KEYWORDS, WORD_COUNT(CONFIG_KEYWORDS), NULL, 0,
+                    NULL, "#", NULL, NULL, "\"'", ':', 0, {0}, 0},
+        {"json",    " json ",                       CONFIG_KEYWORDS, WORD_COUNT(CONFIG_KEYWORDS), NULL, 0,
+                    NULL, "", NULL, NULL, "\"", 0, LANG_STRING_KEYS, {0}, 0},
+    };
+
+/*////////////////////////////
+    Functions
+*/////////////////////////////
+    /*////////////////////////////
+        Public Functions
+    */////////////////////////////
+        /*////////////////////////////
+            Lifetime Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Syntax open
+                    picks the language from the file name, files with no known
+                    language are left plain
+            */////////////////////////////
+                void syntaxOpen(syntax_t * syntax, const char * path){
+                    memset(syntax, 0, sizeof(syntax_t));
+                    syntax->language = languageFind(path);
+                }
+            /*////////////////////////////
+                Syntax release
+            */////////////////////////////
+                void syntaxRelease(syntax_t * syntax){
+                    free(syntax->states);
+                    free(syntax->line);
+                    free(syntax->tokens);
+                    memset(syntax, 0, sizeof(syntax_t));
+                }
+            /*////////////////////////////
+                Syntax memory
+                    returns the bytes held by the state cache and scratch lines
+            */////////////////////////////
+                u_int64_t syntaxMemory(syntax_t * syntax){
+                    return syntax->capacity + syntax->line_size + syntax->token_size;
+                }
+        /*////////////////////////////
+            Edit Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Syntax edit
+                    line and the removed lines after it became line and added
+                    lines, the cached states after them shift to match and the
+                    edited lines are relexed through horizon, then on until a
+                    line ends in the state it ended in before
+                    returns the first line whose colors cannot have changed
+            */////////////////////////////
+                u_int64_t syntaxEdit(syntax_t * syntax, buffer_t * buffer, u_int64_t line, u_int64_t removed, u_int64_t added, u_int64_t horizon){
+                    if ((NULL == syntax->language) || (line >= syntax->count)){
+                        return line + added + 1;
+                    }
+                    u_int64_t tail_old = line + removed + 1;
+                    u_int64_t tail_new = line + added + 1;
+                    if ((tail_old >= syntax->count) || (0 != syntaxReserve(syntax, syntax->count - tail_old + tail_new))){
+                        syntaxTruncate(syntax, line);
+                        return tail_new;
+                    }
+                    memmove(syntax->states + tail_new, syntax->states + tail_old, syntax->count - tail_old);
+                    syntax->count = syntax->count - tail_old + tail_new;
+                    //merge with lines still waiting from earlier edits
+                    u_int64_t begin = line;
+                    u_int64_t end = tail_new;
+                    if (syntax->pending){
+                        u_int64_t old_begin = (syntax->begin < line) ? syntax->begin : (syntax->begin >= tail_old) ? syntax->begin - tail_old + tail_new : tail_new;
+                        u_int64_t old_end = (syntax->end < line) ? syntax->end : (syntax->end >= tail_old) ? syntax->end - tail_old + tail_new : tail_new;
+                        begin = (old_begin < begin) ? old_begin : begin;
+                        end = (old_end > end) ? old_end : end;
+                    }
+                    syntax->pending = 1;
+                    syntax->begin = begin;
+                    syntax->end = end;
+                    u_int64_t stop = syntaxPrepare(syntax, buffer, horizon);
+                    return (stop > tail_new) ? stop : tail_new;
+                }
+            /*////////////////////////////
+                Syntax truncate
+                    forgets the states from line on, for edits whose extent is
+                    not known
+            */////////////////////////////
+                void syntaxTruncate(syntax_t * syntax, u_int64_t line){
+                    if (syntax->count > line){
+                        syntax->count = line;
+                    }
+                    if ((syntax->pending) && (syntax->begin >= syntax->count)){
+                        syntax->pending = 0;
+                    }
+                }
+        /*////////////////////////////
+            Coloring Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Syntax line
+                    lexes the start of one line from its cached start state,
+                    far enough to color its first through bytes
+                    returns the token of each byte lexed, NULL for plain text
+                    or when through lies past SYNTAX_MAX_COLUMN
+            */////////////////////////////
+                const u_int8_t * syntaxLine(syntax_t * syntax, buffer_t * buffer, u_int64_t line, u_int64_t through, u_int64_t * length){
+                    if ((NULL == syntax->language) || (SYNTAX_MAX_COLUMN < through)){
+                        return NULL;
+                    }
+                    if (0 < line){
+                        syntaxPrepare(syntax, buffer, line - 1);
+                    }
+                    u_int8_t state = ((0 < line) && (line - 1 < syntax->count)) ? syntax->states[line - 1] : LEX_NORMAL;
+                    //a word cut by the edge is lexed whole
+                    *length = bufferLineLength(buffer, line);
+                    if (*length > through + SYNTAX_LOOKAHEAD){
+                        *length = through + SYNTAX_LOOKAHEAD;
+                    }
+                    if (*length > syntax->token_size){
+                        syntax->token_size = *length;
+                        syntax->tokens = recalloc(syntax->tokens, syntax->token_size, sizeof(u_int8_t));
+                        if (NULL == syntax->tokens){
+                            syntax->token_size = 0;
+                            return NULL;
+                        }
+                    }
+                    syntaxLex(syntax, buffer, line, state, syntax->tokens, *length);
+                    return syntax->tokens;
+                }
+
+    /*////////////////////////////
+        Private Functions
+    */////////////////////////////
+        /*////////////////////////////
+            Language Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Language find
+                    matches the file's suffix, or its whole name when it has
+                    none, against each language
+            */////////////////////////////
+                static language_t * languageFind(const char * path){
+                    if (NULL == path){
+                        return NULL;
+                    }
+                    const char * slash = strrchr(path, '/');
+                    const char * name = (NULL == slash) ? path : slash + 1;
+                    const char * dot = strrchr(name, '.');
+                    const char * suffix = (NULL == dot) ? name : dot + 1;
+                    u_int64_t length = strlen(suffix);
+                    if ((0 == length) || (MAX_PATTERN_SIZE <= length + 2)){
+                        return NULL;
+                    }
+                    char padded[MAX_PATTERN_SIZE];
+                    padded[0] = ' ';
+                    for (u_int64_t iter = 0; iter < length; iter++){
+                        padded[iter + 1] = ((u_int8_t)(suffix[iter] - 'A') < 26) ? suffix[iter] | 0x20 : suffix[iter];
+                    }
+                    padded[length + 1] = ' ';
+                    padded[length + 2] = '\0';
+                    for (u_int64_t iter = 0; iter < WORD_COUNT(LANGUAGES); iter++){
+                        if (NULL != strstr(LANGUAGES[iter].extensions, padded)){
+                            languageBuild(&LANGUAGES[iter]);
+                            return &LANGUAGES[iter];
+                        }
+                    }
+                    return NULL;
+                }
+            /*////////////////////////////
+                Language build
+                    fills the byte class table the lexer dispatches on
+            */////////////////////////////
+                static void languageBuild(language_t * language){
+                    if (language->built){
+                        return;
+                    }
+                    for (int byte = 0; byte < 256; byte++){
+                        u_int8_t classes = 0;
+                        if ((' ' == byte) || ('\t' == byte) || ('\r' == byte) || ('\f' == byte) || ('\v' == byte)){
+                            classes |= CHAR_SPACE;
+                        }
+                        if ((('a' <= byte) && (byte <= 'z')) || (('A' <= byte) && (byte <= 'Z')) || ('_' == byte) || (128 <= byte)){
+                            classes |= CHAR_WORD | CHAR_WORD_START;
+                        }
+                        if (('0' <= byte) && (byte <= '9')){
+                            classes |= CHAR_WORD | CHAR_DIGIT;
+                        }
+                        if ((0 != byte) && (NULL != strchr(language->quotes, byte))){
+                            classes |= CHAR_QUOTE;
+                        }
+                        if ((0 != byte) && (NULL != strchr(language->comment_chars, byte))){
+                            classes |= CHAR_COMMENT;
+                        }
+                        language->table[byte] = classes;
+                    }
+                    language->built = 1;
+                }
+            /*////////////////////////////
+                Word find
+                    binary search of a sorted word list for a length bounded word
+                    returns 1 when it is there
+            */////////////////////////////
+                static u_int8_t wordFind(const char * const * words, u_int64_t count, const char * text, u_int64_t length){
+                    u_int64_t low = 0;
+                    u_int64_t high = count;
+                    while (low < high){
+                        u_int64_t mid = low + (high - low) / 2;
+                        int order = strncmp(words[mid], text, length);
+                        if ((0 == order) && ('\0' != words[mid][length])){
+                            order = 1;
+                        }
+                        if (0 == order){
+                            return 1;
+                        }
+                        if (0 > order){
+                            low = mid + 1;
+                        }else{
+                            high = mid;
+                        }
+                    }
+                    return 0;
+                }
+        /*////////////////////////////
+            Lexing Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Lex line
+                    tokenizes one line starting in state, writing a token per byte
+                    when tokens is not NULL
+                    returns the state the line ends in
+            */////////////////////////////
+                static u_int8_t lexLine(const language_t * language, u_int8_t state, const char * text, u_int64_t length, u_int8_t * tokens){
+                    const u_int8_t * table = language->table;
+                    u_int8_t continued = (language->flags & LANG_CONTINUATION) && (0 < length) && ('\\' == text[length - 1]);
+                    u_int8_t directive = (LEX_PREPROCESSOR == state);
+                    u_int64_t first = 0;
+                    while ((first < length) && (table[(u_int8_t)text[first]] & CHAR_SPACE)){
+                        first++;
+                    }
+                    markTokens(tokens, 0, length, directive ? TOKEN_PREPROCESSOR : TOKEN_PLAIN);
+                    u_int64_t iter = 0;
+                    //finish what the previous line left open
+                    if (LEX_COMMENT == state){
+                        u_int64_t close_length = strlen(language->block_close);
+                        u_int64_t close = searchMemory(text, length, language->block_close, close_length);
+                        if (SEARCH_NONE == close){
+                            markTokens(tokens, 0, length, TOKEN_COMMENT);
+                            return LEX_COMMENT;
+                        }
+                        iter = close + close_length;
+                        markTokens(tokens, 0, iter, TOKEN_COMMENT);
+                    }else if (LEX_STRING == state){
+                        u_int64_t end = scanString(text, 0, length, '"');
+                        if (SEARCH_NONE == end){
+                            markTokens(tokens, 0, length, TOKEN_STRING);
+                            return continued ? LEX_STRING : LEX_NORMAL;
+                        }
+                        iter = end;
+                        markTokens(tokens, 0, iter, TOKEN_STRING);
+                    }
+                    while (iter < length){
+                        u_int8_t byte = text[iter];
+                        u_int8_t classes = table[byte];
+                        if (classes & CHAR_SPACE){
+                            for (iter++; (iter < length) && (table[(u_int8_t)text[iter]] & CHAR_SPACE); iter++);
+                            continue;
+                        }
+                        //block comments
+                        if ((NULL != language->block_open) && (byte == (u_int8_t)language->block_open[0]) && (startsWith(text + iter, length - iter, language->block_open))){
+                            u_int64_t open_length = strlen(language->block_open);
+                            u_int64_t close_length = strlen(language->block_close);
+                            u_int64_t close = searchMemory(text + iter + open_length, length - iter - open_length, language->block_close, close_length);
+                            if (SEARCH_NONE == close){
+                                markTokens(tokens, iter, length, TOKEN_COMMENT);
+                                return LEX_COMMENT;
+                            }
+                            u_int64_t end = iter + open_length + close + close_length;
+                            markTokens(tokens, iter, end, TOKEN_COMMENT);
+                            iter = end;
+                            continue;
+                        }
+                        //line comments
+                        if (((NULL != language->line_comment) && (byte == (u_int8_t)language->line_comment[0]) && (startsWith(text + iter, length - iter, language->line_comment))) ||
+                            ((classes & CHAR_COMMENT) && ((!(language->flags & LANG_START_COMMENTS)) || (iter == first)))){
+                            markTokens(tokens, iter, length, TOKEN_COMMENT);
+                            return (directive && continued) ? LEX_PREPROCESSOR : LEX_NORMAL;
+                        }
+                        //directives color the rest of the line but strings and comments
+                        if ((language->flags & LANG_PREPROCESSOR) && ('#' == byte) && (iter == first)){
+                            directive = 1;
+                            markTokens(tokens, iter, length, TOKEN_PREPROCESSOR);
+                            iter++;
+                            continue;
+                        }
+                        //keys lead a line up to the separator
+                        if ((0 != language->key_separator) && (iter == first)){
+                            const char * separator = memchr(text + iter, language->key_separator, length - iter);
+                            u_int64_t end = (NULL == separator) ? iter : (u_int64_t)(separator - text);
+                            u_int8_t valid = (iter < end) && ((':' != language->key_separator) || (end + 1 == length) || (table[(u_int8_t)text[end + 1]] & CHAR_SPACE));
+                            for (u_int64_t scan = iter; (valid) && (scan < end); scan++){
+                                valid = !(table[(u_int8_t)text[scan]] & (CHAR_QUOTE | CHAR_COMMENT));
+                            }
+                            if (valid){
+                                u_int64_t trimmed = end;
+                                while (table[(u_int8_t)text[trimmed - 1]] & CHAR_SPACE){
+                                    trimmed--;
+                                }
+                                markTokens(tokens, iter, trimmed, TOKEN_KEY);
+                                iter = end + 1;
+                                continue;
+                            }
+                        }
+                        //strings, which are keys when a colon follows in json
+                        if (classes & CHAR_QUOTE){
+                            u_int64_t end = scanString(text, iter + 1, length, byte);
+                            if (SEARCH_NONE == end){
+                                markTokens(tokens, iter, length, TOKEN_STRING);
+                                if (continued){
+                                    return directive ? LEX_PREPROCESSOR : ('"' == byte) ? LEX_STRING : LEX_NORMAL;
+                                }
+                                return LEX_NORMAL;
+                            }
+                            u_int8_t token = TOKEN_STRING;
+                            if (language->flags & LANG_STRING_KEYS){
+                                u_int64_t next = end;
+                                while ((next < length) && (table[(u_int8_t)text[next]] & CHAR_SPACE)){
+                                    next++;
+                                }
+                                token = ((next < length) && (':' == text[next])) ? TOKEN_KEY : TOKEN_STRING;
+                            }
+                            markTokens(tokens, iter, end, token);
+                            iter = end;
+                            continue;
+                        }
+                        //section headers
+                        if ((language->flags & LANG_SECTIONS) && ('[' == byte) && (iter == first)){
+                            const char * close = memchr(text + iter, ']', length - iter);
+                            u_int64_t end = (NULL == close) ? length : (u_int64_t)(close - text) + 1;
+                            markTokens(tokens, iter, end, TOKEN_SECTION);
+                            iter = end;
+                            continue;
+                        }
+                        //numbers, with suffixes, exponents and hex digits
+                        if ((classes & CHAR_DIGIT) || (('.' == byte) && (iter + 1 < length) && (table[(u_int8_t)text[iter + 1]] & CHAR_DIGIT))){
+                            u_int64_t end = iter + 1;
+                            while (end < length){
+                                u_int8_t next = text[end];
+                                if ((table[next] & CHAR_WORD) || ('.' == next) || ((('+' == next) || ('-' == next)) && ('e' == (text[end - 1] | 0x20)))){
+                                    end++;
+                                }else{
+                                    break;
+                                }
+                            }
+                            markTokens(tokens, iter, end, TOKEN_NUMBER);
+                            iter = end;
+                            continue;
+                        }
+                        //words
+                        if (classes & CHAR_WORD_START){
+                            u_int64_t end = iter + 1;
+                            while ((end < length) && (table[(u_int8_t)text[end]] & CHAR_WORD)){
+                                end++;
+                            }
+                            //only the colors depend on which word it is
+                            if ((NULL != tokens) && (!directive)){
+                                u_int64_t size = end - iter;
+                                if (wordFind(language->keywords, language->keyword_count, text + iter, size)){
+                                    markTokens(tokens, iter, end, TOKEN_KEYWORD);
+                                }else if ((wordFind(language->types, language->type_count, text + iter, size)) ||
+                                          ((language->flags & LANG_TYPE_SUFFIX) && (2 < size) && ('_' == text[end - 2]) && ('t' == text[end - 1]))){
+                                    markTokens(tokens, iter, end, TOKEN_TYPE);
+                                }
+                            }
+                            iter = end;
+                            continue;
+                        }
+                        iter++;
+                    }
+                    return (directive && continued) ? LEX_PREPROCESSOR : LEX_NORMAL;
+                }
+            /*////////////////////////////
+                Scan string
+                    finds the quote closing a string whose body starts at from,
+                    skipping backslash escapes
+                    returns the offset past the quote, SEARCH_NONE when the line
+                    ends first
+            */////////////////////////////
+                static u_int64_t scanString(const char * text, u_int64_t from, u_int64_t length, char quote){
+                    for (u_int64_t iter = from; iter < length; iter++){
+                        if ('\\' == text[iter]){
+                            iter++;
+                        }else if (quote == text[iter]){
+                            return iter + 1;
+                        }
+                    }
+                    return SEARCH_NONE;
+                }
+            /*////////////////////////////
+                Starts with
+            */////////////////////////////
+                static u_int8_t startsWith(const char * text, u_int64_t length, const char * prefix){
+                    u_int64_t iter = 0;
+                    for (; '\0' != prefix[iter]; iter++){
+                        if ((iter >= length) || (prefix[iter] != text[iter])){
+                            return 0;
+                        }
+                    }
+                    return 1;
+                }
+            /*////////////////////////////
+                Mark tokens
+            */////////////////////////////
+                static void markTokens(u_int8_t * tokens, u_int64_t from, u_int64_t to, u_int8_t token){
+                    if ((NULL != tokens) && (from < to)){
+                        memset(tokens + from, token, to - from);
+                    }
+                }
+        /*////////////////////////////
+            Cache Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Syntax prepare
+                    makes the end states of every line through the given one
+                    valid, first relexing lines an edit left behind, then
+                    extending the cache forward
+                    returns the line after the last one an edit relexed, 0 when
+                    none were
+            */////////////////////////////
+                static u_int64_t syntaxPrepare(syntax_t * syntax, buffer_t * buffer, u_int64_t through){
+                    u_int64_t lines = bufferLineCount(buffer);
+                    if (through >= lines){
+                        through = lines - 1;
+                    }
+                    u_int64_t stop = 0;
+                    if ((syntax->pending) && (syntax->begin <= through)){
+                        u_int64_t line = syntax->begin;
+                        u_int8_t state = (0 == line) ? LEX_NORMAL : syntax->states[line - 1];
+                        for (; line < syntax->count; line++){
+                            state = syntaxLex(syntax, buffer, line, state, NULL, SYNTAX_WHOLE);
+                            //an unchanged state past the edit means the rest still holds
+                            if ((line >= syntax->end) && (state == syntax->states[line])){
+                                syntax->pending = 0;
+                                break;
+                            }
+                            syntax->states[line] = state;
+                            if (line == through){
+                                line++;
+                                break;
+                            }
+                        }
+                        stop = (syntax->pending) ? syntax->count : line + 1;
+                        if (syntax->pending){
+                            syntax->begin = line;
+                            syntax->end = (syntax->end > line) ? syntax->end : line;
+                            syntax->pending = (line < syntax->count);
+                        }
+                    }
+                    if ((syntax->count <= through) && (0 == syntaxReserve(syntax, through + 1))){
+                        //lines are found by scanning forward through each piece in place
+                        u_int8_t state = (0 == syntax->count) ? LEX_NORMAL : syntax->states[syntax->count - 1];
+                        u_int64_t offset = bufferLineStart(buffer, syntax->count);
+                        for (u_int64_t line = syntax->count; line <= through; line++){
+                            u_int64_t span_start = 0;
+                            u_int64_t span_length = 0;
+                            const char * span = bufferSpan(buffer, offset, &span_start, &span_length);
+                            const char * text = (NULL == span) ? NULL : span + (offset - span_start);
+                            const char * newline = (NULL == span) ? NULL : memchr(text, '\n', span_start + span_length - offset);
+                            if (NULL != newline){
+                                state = lexLine(syntax->language, state, text, newline - text, NULL);
+                                offset += newline - text + 1;
+                            }else{
+                                state = syntaxLex(syntax, buffer, line, state, NULL, SYNTAX_WHOLE);
+                                offset = bufferLineStart(buffer, line + 1);
+                            }
+                            syntax->states[line] = state;
+                        }
+                        syntax->count = through + 1;
+                    }
+                    return stop;
+                }
+            /*////////////////////////////
+                Syntax lex
+                    lexes up to limit bytes of a line of the buffer
+                    returns the state it ends in
+            */////////////////////////////
+                static u_int8_t syntaxLex(syntax_t * syntax, buffer_t * buffer, u_int64_t line, u_int8_t state, u_int8_t * tokens, u_int64_t limit){
+                    u_int64_t start = bufferLineStart(buffer, line);
+                    u_int64_t length = bufferLineLength(buffer, line);
+                    if (length > limit){
+                        length = limit;
+                    }
+                    const char * text = syntaxText(syntax, buffer, start, length);
+                    if (NULL == text){
+                        return state;
+                    }
+                    return lexLine(syntax->language, state, text, length, tokens);
+                }
+            /*////////////////////////////
+                Syntax text
+                    returns the bytes of a range, in place when one piece holds
+                    them and copied otherwise
+            */////////////////////////////
+                static const char * syntaxText(syntax_t * syntax, buffer_t * buffer, u_int64_t start, u_int64_t length){
+                    u_int64_t span_start = 0;
+                    u_int64_t span_length = 0;
+                    const char * span = bufferSpan(buffer, start, &span_start, &span_length);
+                    if ((NULL != span) && (start + length <= span_start + span_length)){
+                        return span + (start - span_start);
+                    }
+                    if (0 == length){
+                        return "";
+                    }
+                    if (length > syntax->line_size){
+                        syntax->line_size = length;
+                        syntax->line = recalloc(syntax->line, syntax->line_size, sizeof(char));
+                        if (NULL == syntax->line){
+                            syntax->line_size = 0;
+                            return NULL;
+                        }
+                    }
+                    bufferRead(buffer, start, syntax->line, length);
+                    return syntax->line;
+                }
+            /*////////////////////////////
+                Syntax reserve
+                    returns 0 once count states fit
+            */////////////////////////////
+                static int syntaxReserve(syntax_t * syntax, u_int64_t count){
+                    if (count <= syntax->capacity){
+                        return 0;
+                    }
+                    u_int64_t capacity = growCapacity(syntax->capacity, count, MIN_STATE_CAPACITY);
+                    u_int8_t * states = realloc(syntax->states, capacity);
+                    if (NULL == states){
+                        return -1;
+                    }
+                    syntax->states = states;
+                    syntax->capacity = capacity;
+                    return 0;
+                }
+//End of file
@@ -0,0 +1,66 @@
+/*////////////////////////////
+    Guard
+*/////////////////////////////
+    #ifndef SYNTAX_H
+    #define SYNTAX_H
+
+/*////////////////////////////
+    Includes
+*/////////////////////////////
+    #include <sys/types.h>
+    #include "buffer.h"
+
+/*////////////////////////////
+    Defines
+*/////////////////////////////
+    #define TOKEN_PLAIN         0
+    #define TOKEN_KEYWORD       1
+    #define TOKEN_TYPE          2
+    #define TOKEN_STRING        3
+    #define TOKEN_NUMBER        4
+    #define TOKEN_COMMENT       5
+    #define TOKEN_PREPROCESSOR  6
+    #define TOKEN_KEY           7
+    #define TOKEN_SECTION       8
+    #define TOKEN_COUNT         9
+    #define SYNTAX_MAX_COLUMN   65536
+
+/*////////////////////////////
+    Structs
+*/////////////////////////////
+    struct language;
+    struct syntax{
+        const struct language * language;   //rules for the open file, NULL for plain text
+        u_int8_t *              states;     //lexer state at the end of each line
+        u_int64_t               count;      //lines with a cached state
+        u_int64_t               capacity;   //states allocated
+        u_int8_t                pending;    //an edit left states to check
+        u_int64_t               begin;      //first line whose state must be relexed
+        u_int64_t               end;        //lines from here on stop relexing once their state matches
+        char *                  line;       //copy of a line split across pieces
+        u_int64_t               line_size;  //bytes allocated for line
+        u_int8_t *              tokens;     //token of each byte of the last colored line
+        u_int64_t               token_size; //tokens allocated
+    };
+
+/*////////////////////////////
+    Typedefs
+*/////////////////////////////
+    typedef struct language     language_t;
+    typedef struct syntax       syntax_t;
+
+/*////////////////////////////
+    Prototypes
+*/////////////////////////////
+    //Lifetime
+        void syntaxOpen(syntax_t * syntax, const char * path);
+        void syntaxRelease(syntax_t * syntax);
+        u_int64_t syntaxMemory(syntax_t * syntax);
+    //Edits
+        u_int64_t syntaxEdit(syntax_t * syntax, buffer_t * buffer, u_int64_t line, u_int64_t removed, u_int64_t added, u_int64_t horizon);
+        void syntaxTruncate(syntax_t * syntax, u_int64_t line);
+    //Coloring
+        const u_int8_t * syntaxLine(syntax_t * syntax, buffer_t * buffer, u_int64_t line, u_int64_t through, u_int64_t * length);
+
+    #endif
+//End of file
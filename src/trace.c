@@ -0,0 +1,269 @@
+/*////////////////////////////
+    Includes
+*/////////////////////////////
+    #include <string.h>
+    #include <stdlib.h>
+    #include <time.h>
+    #include "macros.h"
+    #include "trace.h"
+
+/*////////////////////////////
+    Prototypes
+*/////////////////////////////
+    //Recording
+        static u_int64_t traceNow();
+        static void record(histogram_t * histogram, u_int64_t value);
+    //Buckets
+        static u_int64_t bucketIndex(u_int64_t value);
+        static u_int64_t bucketLow(u_int64_t index);
+        static u_int64_t bucketHigh(u_int64_t index);
+
+/*////////////////////////////
+    Globals
+*/////////////////////////////
+    u_int64_t   TRACE_FORMAT =          1;
+    const char *STAGE_NAMES[TRACE_STAGE_COUNT] = {"update", "render", "refresh", "total"};
+    double      TRACE_QUANTILES[] =     {0.5, 0.9, 0.99, 0.999};
+    const char *QUANTILE_NAMES[] =      {"p50_ns", "p90_ns", "p99_ns", "p999_ns"};
+
+/*////////////////////////////
+    Functions
+*/////////////////////////////
+    /*////////////////////////////
+        Public Functions
+    */////////////////////////////
+        /*////////////////////////////
+            Lifetime Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Trace init
+            */////////////////////////////
+                void traceInit(trace_t * trace){
+                    memset(trace, 0, sizeof(trace_t));
+                }
+        /*////////////////////////////
+            Recording Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Trace receive
+                    stamps input arriving, keys arriving before the batch is
+                    painted join it
+            */////////////////////////////
+                void traceReceive(trace_t * trace){
+                    if (trace->active){
+                        return;
+                    }
+                    trace->pending.received = traceNow();
+                    trace->pending.keys = 0;
+                    trace->active = 1;
+                }
+            /*////////////////////////////
+                Trace update
+                    stamps the batch having been applied, a batch without keys
+                    is dropped
+            */////////////////////////////
+                void traceUpdate(trace_t * trace, u_int64_t keys){
+                    if (!trace->active){
+                        return;
+                    }
+                    trace->pending.keys += keys;
+                    if (0 == trace->pending.keys){
+                        trace->active = 0;
+                        return;
+                    }
+                    trace->pending.updated = traceNow();
+                }
+            /*////////////////////////////
+                Trace render
+                    stamps the frame having been drawn into the curses buffers
+            */////////////////////////////
+                void traceRender(trace_t * trace){
+                    if (trace->active){
+                        trace->pending.rendered = traceNow();
+                    }
+                }
+            /*////////////////////////////
+                Trace refresh
+                    stamps the frame reaching the terminal and publishes the
+                    event, a reader on another thread sees it once head moves
+            */////////////////////////////
+                void traceRefresh(trace_t * trace){
+                    if (!trace->active){
+                        return;
+                    }
+                    event_t * event = &trace->pending;
+                    event->refreshed = traceNow();
+                    trace->active = 0;
+                    record(&trace->stages[TRACE_STAGE_UPDATE], event->updated - event->received);
+                    record(&trace->stages[TRACE_STAGE_RENDER], event->rendered - event->updated);
+                    record(&trace->stages[TRACE_STAGE_REFRESH], event->refreshed - event->rendered);
+                    record(&trace->stages[TRACE_STAGE_TOTAL], event->refreshed - event->received);
+                    u_int64_t head = trace->head;
+                    trace->ring[head & (TRACE_RING_SIZE - 1)] = *event;
+                    __atomic_store_n(&trace->head, head + 1, __ATOMIC_RELEASE);
+                }
+        /*////////////////////////////
+            Reporting Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Trace quantile
+                    returns the upper bound of the bucket holding the quantile,
+                    0 when nothing was recorded
+            */////////////////////////////
+                u_int64_t traceQuantile(histogram_t * histogram, double quantile){
+                    if (0 == histogram->count){
+                        return 0;
+                    }
+                    u_int64_t rank = (u_int64_t)(quantile * histogram->count);
+                    if (rank >= histogram->count){
+                        rank = histogram->count - 1;
+                    }
+                    u_int64_t seen = 0;
+                    for (u_int64_t index = 0; index < HISTOGRAM_BUCKETS; index++){
+                        seen += histogram->counts[index];
+                        if (seen > rank){
+                            u_int64_t high = bucketHigh(index);
+                            return (high < histogram->max) ? high : histogram->max;
+                        }
+                    }
+                    return histogram->max;
+                }
+            /*////////////////////////////
+                Trace events
+                    copies up to max of the newest events, oldest first
+                    returns events copied
+            */////////////////////////////
+                u_int64_t traceEvents(trace_t * trace, event_t * events, u_int64_t max){
+                    u_int64_t head = __atomic_load_n(&trace->head, __ATOMIC_ACQUIRE);
+                    u_int64_t count = (head < TRACE_RING_SIZE) ? head : TRACE_RING_SIZE;
+                    if (count > max){
+                        count = max;
+                    }
+                    for (u_int64_t iter = 0; iter < count; iter++){
+                        events[iter] = trace->ring[(head - count + iter) & (TRACE_RING_SIZE - 1)];
+                    }
+                    return count;
+                }
+            /*////////////////////////////
+                Trace write
+                    writes the stage histograms and the newest events as JSON,
+                    times in nanoseconds
+                    returns 0 on success
+            */////////////////////////////
+                int traceWrite(trace_t * trace, FILE * output){
+                    fprintf(output, "{\n  \"format\": %llu,\n  \"timestamp\": %lld,\n  \"stages\": [", (unsigned long long)TRACE_FORMAT, (long long)time(NULL));
+                    for (u_int64_t stage = 0; stage < TRACE_STAGE_COUNT; stage++){
+                        histogram_t * histogram = &trace->stages[stage];
+                        fprintf(output, "%s\n    {\"name\": \"%s\", \"samples\": %llu", (0 == stage) ? "" : ",", STAGE_NAMES[stage], (unsigned long long)histogram->count);
+                        if (0 < histogram->count){
+                            fprintf(output, ", \"mean_ns\": %llu, \"min_ns\": %llu", (unsigned long long)(histogram->sum / histogram->count), (unsigned long long)histogram->min);
+                            for (u_int64_t iter = 0; iter < sizeof(TRACE_QUANTILES) / sizeof(double); iter++){
+                                fprintf(output, ", \"%s\": %llu", QUANTILE_NAMES[iter], (unsigned long long)traceQuantile(histogram, TRACE_QUANTILES[iter]));
+                            }
+                            fprintf(output, ", \"max_ns\": %llu", (unsigned long long)histogram->max);
+                        }
+                        //only buckets holding samples, as [low, high, count]
+                        fprintf(output, ", \"buckets\": [");
+                        u_int64_t written = 0;
+                        for (u_int64_t index = 0; index < HISTOGRAM_BUCKETS; index++){
+                            if (0 == histogram->counts[index]){
+                                continue;
+                            }
+                            fprintf(output, "%s[%llu, %llu, %llu]", (0 == written++) ? "" : ", ",
+                                (unsigned long long)bucketLow(index),
+                                (unsigned long long)bucketHigh(index),
+                                (unsigned long long)histogram->counts[index]);
+                        }
+                        fprintf(output, "]}");
+                    }
+                    fprintf(output, "\n  ],\n  \"events\": [");
+                    event_t * events = calloc(TRACE_RING_SIZE, sizeof(event_t));
+                    if (NULL != events){
+                        u_int64_t count = traceEvents(trace, events, TRACE_RING_SIZE);
+                        for (u_int64_t iter = 0; iter < count; iter++){
+                            event_t * event = &events[iter];
+                            fprintf(output, "%s\n    {\"keys\": %llu, \"received_ns\": %llu, \"update_ns\": %llu, \"render_ns\": %llu, \"refresh_ns\": %llu}",
+                                (0 == iter) ? "" : ",",
+                                (unsigned long long)event->keys,
+                                (unsigned long long)event->received,
+                                (unsigned long long)(event->updated - event->received),
+                                (unsigned long long)(event->rendered - event->updated),
+                                (unsigned long long)(event->refreshed - event->rendered));
+                        }
+                        free(events);
+                    }
+                    fprintf(output, "\n  ]\n}\n");
+                    return ferror(output) ? -1 : 0;
+                }
+
+    /*////////////////////////////
+        Private Functions
+    */////////////////////////////
+        /*////////////////////////////
+            Recording Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Trace now
+                    returns monotonic nanoseconds
+            */////////////////////////////
+                static u_int64_t traceNow(){
+                    struct timespec now;
+                    clock_gettime(CLOCK_MONOTONIC, &now);
+                    return (u_int64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+                }
+            /*////////////////////////////
+                Record
+                    counts one sample, constant time and no allocation
+            */////////////////////////////
+                static void record(histogram_t * histogram, u_int64_t value){
+                    histogram->counts[bucketIndex(value)]++;
+                    if ((0 == histogram->count) || (value < histogram->min)){
+                        histogram->min = value;
+                    }
+                    if (value > histogram->max){
+                        histogram->max = value;
+                    }
+                    histogram->count++;
+                    histogram->sum += value;
+                }
+        /*////////////////////////////
+            Bucket Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Bucket index
+                    values below twice the half count get a bucket each, above
+                    that every power of two is split into half count buckets
+                    so the error stays within one part in half count
+            */////////////////////////////
+                static u_int64_t bucketIndex(u_int64_t value){
+                    if (value < 2 * HISTOGRAM_HALF){
+                        return value;
+                    }
+                    u_int64_t shift = (63 - __builtin_clzll(value)) - (HISTOGRAM_SUB_BITS - 1);
+                    return 2 * HISTOGRAM_HALF + (shift - 1) * HISTOGRAM_HALF + ((value >> shift) - HISTOGRAM_HALF);
+                }
+            /*////////////////////////////
+                Bucket low
+                    returns the smallest value counted in a bucket
+            */////////////////////////////
+                static u_int64_t bucketLow(u_int64_t index){
+                    if (index < 2 * HISTOGRAM_HALF){
+                        return index;
+                    }
+                    u_int64_t offset = index - 2 * HISTOGRAM_HALF;
+                    u_int64_t shift = offset / HISTOGRAM_HALF + 1;
+                    return (offset % HISTOGRAM_HALF + HISTOGRAM_HALF) << shift;
+                }
+            /*////////////////////////////
+                Bucket high
+                    returns the largest value counted in a bucket
+            */////////////////////////////
+                static u_int64_t bucketHigh(u_int64_t index){
+                    if (index < 2 * HISTOGRAM_HALF){
+                        return index;
+                    }
+                    u_int64_t offset = index - 2 * HISTOGRAM_HALF;
+                    u_int64_t shift = offset / HISTOGRAM_HALF + 1;
+                    return bucketLow(index) + ((u_int64_t)1 << shift) - 1;
+                }
+//End of file
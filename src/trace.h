@@ -0,0 +1,74 @@
+/*////////////////////////////
+    Guard
+*/////////////////////////////
+    #ifndef TRACE_H
+    #define TRACE_H
+
+/*////////////////////////////
+    Includes
+*/////////////////////////////
+    #include <stdio.h>
+    #include <sys/types.h>
+
+/*////////////////////////////
+    Defines
+*/////////////////////////////
+    #define TRACE_STAGE_UPDATE  0
+    #define TRACE_STAGE_RENDER  1
+    #define TRACE_STAGE_REFRESH 2
+    #define TRACE_STAGE_TOTAL   3
+    #define TRACE_STAGE_COUNT   4
+    #define TRACE_RING_SIZE     4096
+    #define HISTOGRAM_SUB_BITS  6
+    #define HISTOGRAM_HALF      (1 << (HISTOGRAM_SUB_BITS - 1))
+    #define HISTOGRAM_BUCKETS   (2 * HISTOGRAM_HALF + (64 - HISTOGRAM_SUB_BITS) * HISTOGRAM_HALF)
+
+/*////////////////////////////
+    Structs
+*/////////////////////////////
+    struct event{
+        u_int64_t               received;   //monotonic ns the first key of the batch was seen
+        u_int64_t               updated;    //monotonic ns the batch had been applied
+        u_int64_t               rendered;   //monotonic ns the frame had been drawn
+        u_int64_t               refreshed;  //monotonic ns refresh returned
+        u_int64_t               keys;       //keys applied in the batch
+    };
+    struct histogram{
+        u_int64_t               counts[HISTOGRAM_BUCKETS];//samples per log linear bucket
+        u_int64_t               count;      //samples recorded
+        u_int64_t               sum;        //ns of every sample together
+        u_int64_t               min;        //smallest sample
+        u_int64_t               max;        //largest sample
+    };
+    struct trace{
+        struct event            ring[TRACE_RING_SIZE];//newest events, oldest overwritten
+        u_int64_t               head;       //events ever published, stored with release order
+        struct event            pending;    //event of the batch being timed
+        u_int8_t                active;     //a batch is between receipt and refresh
+        struct histogram        stages[TRACE_STAGE_COUNT];//latency of every stage
+    };
+
+/*////////////////////////////
+    Typedefs
+*/////////////////////////////
+    typedef struct event        event_t;
+    typedef struct histogram    histogram_t;
+    typedef struct trace        trace_t;
+
+/*////////////////////////////
+    Prototypes
+*/////////////////////////////
+    //Lifetime
+        void traceInit(trace_t * trace);
+    //Recording
+        void traceReceive(trace_t * trace);
+        void traceUpdate(trace_t * trace, u_int64_t keys);
+        void traceRender(trace_t * trace);
+        void traceRefresh(trace_t * trace);
+    //Reporting
+        u_int64_t traceQuantile(histogram_t * histogram, double quantile);
+        u_int64_t traceEvents(trace_t * trace, event_t * events, u_int64_t max);
+        int traceWrite(trace_t * trace, FILE * output);
+
+    #endif
+//End of file
@@ -0,0 +1,205 @@
+/*////////////////////////////
+    Includes
+*/////////////////////////////
+    #include <string.h>
+    #include <stdlib.h>
+    #include <unistd.h>
+    #include <sys/stat.h>
+    #include <sys/statvfs.h>
+    #include "macros.h"
+    #include "save.h"
+    #include "unpack.h"
+
+/*////////////////////////////
+    Defines
+*/////////////////////////////
+    #define GZIP_WINDOW_BITS    (16 + MAX_WBITS)
+
+/*////////////////////////////
+    Prototypes
+*/////////////////////////////
+    //Inflating
+        static int writeAll(int fd, const unsigned char * data, u_int64_t length);
+        static u_int64_t unpackRoom(unpack_t * unpack);
+
+/*////////////////////////////
+    Globals
+*/////////////////////////////
+    unsigned char GZIP_MAGIC[] =        {0x1f, 0x8b};
+    u_int64_t   UNPACK_RESERVE =        268435456;
+
+/*////////////////////////////
+    Functions
+*/////////////////////////////
+    /*////////////////////////////
+        Public Functions
+    */////////////////////////////
+        /*////////////////////////////
+            Lifetime Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Unpack open
+                    starts inflating a gzip file into an unlinked temporary
+                    file in TMPDIR, reading from a copy of input_fd, the text
+                    is kept there rather than in memory unless TMPDIR is a
+                    tmpfs, so it grows to limit bytes at most
+                    returns 0 on success, 1 when the input is not gzip, -1 on
+                    failure
+            */////////////////////////////
+                int unpackOpen(unpack_t * unpack, int input_fd, u_int64_t limit){
+                    memset(unpack, 0, sizeof(unpack_t));
+                    unpack->input_fd = -1;
+                    unpack->output_fd = -1;
+                    unpack->limit = limit;
+                    unsigned char magic[sizeof(GZIP_MAGIC)];
+                    struct stat input_stat;
+                    if ((0 != fstat(input_fd, &input_stat)) || (!S_ISREG(input_stat.st_mode))){
+                        return 1;
+                    }
+                    if ((sizeof(magic) != pread(input_fd, magic, sizeof(magic), 0)) || (0 != memcmp(magic, GZIP_MAGIC, sizeof(magic)))){
+                        return 1;
+                    }
+                    unpack->input_size = input_stat.st_size;
+                    unpack->input = malloc(UNPACK_CHUNK);
+                    unpack->output = malloc(UNPACK_CHUNK);
+                    unpack->input_fd = dup(input_fd);
+                    unpack->output_fd = saveScratch("cliunpack");
+                    if ((NULL == unpack->input) || (NULL == unpack->output) || (-1 == unpack->input_fd) || (-1 == unpack->output_fd)
+                        || (-1 == lseek(unpack->input_fd, 0, SEEK_SET)) || (Z_OK != inflateInit2(&unpack->stream, GZIP_WINDOW_BITS))){
+                        if (-1 != unpack->output_fd){
+                            close(unpack->output_fd);
+                        }
+                        unpackClose(unpack);
+                        return -1;
+                    }
+                    return 0;
+                }
+            /*////////////////////////////
+                Unpack close
+                    releases the inflater, the temporary file stays open for
+                    whoever maps it
+            */////////////////////////////
+                void unpackClose(unpack_t * unpack){
+                    if (Z_NULL != unpack->stream.state){
+                        inflateEnd(&unpack->stream);
+                    }
+                    if (-1 != unpack->input_fd){
+                        close(unpack->input_fd);
+                        unpack->input_fd = -1;
+                    }
+                    free(unpack->input);
+                    free(unpack->output);
+                    unpack->done = 1;
+                }
+        /*////////////////////////////
+            Inflating Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Unpack step
+                    inflates about budget more bytes of text onto the end of
+                    the temporary file, concatenated members are read as one
+                    and a file cut short ends where its data does, text past
+                    the limit or the space left for it is not written and
+                    sets limited
+                    returns 1 while more remains, 0 once done, -1 when the
+                    data is corrupt or cannot be written
+            */////////////////////////////
+                int unpackStep(unpack_t * unpack, u_int64_t budget){
+                    u_int64_t target = unpack->produced + budget;
+                    u_int64_t room = unpack->produced + unpackRoom(unpack);
+                    while ((!unpack->done) && (unpack->produced < target)){
+                        if (0 == unpack->stream.avail_in){
+                            ssize_t count = read(unpack->input_fd, unpack->input, UNPACK_CHUNK);
+                            if (0 > count){
+                                unpack->done = 1;
+                                return -1;
+                            }
+                            if (0 == count){
+                                unpack->done = 1;
+                                break;
+                            }
+                            unpack->consumed += count;
+                            unpack->stream.next_in = unpack->input;
+                            unpack->stream.avail_in = count;
+                        }
+                        //another member after the end of one starts over
+                        u_int8_t restarted = unpack->ended;
+                        if (unpack->ended){
+                            if (Z_OK != inflateReset(&unpack->stream)){
+                                unpack->done = 1;
+                                return -1;
+                            }
+                            unpack->ended = 0;
+                        }
+                        unpack->stream.next_out = unpack->output;
+                        unpack->stream.avail_out = UNPACK_CHUNK;
+                        int status = inflate(&unpack->stream, Z_NO_FLUSH);
+                        //padding after the last member is ignored as gzip does
+                        if ((restarted) && (Z_DATA_ERROR == status)){
+                            unpack->done = 1;
+                            break;
+                        }
+                        if ((Z_OK != status) && (Z_STREAM_END != status) && ((Z_BUF_ERROR != status) || (0 != unpack->stream.avail_in))){
+                            unpack->done = 1;
+                            return -1;
+                        }
+                        u_int64_t length = UNPACK_CHUNK - unpack->stream.avail_out;
+                        u_int8_t limited = (unpack->produced + length > room);
+                        if (limited){
+                            length = room - unpack->produced;
+                        }
+                        if (0 != writeAll(unpack->output_fd, unpack->output, length)){
+                            unpack->done = 1;
+                            return -1;
+                        }
+                        unpack->produced += length;
+                        if (limited){
+                            unpack->limited = 1;
+                            unpack->done = 1;
+                            return -1;
+                        }
+                        unpack->ended = (Z_STREAM_END == status);
+                    }
+                    return unpack->done ? 0 : 1;
+                }
+
+    /*////////////////////////////
+        Private Functions
+    */////////////////////////////
+        /*////////////////////////////
+            Inflating Functions
+        */////////////////////////////
+            /*////////////////////////////
+                Write all
+                    returns 0 once every byte was written
+            */////////////////////////////
+                static int writeAll(int fd, const unsigned char * data, u_int64_t length){
+                    while (0 < length){
+                        ssize_t count = write(fd, data, length);
+                        if (0 >= count){
+                            return -1;
+                        }
+                        data += count;
+                        length -= count;
+                    }
+                    return 0;
+                }
+            /*////////////////////////////
+                Unpack room
+                    returns the text bytes the temporary file may still take,
+                    up to the limit and leaving UNPACK_RESERVE of its file
+                    system free
+            */////////////////////////////
+                static u_int64_t unpackRoom(unpack_t * unpack){
+                    u_int64_t room = (unpack->limit > unpack->produced) ? unpack->limit - unpack->produced : 0;
+                    struct statvfs space;
+                    if (0 == fstatvfs(unpack->output_fd, &space)){
+                        u_int64_t available = (u_int64_t)space.f_bavail * space.f_frsize;
+                        available = (available > UNPACK_RESERVE) ? available - UNPACK_RESERVE : 0;
+                        if (room > available){
+                            room = available;
+                        }
+                    }
+                    return room;
+                }
+//End of file
@@ -0,0 +1,51 @@
+/*////////////////////////////
+    Guard
+*/////////////////////////////
+    #ifndef UNPACK_H
+    #define UNPACK_H
+
+/*////////////////////////////
+    Includes
+*/////////////////////////////
+    #include <sys/types.h>
+    #include <zlib.h>
+
+/*////////////////////////////
+    Defines
+*/////////////////////////////
+    #define UNPACK_CHUNK        262144
+
+/*////////////////////////////
+    Structs
+*/////////////////////////////
+    struct unpack{
+        z_stream                stream;     //inflater, which points back at itself so it never moves
+        int                     input_fd;   //copy of the compressed file's descriptor
+        int                     output_fd;  //unlinked temporary file in TMPDIR the text is written to, left to the caller
+        unsigned char *         input;      //compressed bytes read ahead of the inflater
+        unsigned char *         output;     //text inflated but not yet written
+        u_int64_t               input_size; //bytes in the compressed file
+        u_int64_t               consumed;   //compressed bytes read
+        u_int64_t               produced;   //text bytes written
+        u_int64_t               limit;      //text bytes the temporary file may grow to
+        u_int8_t                ended;      //the inflater finished a member and wants no more
+        u_int8_t                done;       //no more text will be written
+        u_int8_t                limited;    //stopped at the limit or the space left beside the temporary file
+    };
+
+/*////////////////////////////
+    Typedefs
+*/////////////////////////////
+    typedef struct unpack       unpack_t;
+
+/*////////////////////////////
+    Prototypes
+*/////////////////////////////
+    //Lifetime
+        int unpackOpen(unpack_t * unpack, int input_fd, u_int64_t limit);
+        void unpackClose(unpack_t * unpack);
+    //Inflating
+        int unpackStep(unpack_t * unpack, u_int64_t budget);
+
+    #endif
+//End of file